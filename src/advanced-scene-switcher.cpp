@@ -4,6 +4,7 @@
 
 #include <obs-module.h>
 #include <obs-frontend-api.h>
+#include <util/platform.h>
 
 #include "headers/advanced-scene-switcher.hpp"
 #include "headers/curl-helper.hpp"
@@ -164,7 +165,6 @@ void SwitcherData::Thread()
 		// if a longer transition is used than the configured check interval
 		bool setPrevSceneAfterLinger = false;
 		bool macroMatch = false;
-		macroSceneSwitched = false;
 
 		endTime = std::chrono::high_resolution_clock::now();
 
@@ -184,15 +184,39 @@ void SwitcherData::Thread()
 			}
 		}
 
+		// Wake up early if a timer expires before the next regular check
+		int64_t deadline = nextDeadline.exchange(INT64_MAX);
+		if (deadline != INT64_MAX) {
+			int64_t now = std::chrono::duration_cast<
+					      std::chrono::nanoseconds>(
+					      endTime.time_since_epoch())
+					      .count();
+			// Round up so the timer has expired when waking up
+			auto untilDeadline = std::chrono::milliseconds(
+				std::max<int64_t>(deadline - now + 999999, 0) /
+				1000000);
+			if (untilDeadline < duration) {
+				duration = std::max(untilDeadline,
+						    std::chrono::milliseconds(1));
+			}
+		}
+
 		vblog(LOG_INFO, "try to sleep for %ld", duration.count());
 		setWaitScene();
-		cv.wait_for(lock, duration);
+		if (!checkRequested) {
+			waitingForCheck = true;
+			cv.wait_for(lock, duration);
+			waitingForCheck = false;
+		}
+		checkRequested = false;
 
 		startTime = std::chrono::high_resolution_clock::now();
 		sleep = 0;
 		linger = 0;
 
-		Prune();
+		if (pruneRequested) {
+			Prune();
+		}
 		if (stop) {
 			break;
 		}
@@ -201,6 +225,7 @@ void SwitcherData::Thread()
 		}
 		match = checkForMatch(scene, transition, linger,
 				      setPrevSceneAfterLinger, macroMatch);
+		macroSceneSwitched = false;
 		if (stop) {
 			break;
 		}
@@ -230,6 +255,15 @@ void SwitcherData::Thread()
 			}
 		}
 
+		updateSharedMemoryStatus();
+
+		// Macros requested by external triggers have to be looked up
+		// before unlocking, as the macro index might be rebuilt by the
+		// UI at any time
+		std::vector<Macro *> requestedMacros;
+		getOSCMacroRequests(requestedMacros);
+		processSharedMemoryCommands(requestedMacros);
+
 		// After this point we will call frontend functions
 		// obs_frontend_set_current_scene() and
 		// obs_frontend_set_current_transition()
@@ -245,6 +279,7 @@ void SwitcherData::Thread()
 				switchScene({scene, transition, 0});
 			}
 		}
+		runRequestedMacros(requestedMacros);
 
 		writeSceneInfoToFile();
 	}
@@ -319,13 +354,48 @@ bool SwitcherData::checkForMatch(OBSWeakSource &scene,
 	return match;
 }
 
-void switchScene(const sceneSwitchInfo &sceneSwitch)
+void switchScene(const sceneSwitchInfo &sceneSwitch, bool blocking)
 {
 	if (!sceneSwitch.scene && switcher->verbose) {
 		blog(LOG_INFO, "nothing to switch to");
 		return;
 	}
 
+	SceneSwitchRequest request;
+	request.scene = sceneSwitch.scene;
+	request.transition = sceneSwitch.transition;
+	request.duration = sceneSwitch.duration;
+	request.origin = os_gettime_ns();
+
+	if (switcher->networkConfig.ShouldSynchronizeSceneChange()) {
+		obs_source_t *source =
+			obs_weak_source_get_source(sceneSwitch.scene);
+		obs_source_t *currentSource = obs_frontend_get_current_scene();
+		bool changed = source && source != currentSource;
+		obs_source_release(currentSource);
+		obs_source_release(source);
+		if (!changed) {
+			return;
+		}
+
+		// Give the clients time to receive the message so every
+		// instance including this one can switch at the same time
+		request.time = request.origin +
+			       (uint64_t)switcher->networkConfig.SyncDelay *
+				       1000000;
+		request.forward = false;
+		switcher->server.sendMessage(sceneSwitch, false, request.time);
+		switcher->multicastSender.Send(
+			sceneSwitch, false, switcher->networkConfig.SyncDelay);
+		switcher->switchQueue.Push(request);
+		return;
+	}
+
+	switcher->switchQueue.Push(request, blocking);
+}
+
+void performSceneSwitch(const sceneSwitchInfo &sceneSwitch, bool forward)
+{
 	obs_source_t *source = obs_weak_source_get_source(sceneSwitch.scene);
 	obs_source_t *currentSource = obs_frontend_get_current_scene();
 
@@ -343,8 +413,9 @@ void switchScene(const sceneSwitchInfo &sceneSwitch)
 			blog(LOG_INFO, "switched scene");
 		}
 
-		if (switcher->networkConfig.ShouldSendSceneChange()) {
+		if (forward && switcher->networkConfig.ShouldSendSceneChange()) {
 			switcher->server.sendMessage(sceneSwitch);
+			switcher->multicastSender.Send(sceneSwitch);
 		}
 	}
 	obs_source_release(currentSource);
@@ -377,6 +448,14 @@ void SwitcherData::Start()
 	if (networkConfig.ClientEnabled) {
 		client.connect(networkConfig.GetClientUri());
 	}
+
+	startMulticast();
+	startOSC();
+
+	if (fileIO.sharedMemoryEnabled && sharedMemory.Open()) {
+		updateSharedMemoryScenes();
+		updateSharedMemoryStatus();
+	}
 }
 
 void ResetMacroCounters()
@@ -386,6 +465,22 @@ void ResetMacroCounters()
 	}
 }
 
+static void logSwitchQueueStats()
+{
+	auto stats = switcher->switchQueue.GetStats();
+	if (stats.switches == 0) {
+		return;
+	}
+	blog(LOG_INFO,
+	     "performed %llu scene switches (%llu requests coalesced) - "
+	     "average latency %.3f ms, max %.3f ms",
+	     (unsigned long long)stats.switches,
+	     (unsigned long long)stats.coalesced,
+	     (double)stats.totalLatency / stats.switches / 1000000.,
+	     (double)stats.maxLatency / 1000000.);
+	switcher->switchQueue.ResetStats();
+}
+
 void SwitcherData::Stop()
 {
 	if (th && th->isRunning()) {
@@ -400,8 +495,14 @@ void SwitcherData::Stop()
 		ResetMacroCounters();
 	}
 
+	switchQueue.Cancel();
+	logSwitchQueueStats();
 	server.stop();
 	client.disconnect();
+	multicastSender.Stop();
+	multicastReceiver.Stop();
+	oscListener.Stop();
+	updateSharedMemoryStatus();
 }
 
 void SwitcherData::setWaitScene()
@@ -410,6 +511,30 @@ void SwitcherData::setWaitScene()
 	obs_source_release(waitScene);
 }
 
+void SwitcherData::requestCheck()
+{
+	std::lock_guard<std::mutex> lock(m);
+	checkRequested = true;
+	// Only interrupt the wait for the next check and not other waits like
+	// the linger duration or the wait action
+	if (waitingForCheck) {
+		cv.notify_one();
+	}
+}
+
+void SwitcherData::addDeadline(
+	std::chrono::high_resolution_clock::time_point time)
+{
+	int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			     time.time_since_epoch())
+			     .count();
+	int64_t current = nextDeadline.load(std::memory_order_relaxed);
+	while (ns < current &&
+	       !nextDeadline.compare_exchange_weak(current, ns,
+						   std::memory_order_relaxed)) {
+	}
+}
+
 bool SwitcherData::sceneChangedDuringWait()
 {
 	obs_source_t *currentSource = obs_frontend_get_current_scene();
@@ -423,6 +548,12 @@ bool SwitcherData::sceneChangedDuringWait()
 /******************************************************************************
  * OBS module setup
  ******************************************************************************/
+// Entries referencing a removed source are pruned before the next check
+static void SourceRemoved(void *, calldata_t *)
+{
+	switcher->pruneRequested = true;
+}
+
 extern "C" void FreeSceneSwitcher()
 {
 	if (loaded_curl_lib) {
@@ -434,6 +565,12 @@ extern "C" void FreeSceneSwitcher()
 	}
 
 	PlatformCleanup();
+	// The command watcher might still try to wake up the switcher thread
+	switcher->sharedMemory.Close();
+
+	signal_handler_t *sh = obs_get_signal_handler();
+	signal_handler_disconnect(sh, "source_remove", SourceRemoved, nullptr);
+	signal_handler_disconnect(sh, "source_destroy", SourceRemoved, nullptr);
 
 	delete switcher;
 	switcher = nullptr;
@@ -455,23 +592,45 @@ void handleSceneChange()
 		switcher->previousScene = switcher->previousSceneHelper;
 		switcher->previousSceneHelper = ws;
 	}
+	switcher->updateSharedMemoryScenes();
 
 	switcher->checkTriggers();
 	switcher->checkDefaultSceneTransitions();
 
-	if (switcher->networkConfig.ShouldSendFrontendSceneChange()) {
-		switcher->server.sendMessage({ws, nullptr, 0});
+	forwardFrontendSceneChange(ws, false);
+}
+
+void forwardFrontendSceneChange(obs_weak_source_t *scene, bool preview)
+{
+	if (switcher->applyingUnforwardedSwitch) {
+		return;
 	}
+	auto &config = switcher->networkConfig;
+	if (preview ? !config.ShouldSendPrviewSceneChange()
+		    : !config.ShouldSendFrontendSceneChange()) {
+		return;
+	}
+	switcher->server.sendMessage({scene, nullptr, 0}, preview);
+	switcher->multicastSender.Send({scene, nullptr, 0}, preview);
 }
 
 void setLiveTime()
 {
 	switcher->liveTime = QDateTime::currentDateTime();
+	switcher->timeScheduleChanged = true;
 }
 
 void resetLiveTime()
 {
 	switcher->liveTime = QDateTime();
+	switcher->timeScheduleChanged = true;
+}
+
+// Transitions are private sources, so their removal is not reported by the
+// global source signals
+void handleSourceListChange()
+{
+	switcher->pruneRequested = true;
 }
 
 void checkAutoStartRecording()
@@ -490,10 +649,11 @@ void checkAutoStartStreaming()
 
 void handlePeviewSceneChange()
 {
-	if (switcher->networkConfig.ShouldSendPrviewSceneChange()) {
+	if (!switcher->applyingUnforwardedSwitch &&
+	    switcher->networkConfig.ShouldSendPrviewSceneChange()) {
 		auto source = obs_frontend_get_current_preview_scene();
 		auto weak = obs_source_get_weak_source(source);
-		switcher->server.sendMessage({weak, nullptr, 0}, true);
+		forwardFrontendSceneChange(weak, true);
 		obs_weak_source_release(weak);
 		obs_source_release(source);
 	}
@@ -518,6 +678,11 @@ static void OBSEvent(enum obs_frontend_event event, void *switcher)
 	case OBS_FRONTEND_EVENT_PREVIEW_SCENE_CHANGED:
 		handlePeviewSceneChange();
 		break;
+	case OBS_FRONTEND_EVENT_TRANSITION_LIST_CHANGED:
+	case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED:
+	case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CLEANUP:
+		handleSourceListChange();
+		break;
 	case OBS_FRONTEND_EVENT_RECORDING_STARTED:
 		setLiveTime();
 		checkAutoStartRecording();
@@ -554,12 +719,25 @@ extern "C" void InitSceneSwitcher()
 		QMainWindow *window =
 			(QMainWindow *)obs_frontend_get_main_window();
 
+		{
+			std::lock_guard<std::mutex> lock(switcher->m);
+			switcher->settingsWindowOpened = true;
+		}
 		AdvSceneSwitcher ss(window);
 		ss.exec();
+		{
+			std::lock_guard<std::mutex> lock(switcher->m);
+			switcher->settingsWindowOpened = false;
+			switcher->macroDependenciesChanged = true;
+		}
 	};
 
 	obs_frontend_add_save_callback(SaveSceneSwitcher, nullptr);
 	obs_frontend_add_event_callback(OBSEvent, switcher);
 
+	signal_handler_t *sh = obs_get_signal_handler();
+	signal_handler_connect(sh, "source_remove", SourceRemoved, nullptr);
+	signal_handler_connect(sh, "source_destroy", SourceRemoved, nullptr);
+
 	action->connect(action, &QAction::triggered, cb);
 }
@@ -0,0 +1,333 @@
+#include "headers/audio-level.hpp"
+#include "headers/shared-registry.hpp"
+
+#include <obs-module.h>
+#include <cmath>
+#include <tuple>
+#include <algorithm>
+
+constexpr double pi = 3.14159265358979323846;
+
+AudioLevelMonitor::AudioLevelMonitor(obs_weak_source_t *source)
+	: _source(source)
+{
+	for (auto &s : _samples) {
+		s.peak = -std::numeric_limits<float>::infinity();
+		s.magnitude = -std::numeric_limits<float>::infinity();
+	}
+
+	_volmeter = obs_volmeter_create(OBS_FADER_LOG);
+	obs_volmeter_add_callback(_volmeter, VolmeterCallback, this);
+	obs_source_t *as = obs_weak_source_get_source(source);
+	if (!obs_volmeter_attach_source(_volmeter, as)) {
+		const char *name = obs_source_get_name(as);
+		blog(LOG_WARNING, "failed to attach volmeter to source %s",
+		     name ? name : "");
+	}
+	obs_source_release(as);
+}
+
+AudioLevelMonitor::~AudioLevelMonitor()
+{
+	// Removing the callback will wait for a running callback to finish
+	obs_volmeter_remove_callback(_volmeter, VolmeterCallback, this);
+	obs_volmeter_destroy(_volmeter);
+}
+
+void AudioLevelMonitor::VolmeterCallback(
+	void *data, const float magnitude[MAX_AUDIO_CHANNELS],
+	const float peak[MAX_AUDIO_CHANNELS],
+	const float inputPeak[MAX_AUDIO_CHANNELS])
+{
+	UNUSED_PARAMETER(inputPeak);
+	auto m = static_cast<AudioLevelMonitor *>(data);
+
+	float maxPeak = -std::numeric_limits<float>::infinity();
+	float maxMagnitude = -std::numeric_limits<float>::infinity();
+	for (int i = 0; i < MAX_AUDIO_CHANNELS; i++) {
+		if (peak[i] > maxPeak) {
+			maxPeak = peak[i];
+		}
+		if (magnitude[i] > maxMagnitude) {
+			maxMagnitude = magnitude[i];
+		}
+	}
+
+	// Only the audio thread writes, so no read-modify-write is required
+	uint64_t seq = m->_sequence.load(std::memory_order_relaxed);
+	auto &sample = m->_samples[seq % audio_level_history];
+	sample.peak.store(maxPeak, std::memory_order_relaxed);
+	sample.magnitude.store(maxMagnitude, std::memory_order_relaxed);
+	m->_sequence.store(seq + 1, std::memory_order_release);
+}
+
+uint64_t AudioLevelMonitor::Sequence() const
+{
+	return _sequence.load(std::memory_order_acquire);
+}
+
+AudioLevel AudioLevelMonitor::Read(uint64_t &since) const
+{
+	AudioLevel level;
+	uint64_t end = Sequence();
+	uint64_t start = since;
+	if (end - start > audio_level_history) {
+		start = end - audio_level_history;
+	}
+	since = end;
+
+	double power = 0.;
+	for (uint64_t i = start; i < end; i++) {
+		const auto &sample = _samples[i % audio_level_history];
+		float peak = sample.peak.load(std::memory_order_relaxed);
+		float magnitude =
+			sample.magnitude.load(std::memory_order_relaxed);
+		if (peak > level.peak) {
+			level.peak = peak;
+		}
+		power += std::pow(10., magnitude / 10.);
+		level.count++;
+	}
+
+	if (level.count > 0 && power > 0.) {
+		level.magnitude = (float)(10. * std::log10(power / level.count));
+	}
+	return level;
+}
+
+static SharedRegistry<obs_weak_source_t *, AudioLevelMonitor> monitors;
+
+std::shared_ptr<AudioLevelMonitor>
+GetAudioLevelMonitor(obs_weak_source_t *source)
+{
+	return monitors.Get(source, [source]() {
+		return std::make_shared<AudioLevelMonitor>(source);
+	});
+}
+
+void AudioLevelReader::SetSource(obs_weak_source_t *source)
+{
+	if (_monitor && _monitor->GetSource() == source) {
+		return;
+	}
+	if (!source) {
+		_monitor.reset();
+		return;
+	}
+	_monitor = GetAudioLevelMonitor(source);
+	_sequence = _monitor->Sequence();
+}
+
+AudioLevel AudioLevelReader::Read()
+{
+	if (!_monitor) {
+		return {};
+	}
+	return _monitor->Read(_sequence);
+}
+
+AudioLoudnessMeter::AudioLoudnessMeter(obs_weak_source_t *source,
+				       LoudnessType type, int windowMs)
+	: _source(source), _type(type), _windowMs(std::max(windowMs, 10))
+{
+	_loudness = -std::numeric_limits<float>::infinity();
+
+	audio_t *audio = obs_get_audio();
+	_channels = std::min(audio_output_get_channels(audio),
+			     (size_t)MAX_AUDIO_CHANNELS);
+	uint32_t sampleRate = audio_output_get_sample_rate(audio);
+	_blockFrames = std::max(sampleRate / 100, 1u);
+	_blocks.resize(std::max(_windowMs / 10, 1), 0.);
+	SetupKWeighting(sampleRate);
+
+	obs_source_t *s = obs_weak_source_get_source(source);
+	obs_source_add_audio_capture_callback(s, AudioCallback, this);
+	obs_source_release(s);
+}
+
+AudioLoudnessMeter::~AudioLoudnessMeter()
+{
+	// Removing the callback will wait for a running callback to finish
+	obs_source_t *s = obs_weak_source_get_source(_source);
+	obs_source_remove_audio_capture_callback(s, AudioCallback, this);
+	obs_source_release(s);
+}
+
+float AudioLoudnessMeter::Loudness() const
+{
+	return _loudness.load(std::memory_order_relaxed);
+}
+
+// K-weighting filter coefficients for arbitrary sample rates as derived in
+// libebur128
+void AudioLoudnessMeter::SetupKWeighting(double sampleRate)
+{
+	double f0 = 1681.974450955533;
+	double G = 3.999843853973347;
+	double Q = 0.7071752369554196;
+	double K = std::tan(pi * f0 / sampleRate);
+	double Vh = std::pow(10.0, G / 20.0);
+	double Vb = std::pow(Vh, 0.4996667741545416);
+	double a0 = 1.0 + K / Q + K * K;
+
+	_shelf.b[0] = (Vh + Vb * K / Q + K * K) / a0;
+	_shelf.b[1] = 2.0 * (K * K - Vh) / a0;
+	_shelf.b[2] = (Vh - Vb * K / Q + K * K) / a0;
+	_shelf.a[1] = 2.0 * (K * K - 1.0) / a0;
+	_shelf.a[2] = (1.0 - K / Q + K * K) / a0;
+
+	f0 = 38.13547087602444;
+	Q = 0.5003270373238773;
+	K = std::tan(pi * f0 / sampleRate);
+	a0 = 1.0 + K / Q + K * K;
+
+	_highPass.b[0] = 1.0;
+	_highPass.b[1] = -2.0;
+	_highPass.b[2] = 1.0;
+	_highPass.a[1] = 2.0 * (K * K - 1.0) / a0;
+	_highPass.a[2] = (1.0 - K / Q + K * K) / a0;
+}
+
+void AudioLoudnessMeter::AudioCallback(void *param, obs_source_t *source,
+				       const struct audio_data *audio,
+				       bool muted)
+{
+	auto meter = static_cast<AudioLoudnessMeter *>(param);
+	float mul = muted ? 0.f : obs_source_get_volume(source);
+	meter->Process(audio, mul);
+}
+
+static inline double sumOfSquares(const float *data, uint32_t frames, float mul)
+{
+	// Independent partial sums allow the compiler to vectorize this loop
+	float partial[8] = {};
+	uint32_t i = 0;
+	for (; i + 8 <= frames; i += 8) {
+		for (int j = 0; j < 8; j++) {
+			float v = data[i + j] * mul;
+			partial[j] += v * v;
+		}
+	}
+	double sum = 0.;
+	for (int j = 0; j < 8; j++) {
+		sum += partial[j];
+	}
+	for (; i < frames; i++) {
+		float v = data[i] * mul;
+		sum += v * v;
+	}
+	return sum;
+}
+
+static inline double kWeightedSumOfSquares(const float *data, uint32_t frames,
+					   float mul, const double *shelfB,
+					   const double *shelfA,
+					   const double *hpB, const double *hpA,
+					   double *state)
+{
+	double sum = 0.;
+	for (uint32_t i = 0; i < frames; i++) {
+		double x = data[i] * mul;
+		double y = shelfB[0] * x + state[0];
+		state[0] = shelfB[1] * x - shelfA[1] * y + state[1];
+		state[1] = shelfB[2] * x - shelfA[2] * y;
+
+		double z = hpB[0] * y + state[2];
+		state[2] = hpB[1] * y - hpA[1] * z + state[3];
+		state[3] = hpB[2] * y - hpA[2] * z;
+		sum += z * z;
+	}
+	return sum;
+}
+
+void AudioLoudnessMeter::Process(const struct audio_data *audio, float mul)
+{
+	uint32_t pos = 0;
+	while (pos < audio->frames) {
+		uint32_t frames =
+			std::min(audio->frames - pos, _blockFrames - _blockPos);
+
+		for (size_t c = 0; c < _channels; c++) {
+			if (!audio->data[c]) {
+				continue;
+			}
+			auto data = reinterpret_cast<const float *>(
+					    audio->data[c]) +
+				    pos;
+			if (_type == LoudnessType::LUFS) {
+				_channelEnergy[c] += kWeightedSumOfSquares(
+					data, frames, mul, _shelf.b, _shelf.a,
+					_highPass.b, _highPass.a,
+					_filterState[c]);
+			} else {
+				_channelEnergy[c] +=
+					sumOfSquares(data, frames, mul);
+			}
+		}
+
+		pos += frames;
+		_blockPos += frames;
+		if (_blockPos == _blockFrames) {
+			FinishBlock();
+		}
+	}
+}
+
+void AudioLoudnessMeter::FinishBlock()
+{
+	double energy = 0.;
+	for (size_t c = 0; c < _channels; c++) {
+		// The LFE channel is excluded from loudness measurements
+		if (!(_type == LoudnessType::LUFS && _channels >= 6 && c == 3)) {
+			energy += _channelEnergy[c] / _blockFrames;
+		}
+		_channelEnergy[c] = 0.;
+	}
+	_blockPos = 0;
+
+	// RMS is averaged over channels while loudness sums the channels
+	if (_type == LoudnessType::RMS && _channels > 0) {
+		energy /= _channels;
+	}
+
+	_windowSum += energy - _blocks[_blockIdx];
+	_blocks[_blockIdx] = energy;
+	_blockIdx = (_blockIdx + 1) % _blocks.size();
+	if (_blocksFilled < _blocks.size()) {
+		_blocksFilled++;
+	}
+
+	// Recalculate the sum regularly to avoid accumulating rounding errors
+	if (_blockIdx == 0) {
+		_windowSum = 0.;
+		for (auto b : _blocks) {
+			_windowSum += b;
+		}
+	}
+
+	double mean = _windowSum / _blocksFilled;
+	float level = -std::numeric_limits<float>::infinity();
+	if (mean > 0.) {
+		level = (float)(10. * std::log10(mean));
+		if (_type == LoudnessType::LUFS) {
+			level -= 0.691f;
+		}
+	}
+	_loudness.store(level, std::memory_order_relaxed);
+}
+
+static SharedRegistry<std::tuple<obs_weak_source_t *, LoudnessType, int>,
+		      AudioLoudnessMeter>
+	loudnessMeters;
+
+std::shared_ptr<AudioLoudnessMeter>
+GetAudioLoudnessMeter(obs_weak_source_t *source, LoudnessType type,
+		      int windowMs)
+{
+	return loudnessMeters.Get(
+		std::make_tuple(source, type, windowMs),
+		[source, type, windowMs]() {
+			return std::make_shared<AudioLoudnessMeter>(
+				source, type, windowMs);
+		});
+}
@@ -0,0 +1,256 @@
+#include "headers/audio-spectrum.hpp"
+#include "headers/shared-registry.hpp"
+
+#include <obs-module.h>
+#include <cmath>
+#include <algorithm>
+
+constexpr double pi = 3.14159265358979323846;
+// Time constant of the spectrum and voice activity smoothing in seconds
+constexpr double smoothing_time = 0.1;
+// Frequency range containing most of the energy of speech
+constexpr double voice_low_hz = 300.;
+constexpr double voice_high_hz = 3400.;
+// Frames quieter than this mean square amplitude (-60dBFS) never count as
+// speech
+constexpr double voice_min_power = 1e-6;
+
+FFT::FFT(size_t size) : _size(size)
+{
+	size_t bits = 0;
+	while (((size_t)1 << bits) < size) {
+		bits++;
+	}
+
+	_bitReverse.resize(size);
+	for (size_t i = 0; i < size; i++) {
+		uint32_t r = 0;
+		for (size_t b = 0; b < bits; b++) {
+			if (i & ((size_t)1 << b)) {
+				r |= 1u << (bits - 1 - b);
+			}
+		}
+		_bitReverse[i] = r;
+	}
+
+	_cos.resize(size / 2);
+	_sin.resize(size / 2);
+	for (size_t i = 0; i < size / 2; i++) {
+		_cos[i] = (float)std::cos(2. * pi * i / size);
+		_sin[i] = (float)-std::sin(2. * pi * i / size);
+	}
+}
+
+void FFT::Transform(float *re, float *im) const
+{
+	for (size_t i = 0; i < _size; i++) {
+		size_t j = _bitReverse[i];
+		if (i < j) {
+			std::swap(re[i], re[j]);
+			std::swap(im[i], im[j]);
+		}
+	}
+
+	for (size_t len = 2; len <= _size; len <<= 1) {
+		const size_t half = len / 2;
+		const size_t step = _size / len;
+		for (size_t start = 0; start < _size; start += len) {
+			float *re0 = re + start;
+			float *im0 = im + start;
+			float *re1 = re0 + half;
+			float *im1 = im0 + half;
+			for (size_t k = 0; k < half; k++) {
+				const float wr = _cos[k * step];
+				const float wi = _sin[k * step];
+				const float tr = re1[k] * wr - im1[k] * wi;
+				const float ti = re1[k] * wi + im1[k] * wr;
+				re1[k] = re0[k] - tr;
+				im1[k] = im0[k] - ti;
+				re0[k] += tr;
+				im0[k] += ti;
+			}
+		}
+	}
+}
+
+AudioSpectrumAnalyzer::AudioSpectrumAnalyzer(obs_weak_source_t *source)
+	: AudioSpectrumAnalyzer(audio_output_get_channels(obs_get_audio()),
+				audio_output_get_sample_rate(obs_get_audio()))
+{
+	_source = source;
+	obs_source_t *s = obs_weak_source_get_source(source);
+	obs_source_add_audio_capture_callback(s, AudioCallback, this);
+	obs_source_release(s);
+}
+
+AudioSpectrumAnalyzer::AudioSpectrumAnalyzer(size_t channels,
+					     double sampleRate)
+	: _channels(std::min(channels, (size_t)MAX_AUDIO_CHANNELS)),
+	  _sampleRate(sampleRate),
+	  _fft(spectrum_fft_size)
+{
+	const size_t bins = spectrum_fft_size / 2 + 1;
+	_window.resize(spectrum_fft_size);
+	double windowPower = 0.;
+	for (size_t i = 0; i < _window.size(); i++) {
+		_window[i] = (float)(0.5 - 0.5 * std::cos(2. * pi * i /
+							  spectrum_fft_size));
+		windowPower += (double)_window[i] * _window[i];
+	}
+	_powerScale = 1. / (spectrum_fft_size * windowPower);
+
+	_input.resize(spectrum_fft_size, 0.f);
+	_re.resize(spectrum_fft_size);
+	_im.resize(spectrum_fft_size);
+	_power.resize(bins, 0.f);
+	_spectrum.resize(bins, 0.f);
+}
+
+AudioSpectrumAnalyzer::~AudioSpectrumAnalyzer()
+{
+	if (!_source) {
+		return;
+	}
+	// Removing the callback will wait for a running callback to finish
+	obs_source_t *s = obs_weak_source_get_source(_source);
+	obs_source_remove_audio_capture_callback(s, AudioCallback, this);
+	obs_source_release(s);
+}
+
+void AudioSpectrumAnalyzer::AudioCallback(void *param, obs_source_t *source,
+					  const struct audio_data *audio,
+					  bool muted)
+{
+	auto analyzer = static_cast<AudioSpectrumAnalyzer *>(param);
+	float mul = muted ? 0.f : obs_source_get_volume(source);
+	analyzer->Process(audio, mul);
+}
+
+void AudioSpectrumAnalyzer::Process(const struct audio_data *audio, float mul)
+{
+	const float *data[MAX_AUDIO_CHANNELS];
+	size_t channels = 0;
+	for (size_t c = 0; c < _channels; c++) {
+		if (audio->data[c]) {
+			data[channels++] =
+				reinterpret_cast<const float *>(audio->data[c]);
+		}
+	}
+	if (channels == 0) {
+		return;
+	}
+	mul /= channels;
+
+	for (uint32_t i = 0; i < audio->frames; i++) {
+		float sample = 0.f;
+		for (size_t c = 0; c < channels; c++) {
+			sample += data[c][i];
+		}
+		_input[_inputPos] = sample * mul;
+		_inputPos = (_inputPos + 1) % spectrum_fft_size;
+		if (++_inputFilled == spectrum_hop_size) {
+			_inputFilled = 0;
+			AnalyzeFrame();
+		}
+	}
+}
+
+void AudioSpectrumAnalyzer::AnalyzeFrame()
+{
+	// _inputPos points to the oldest sample of the ring buffer
+	const size_t tail = spectrum_fft_size - _inputPos;
+	for (size_t i = 0; i < tail; i++) {
+		_re[i] = _input[_inputPos + i] * _window[i];
+	}
+	for (size_t i = tail; i < spectrum_fft_size; i++) {
+		_re[i] = _input[i - tail] * _window[i];
+	}
+	std::fill(_im.begin(), _im.end(), 0.f);
+	_fft.Transform(_re.data(), _im.data());
+
+	const double alpha = std::exp(-spectrum_hop_size /
+				      (_sampleRate * smoothing_time));
+	const double binWidth = _sampleRate / spectrum_fft_size;
+	const size_t bins = _power.size();
+
+	double total = 0.;
+	double voice = 0.;
+	double logSum = 0.;
+	size_t voiceBins = 0;
+	for (size_t k = 0; k < bins; k++) {
+		double p = ((double)_re[k] * _re[k] + (double)_im[k] * _im[k]) *
+			   _powerScale;
+		// Fold the negative frequencies into the one-sided spectrum
+		if (k != 0 && k != bins - 1) {
+			p *= 2.;
+		}
+		_power[k] = (float)(alpha * _power[k] + (1. - alpha) * p);
+
+		if (k == 0) {
+			continue;
+		}
+		total += p;
+		double freq = k * binWidth;
+		if (freq >= voice_low_hz && freq <= voice_high_hz) {
+			voice += p;
+			logSum += std::log(p + 1e-20);
+			voiceBins++;
+		}
+	}
+
+	// Speech concentrates its energy in the voice band and, unlike noise,
+	// has a distinct harmonic structure, so its spectrum is far from flat
+	double score = 0.;
+	if (total > voice_min_power && voiceBins > 0 && voice > 0.) {
+		double flatness = std::exp(logSum / voiceBins) /
+				  (voice / voiceBins);
+		score = voice / total * (1. - std::min(flatness, 1.));
+	}
+	_voice = (float)(alpha * _voice + (1. - alpha) * score);
+	_voiceActivity.store(_voice, std::memory_order_relaxed);
+
+	if (_mtx.try_lock()) {
+		std::copy(_power.begin(), _power.end(), _spectrum.begin());
+		_mtx.unlock();
+	}
+}
+
+float AudioSpectrumAnalyzer::BandLevel(double lowHz, double highHz)
+{
+	if (lowHz > highHz) {
+		std::swap(lowHz, highHz);
+	}
+	const double binWidth = _sampleRate / spectrum_fft_size;
+	const size_t last = _spectrum.size() - 1;
+	size_t low = std::min((size_t)std::max(std::lround(lowHz / binWidth), 0l),
+			      last);
+	size_t high = std::min(
+		(size_t)std::max(std::lround(highHz / binWidth), 0l), last);
+
+	double power = 0.;
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		for (size_t k = low; k <= high; k++) {
+			power += _spectrum[k];
+		}
+	}
+	if (power <= 0.) {
+		return -std::numeric_limits<float>::infinity();
+	}
+	return (float)(10. * std::log10(power));
+}
+
+float AudioSpectrumAnalyzer::VoiceActivity() const
+{
+	return _voiceActivity.load(std::memory_order_relaxed);
+}
+
+static SharedRegistry<obs_weak_source_t *, AudioSpectrumAnalyzer> analyzers;
+
+std::shared_ptr<AudioSpectrumAnalyzer>
+GetAudioSpectrumAnalyzer(obs_weak_source_t *source)
+{
+	return analyzers.Get(source, [source]() {
+		return std::make_shared<AudioSpectrumAnalyzer>(source);
+	});
+}
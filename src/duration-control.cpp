@@ -1,8 +1,10 @@
 #include "headers/duration-control.hpp"
+#include "headers/advanced-scene-switcher.hpp"
 #include "headers/utility.hpp"
 #include "obs-module.h"
 
 #include <sstream>
+#include <cmath>
 #include <iomanip>
 #include <QHBoxLayout>
 
@@ -29,7 +31,13 @@ bool Duration::DurationReached()
 
 	auto runTime = std::chrono::duration_cast<std::chrono::milliseconds>(
 		std::chrono::high_resolution_clock::now() - _startTime);
-	return runTime.count() >= seconds * 1000;
+	if (runTime.count() >= seconds * 1000) {
+		return true;
+	}
+	switcher->addDeadline(_startTime +
+			      std::chrono::milliseconds((int64_t)std::ceil(
+				      seconds * 1000)));
+	return false;
 }
 
 double Duration::TimeRemaining()
@@ -409,6 +409,7 @@ void SwitcherData::loadSettings(obs_data_t *obj)
 		return;
 	}
 
+	pruneRequested = true;
 	loadSceneGroups(obj);
 	loadMacros(obj);
 	loadWindowTitleSwitches(obj);
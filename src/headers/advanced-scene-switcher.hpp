@@ -47,6 +47,7 @@ public:
 	bool addNewMacro(std::string &name);
 	Macro *getSelectedMacro();
 	void SetEditMacro(Macro &m);
+	void updateMacroGroupWidgets(Macro &m);
 
 	void loadUI();
 	void setupGeneralTab();
@@ -103,6 +104,11 @@ public slots:
 	void on_macroUp_clicked();
 	void on_macroDown_clicked();
 	void on_macroName_editingFinished();
+	void on_macroTriggerMode_currentIndexChanged(int idx);
+	void on_macroRepeatInterval_valueChanged(double value);
+	void on_macroGroup_editingFinished();
+	void on_macroGroupPaused_stateChanged(int state);
+	void on_macroGroupExclusive_stateChanged(int state);
 	void on_macros_currentRowChanged(int idx);
 	void on_macros_itemChanged(QListWidgetItem *);
 	void on_conditionAdd_clicked();
@@ -160,6 +166,7 @@ public slots:
 	void on_readFileCheckBox_stateChanged(int state);
 	void on_readPathLineEdit_textChanged(const QString &text);
 	void on_writePathLineEdit_textChanged(const QString &text);
+	void on_sharedMemoryCheckBox_stateChanged(int state);
 	void on_browseButton_2_clicked();
 
 	void on_executableUp_clicked();
@@ -214,8 +221,22 @@ public slots:
 	void on_sendSceneChange_stateChanged(int state);
 	void on_restrictSend_stateChanged(int state);
 	void on_sendPreview_stateChanged(int state);
+	void on_coalesceInterval_valueChanged(int value);
+	void on_syncSwitch_stateChanged(int state);
+	void on_syncDelay_valueChanged(int value);
 	void on_clientReconnect_clicked();
 	void updateClientStatus();
+	void on_multicastSettings_toggled(bool on);
+	void on_multicastAddress_textChanged(const QString &text);
+	void on_multicastPort_valueChanged(int value);
+	void on_multicastSend_stateChanged(int state);
+	void on_multicastReceive_stateChanged(int state);
+	void on_multicastRestart_clicked();
+	void updateMulticastStatus();
+	void on_oscSettings_toggled(bool on);
+	void on_oscPort_valueChanged(int value);
+	void on_oscRestart_clicked();
+	void updateOSCStatus();
 
 	void on_sceneGroupAdd_clicked();
 	void on_sceneGroupRemove_clicked();
@@ -255,8 +276,17 @@ void setNextTransition(const sceneSwitchInfo &ssi, obs_source_t *currentSource,
 void overwriteTransitionOverride(const sceneSwitchInfo &ssi,
 				 transitionData &td);
 void restoreTransitionOverride(obs_source_t *scene, const transitionData &td);
-void switchScene(const sceneSwitchInfo &ssi);
+// Queues the switch to be performed by the switch queue thread.
+// If blocking is set this function returns once the switch was performed.
+// If synchronized network switches are enabled the switch is scheduled so
+// all connected instances switch at the same time.
+void switchScene(const sceneSwitchInfo &ssi, bool blocking = true);
+// Performs the switch immediately - only used by the switch queue
+void performSceneSwitch(const sceneSwitchInfo &ssi, bool forward);
 void switchPreviewScene(const OBSWeakSource &ws);
+// Informs network clients about a scene change reported by the frontend
+// unless it was caused by a switch which must not be forwarded
+void forwardFrontendSceneChange(obs_weak_source_t *scene, bool preview);
 
 /******************************************************************************
  * Main SwitcherData
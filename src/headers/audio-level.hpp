@@ -0,0 +1,138 @@
+#pragma once
+#include <obs.hpp>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <vector>
+
+// Number of volmeter updates kept per source.
+// At the default audio settings OBS reports levels about every 20ms, so this
+// covers roughly five seconds.
+constexpr auto audio_level_history = 256;
+
+struct AudioLevel {
+	// Highest peak in dBFS
+	float peak = -std::numeric_limits<float>::infinity();
+	// RMS level in dBFS
+	float magnitude = -std::numeric_limits<float>::infinity();
+	// Number of volmeter updates the values are based on
+	int count = 0;
+};
+
+// Owns the single volmeter attached to a given source.
+//
+// The volmeter callback runs on the audio thread and only stores the
+// reported levels in a ring buffer and publishes a new sequence number.
+// Readers never modify the monitor, so any number of consumers can
+// evaluate their own window of levels without synchronizing with each
+// other or with the audio thread.
+//
+// Use GetAudioLevelMonitor() to get the monitor shared by all consumers of
+// a given source.
+class AudioLevelMonitor {
+public:
+	AudioLevelMonitor(obs_weak_source_t *source);
+	~AudioLevelMonitor();
+
+	obs_weak_source_t *GetSource() { return _source; }
+	uint64_t Sequence() const;
+	// Combines all levels reported after sequence number since
+	// and sets since to the current sequence number
+	AudioLevel Read(uint64_t &since) const;
+
+private:
+	static void VolmeterCallback(void *data,
+				     const float magnitude[MAX_AUDIO_CHANNELS],
+				     const float peak[MAX_AUDIO_CHANNELS],
+				     const float inputPeak[MAX_AUDIO_CHANNELS]);
+
+	struct Sample {
+		std::atomic<float> peak;
+		std::atomic<float> magnitude;
+	};
+
+	OBSWeakSource _source;
+	obs_volmeter_t *_volmeter = nullptr;
+	Sample _samples[audio_level_history];
+	std::atomic<uint64_t> _sequence = {0};
+};
+
+std::shared_ptr<AudioLevelMonitor>
+GetAudioLevelMonitor(obs_weak_source_t *source);
+
+// Per consumer view of the levels of a source.
+// Each call to Read() returns the levels reported since the previous call.
+class AudioLevelReader {
+public:
+	void SetSource(obs_weak_source_t *source);
+	AudioLevel Read();
+
+private:
+	std::shared_ptr<AudioLevelMonitor> _monitor;
+	uint64_t _sequence = 0;
+};
+
+enum class LoudnessType {
+	RMS,
+	// K-weighted loudness according to ITU-R BS.1770 (without gating)
+	LUFS,
+};
+
+constexpr auto default_loudness_window = 400;
+
+// Computes the RMS level or the loudness of a source over a sliding window
+// directly from the audio capture callback.
+//
+// The audio is accumulated in blocks of 10ms and the level of the window is
+// updated after each completed block, so readers only have to load a single
+// precomputed value.
+//
+// Use GetAudioLoudnessMeter() to get the meter shared by all consumers of a
+// given source, type and window length.
+class AudioLoudnessMeter {
+public:
+	AudioLoudnessMeter(obs_weak_source_t *source, LoudnessType type,
+			   int windowMs);
+	~AudioLoudnessMeter();
+
+	obs_weak_source_t *GetSource() { return _source; }
+	LoudnessType GetType() { return _type; }
+	int GetWindow() { return _windowMs; }
+	// Level in dBFS or LUFS
+	float Loudness() const;
+
+private:
+	static void AudioCallback(void *param, obs_source_t *source,
+				  const struct audio_data *audio, bool muted);
+	void Process(const struct audio_data *audio, float mul);
+	void FinishBlock();
+	void SetupKWeighting(double sampleRate);
+
+	struct Biquad {
+		double b[3] = {1., 0., 0.};
+		double a[3] = {1., 0., 0.};
+	};
+
+	OBSWeakSource _source;
+	LoudnessType _type;
+	int _windowMs;
+	size_t _channels = 0;
+	uint32_t _blockFrames = 0;
+
+	// Only accessed from the audio thread
+	uint32_t _blockPos = 0;
+	double _channelEnergy[MAX_AUDIO_CHANNELS] = {};
+	std::vector<double> _blocks;
+	size_t _blockIdx = 0;
+	size_t _blocksFilled = 0;
+	double _windowSum = 0.;
+	Biquad _shelf;
+	Biquad _highPass;
+	double _filterState[MAX_AUDIO_CHANNELS][4] = {};
+
+	std::atomic<float> _loudness;
+};
+
+std::shared_ptr<AudioLoudnessMeter>
+GetAudioLoudnessMeter(obs_weak_source_t *source, LoudnessType type,
+		      int windowMs);
@@ -0,0 +1,88 @@
+#pragma once
+#include <obs.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Number of samples per analyzed frame and the distance between the start of
+// two consecutive frames.
+// At 48kHz this results in a resolution of about 47Hz and about 94 updates
+// per second.
+constexpr auto spectrum_fft_size = 1024;
+constexpr auto spectrum_hop_size = spectrum_fft_size / 2;
+
+// In-place radix-2 FFT on separate real and imaginary arrays.
+// All tables are computed once in the constructor, so Transform() does not
+// allocate and its inner loop works on contiguous float arrays.
+class FFT {
+public:
+	FFT(size_t size);
+	size_t Size() const { return _size; }
+	void Transform(float *re, float *im) const;
+
+private:
+	size_t _size;
+	std::vector<uint32_t> _bitReverse;
+	std::vector<float> _cos;
+	std::vector<float> _sin;
+};
+
+// Continuously analyzes the spectrum of a source from the audio capture
+// callback.
+//
+// All channels are mixed down to mono and a Hann windowed FFT is computed
+// every spectrum_hop_size samples.
+// The power spectrum is smoothed over time so readers can query the energy
+// of arbitrary frequency bands without having to process the audio
+// themselves.
+//
+// Use GetAudioSpectrumAnalyzer() to get the analyzer shared by all consumers
+// of a given source.
+class AudioSpectrumAnalyzer {
+public:
+	AudioSpectrumAnalyzer(obs_weak_source_t *source);
+	// Analyzer which is not attached to any source and only analyzes the
+	// audio passed to Process()
+	AudioSpectrumAnalyzer(size_t channels, double sampleRate);
+	~AudioSpectrumAnalyzer();
+
+	obs_weak_source_t *GetSource() { return _source; }
+	// Expects planar float audio
+	void Process(const struct audio_data *audio, float mul);
+	// RMS level of the given frequency band in dBFS
+	float BandLevel(double lowHz, double highHz);
+	// Likelihood in range 0 - 1 that the audio currently contains speech
+	float VoiceActivity() const;
+
+private:
+	static void AudioCallback(void *param, obs_source_t *source,
+				  const struct audio_data *audio, bool muted);
+	void AnalyzeFrame();
+
+	OBSWeakSource _source;
+	size_t _channels = 0;
+	double _sampleRate = 0.;
+	FFT _fft;
+	std::vector<float> _window;
+	// Normalizes the summed power of the bins to the mean square amplitude
+	double _powerScale = 1.;
+
+	// Only accessed from the audio thread
+	std::vector<float> _input;
+	size_t _inputPos = 0;
+	size_t _inputFilled = 0;
+	std::vector<float> _re;
+	std::vector<float> _im;
+	std::vector<float> _power;
+	float _voice = 0.f;
+
+	// Published results, updated with try_lock so the audio thread is never
+	// blocked by readers
+	std::mutex _mtx;
+	std::vector<float> _spectrum;
+	std::atomic<float> _voiceActivity = {0.f};
+};
+
+std::shared_ptr<AudioSpectrumAnalyzer>
+GetAudioSpectrumAnalyzer(obs_weak_source_t *source);
@@ -0,0 +1,67 @@
+#pragma once
+#include <QImage>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+typedef uint64_t ImageHash;
+
+// Computes a 64 bit difference hash (dHash) of the given image.
+//
+// The image is reduced to a 9x8 grid of average luminance values and each
+// bit of the hash encodes whether a cell is brighter than its right
+// neighbour.
+// Visually similar images will result in hashes with a small Hamming
+// distance regardless of their resolution.
+ImageHash ComputeImageHash(const QImage &image);
+int HashDistance(ImageHash a, ImageHash b);
+
+// BK-tree indexing hashes by Hamming distance, so the closest entry can be
+// found without comparing against every entry
+class ImageHashIndex {
+public:
+	void Add(ImageHash hash, size_t value);
+	// Returns false if no entry is within maxDistance of hash.
+	// Otherwise values contains the values of all entries sharing the
+	// closest hash.
+	bool FindClosest(ImageHash hash, int maxDistance,
+			 std::vector<size_t> &values, int &distance) const;
+	size_t Size() const { return _size; }
+
+private:
+	struct Node {
+		ImageHash hash;
+		std::vector<size_t> values;
+		// Pairs of distance to this node and index of child node
+		std::vector<std::pair<int, size_t>> children;
+	};
+	std::vector<Node> _nodes;
+	size_t _size = 0;
+};
+
+// Hashes of all images found in a folder.
+//
+// Libraries are cached per folder and shared between all conditions using
+// the same folder, so each reference image is only loaded and hashed once.
+class ReferenceImageLibrary {
+public:
+	ReferenceImageLibrary(const std::string &folder);
+
+	const std::string &Folder() const { return _folder; }
+	const std::vector<std::string> &Names() const { return _names; }
+	// Returns the names of the closest reference images, which are
+	// multiple if several images have the same hash, or an empty list if no
+	// reference image is within maxDistance of the given hash
+	std::vector<std::string> Lookup(ImageHash hash, int maxDistance,
+					int *distance = nullptr) const;
+
+private:
+	std::string _folder;
+	std::vector<std::string> _names;
+	ImageHashIndex _index;
+};
+
+std::shared_ptr<ReferenceImageLibrary>
+GetReferenceImageLibrary(const std::string &folder, bool reload = false);
@@ -0,0 +1,24 @@
+#pragma once
+#include <QImage>
+#include <cstdint>
+
+constexpr int image_stats_histogram_bins = 32;
+// Upper bound of pixels sampled per image
+constexpr int image_stats_max_samples = 128 * 72;
+
+struct ImageStats {
+	bool valid = false;
+	// Per channel average in range 0 - 255
+	double mean[3] = {0., 0., 0.};
+	double luminance = 0.;
+	double luminanceVariance = 0.;
+	// Normalized luminance histogram
+	float histogram[image_stats_histogram_bins] = {};
+};
+
+// Computes statistics on a regularly spaced subset of the pixels of image,
+// so the cost stays constant regardless of the source resolution.
+ImageStats ComputeImageStats(const QImage &image,
+			     int maxSamples = image_stats_max_samples);
+// Returns a value between 0 (identical) and 1 (disjoint)
+double HistogramDistance(const ImageStats &a, const ImageStats &b);
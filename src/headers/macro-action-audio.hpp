@@ -1,12 +1,16 @@
 #pragma once
 #include <QSpinBox>
 #include "macro-action-edit.hpp"
+#include "duration-control.hpp"
+#include "volume-fader.hpp"
 
 enum class AudioAction {
 	MUTE,
 	UNMUTE,
 	SOURCE_VOLUME,
 	MASTER_VOLUME,
+	SOURCE_VOLUME_FADE,
+	MASTER_VOLUME_FADE,
 };
 
 class MacroActionAudio : public MacroAction {
@@ -24,6 +28,8 @@ public:
 	OBSWeakSource _audioSource;
 	AudioAction _action = AudioAction::MUTE;
 	int _volume = 0;
+	Duration _fadeDuration;
+	FadeCurve _fadeCurve = FadeCurve::LINEAR;
 
 private:
 	static bool _registered;
@@ -51,11 +57,17 @@ private slots:
 	void SourceChanged(const QString &text);
 	void ActionChanged(int value);
 	void VolumeChanged(int value);
+	void FadeDurationChanged(double value);
+	void FadeDurationUnitChanged(DurationUnit unit);
+	void FadeCurveChanged(int value);
 
 protected:
 	QComboBox *_audioSources;
 	QComboBox *_actions;
 	QSpinBox *_volumePercent;
+	DurationSelection *_fadeDuration;
+	QComboBox *_fadeCurve;
+	QWidget *_fadeSettings;
 	std::shared_ptr<MacroActionAudio> _entryData;
 
 private:
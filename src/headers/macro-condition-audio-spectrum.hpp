@@ -0,0 +1,88 @@
+#pragma once
+#include "macro.hpp"
+#include "audio-spectrum.hpp"
+
+#include <QWidget>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QSpinBox>
+
+// Telephone voice band
+constexpr auto default_band_low_freq = 300;
+constexpr auto default_band_high_freq = 3400;
+constexpr auto default_band_level = -30.;
+constexpr auto default_voice_threshold = 50.;
+
+enum class AudioSpectrumCondition {
+	BAND_ABOVE,
+	BAND_BELOW,
+	VOICE_ABOVE,
+	VOICE_BELOW,
+};
+
+class MacroConditionAudioSpectrum : public MacroCondition {
+public:
+	bool CheckCondition();
+	bool Save(obs_data_t *obj);
+	bool Load(obs_data_t *obj);
+	std::string GetId() { return id; };
+	static std::shared_ptr<MacroCondition> Create()
+	{
+		return std::make_shared<MacroConditionAudioSpectrum>();
+	}
+	void ResetAnalyzer();
+
+	OBSWeakSource _audioSource;
+	AudioSpectrumCondition _condition = AudioSpectrumCondition::BAND_ABOVE;
+	int _lowFreq = default_band_low_freq;
+	int _highFreq = default_band_high_freq;
+	// Band level in dBFS
+	double _level = default_band_level;
+	// Voice activity in percent
+	double _voiceThreshold = default_voice_threshold;
+
+private:
+	std::shared_ptr<AudioSpectrumAnalyzer> _analyzer;
+	static bool _registered;
+	static const std::string id;
+};
+
+class MacroConditionAudioSpectrumEdit : public QWidget {
+	Q_OBJECT
+
+public:
+	MacroConditionAudioSpectrumEdit(
+		QWidget *parent,
+		std::shared_ptr<MacroConditionAudioSpectrum> cond = nullptr);
+	void UpdateEntryData();
+	static QWidget *Create(QWidget *parent,
+			       std::shared_ptr<MacroCondition> cond)
+	{
+		return new MacroConditionAudioSpectrumEdit(
+			parent, std::dynamic_pointer_cast<
+					MacroConditionAudioSpectrum>(cond));
+	}
+
+private slots:
+	void SourceChanged(const QString &text);
+	void ConditionChanged(int cond);
+	void LowFreqChanged(int value);
+	void HighFreqChanged(int value);
+	void LevelChanged(double value);
+	void VoiceThresholdChanged(double value);
+
+protected:
+	QComboBox *_audioSources;
+	QComboBox *_condition;
+	QSpinBox *_lowFreq;
+	QSpinBox *_highFreq;
+	QDoubleSpinBox *_level;
+	QDoubleSpinBox *_voiceThreshold;
+	QWidget *_bandSettings;
+	std::shared_ptr<MacroConditionAudioSpectrum> _entryData;
+
+private:
+	void SetWidgetVisibility();
+
+	bool _loading = true;
+};
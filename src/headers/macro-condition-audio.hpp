@@ -1,9 +1,10 @@
 #pragma once
 #include "macro.hpp"
 #include "volume-control.hpp"
-#include <limits>
+#include "audio-level.hpp"
 #include <QWidget>
 #include <QComboBox>
+#include <QDoubleSpinBox>
 #include <chrono>
 
 enum class AudioCondition {
@@ -11,9 +12,15 @@ enum class AudioCondition {
 	BELOW,
 };
 
+enum class AudioMeasurement {
+	// Volmeter peak mapped to the volume slider range
+	VOLUME,
+	RMS,
+	LUFS,
+};
+
 class MacroConditionAudio : public MacroCondition {
 public:
-	~MacroConditionAudio();
 	bool CheckCondition();
 	bool Save(obs_data_t *obj);
 	bool Load(obs_data_t *obj);
@@ -22,19 +29,19 @@ public:
 	{
 		return std::make_shared<MacroConditionAudio>();
 	}
-	static void SetVolumeLevel(void *data,
-				   const float magnitude[MAX_AUDIO_CHANNELS],
-				   const float peak[MAX_AUDIO_CHANNELS],
-				   const float inputPeak[MAX_AUDIO_CHANNELS]);
 	void ResetVolmeter();
 
 	OBSWeakSource _audioSource;
 	int _volume = 0;
 	AudioCondition _condition = AudioCondition::ABOVE;
-	obs_volmeter_t *_volmeter = nullptr;
+	AudioMeasurement _measurement = AudioMeasurement::VOLUME;
+	// Threshold in dBFS or LUFS used for RMS and LUFS measurements
+	double _threshold = -20.;
+	int _window = default_loudness_window;
 
 private:
-	float _peak = -std::numeric_limits<float>::infinity();
+	AudioLevelReader _audioLevel;
+	std::shared_ptr<AudioLoudnessMeter> _loudnessMeter;
 	static bool _registered;
 	static const std::string id;
 };
@@ -60,14 +67,23 @@ private slots:
 	void SourceChanged(const QString &text);
 	void VolumeThresholdChanged(int vol);
 	void ConditionChanged(int cond);
+	void MeasurementChanged(int value);
+	void ThresholdChanged(double value);
+	void WindowChanged();
 
 protected:
 	QComboBox *_audioSources;
 	QComboBox *_condition;
 	QSpinBox *_volume;
+	QComboBox *_measurement;
+	QDoubleSpinBox *_threshold;
+	QSpinBox *_window;
+	QWidget *_windowSettings;
 	VolControl *_volMeter = nullptr;
 	std::shared_ptr<MacroConditionAudio> _entryData;
 
 private:
+	void SetWidgetVisibility();
+
 	bool _loading = true;
 };
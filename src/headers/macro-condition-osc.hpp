@@ -0,0 +1,56 @@
+#pragma once
+#include "macro.hpp"
+#include <QWidget>
+#include <QLineEdit>
+
+class MacroConditionOSC : public MacroCondition {
+public:
+	MacroConditionOSC();
+	bool CheckCondition();
+	bool Save(obs_data_t *obj);
+	bool Load(obs_data_t *obj);
+	std::string GetId() { return id; };
+	static std::shared_ptr<MacroCondition> Create()
+	{
+		return std::make_shared<MacroConditionOSC>();
+	}
+
+	// OSC address or address pattern
+	std::string _address = "/advss/trigger";
+	// Text representation of the first argument or empty to match any
+	std::string _value;
+
+private:
+	// Sequence number of the last OSC message which was checked
+	uint64_t _sequence = 0;
+	static bool _registered;
+	static const std::string id;
+};
+
+class MacroConditionOSCEdit : public QWidget {
+	Q_OBJECT
+
+public:
+	MacroConditionOSCEdit(QWidget *parent,
+			      std::shared_ptr<MacroConditionOSC> cond = nullptr);
+	void UpdateEntryData();
+	static QWidget *Create(QWidget *parent,
+			       std::shared_ptr<MacroCondition> cond)
+	{
+		return new MacroConditionOSCEdit(
+			parent,
+			std::dynamic_pointer_cast<MacroConditionOSC>(cond));
+	}
+
+private slots:
+	void AddressChanged();
+	void ValueChanged();
+
+protected:
+	QLineEdit *_address;
+	QLineEdit *_value;
+	std::shared_ptr<MacroConditionOSC> _entryData;
+
+private:
+	bool _loading = true;
+};
@@ -9,6 +9,7 @@ public:
 	bool Save(obs_data_t *obj);
 	bool Load(obs_data_t *obj);
 	std::string GetId() { return id; };
+	bool IsStateless() { return true; }
 	static std::shared_ptr<MacroCondition> Create()
 	{
 		return std::make_shared<MacroConditionProcess>();
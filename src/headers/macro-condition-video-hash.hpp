@@ -0,0 +1,77 @@
+#pragma once
+#include "macro.hpp"
+#include "screenshot-helper.hpp"
+#include "image-hash.hpp"
+
+#include <QWidget>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+
+constexpr auto default_hash_distance = 10;
+
+class MacroConditionVideoHash : public MacroCondition {
+public:
+	bool CheckCondition();
+	bool Save(obs_data_t *obj);
+	bool Load(obs_data_t *obj);
+	std::string GetId() { return id; };
+	static std::shared_ptr<MacroCondition> Create()
+	{
+		return std::make_shared<MacroConditionVideoHash>();
+	}
+	void ResetFrameGrabber();
+	void SetLibrary(std::shared_ptr<ReferenceImageLibrary> library);
+	std::shared_ptr<ReferenceImageLibrary> GetLibrary() { return _library; }
+
+	OBSWeakSource _videoSource;
+	std::string _folder = obs_module_text("AdvSceneSwitcher.enterPath");
+	// Empty to match any of the reference images
+	std::string _reference = "";
+	int _maxDistance = default_hash_distance;
+
+private:
+	AdvSSFrameReader _frameReader;
+	std::shared_ptr<ReferenceImageLibrary> _library;
+	bool _lastMatch = false;
+	static bool _registered;
+	static const std::string id;
+};
+
+class MacroConditionVideoHashEdit : public QWidget {
+	Q_OBJECT
+
+public:
+	MacroConditionVideoHashEdit(
+		QWidget *parent,
+		std::shared_ptr<MacroConditionVideoHash> cond = nullptr);
+	void UpdateEntryData();
+	static QWidget *Create(QWidget *parent,
+			       std::shared_ptr<MacroCondition> cond)
+	{
+		return new MacroConditionVideoHashEdit(
+			parent, std::dynamic_pointer_cast<
+					MacroConditionVideoHash>(cond));
+	}
+
+private slots:
+	void SourceChanged(const QString &text);
+	void FolderChanged();
+	void BrowseButtonClicked();
+	void ReferenceChanged(int idx);
+	void MaxDistanceChanged(int value);
+
+protected:
+	QComboBox *_videoSelection;
+	QLineEdit *_folder;
+	QPushButton *_browseButton;
+	QComboBox *_reference;
+	QSpinBox *_maxDistance;
+	std::shared_ptr<MacroConditionVideoHash> _entryData;
+
+private:
+	void PopulateReferenceSelection();
+
+	bool _loading = true;
+};
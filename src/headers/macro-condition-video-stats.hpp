@@ -0,0 +1,88 @@
+#pragma once
+#include "macro.hpp"
+#include "screenshot-helper.hpp"
+#include "image-stats.hpp"
+
+#include <QWidget>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QColor>
+
+enum class VideoStatsCondition {
+	BRIGHTNESS_ABOVE,
+	BRIGHTNESS_BELOW,
+	// Luminance standard deviation below threshold (e.g. black or solid)
+	UNIFORM,
+	COLOR_SIMILAR,
+	// Histogram distance to the previous frame
+	CHANGED_MORE,
+	CHANGED_LESS,
+};
+
+class MacroConditionVideoStats : public MacroCondition {
+public:
+	bool CheckCondition();
+	bool Save(obs_data_t *obj);
+	bool Load(obs_data_t *obj);
+	std::string GetId() { return id; };
+	static std::shared_ptr<MacroCondition> Create()
+	{
+		return std::make_shared<MacroConditionVideoStats>();
+	}
+	void ResetFrameGrabber();
+
+	OBSWeakSource _videoSource;
+	VideoStatsCondition _condition = VideoStatsCondition::BRIGHTNESS_BELOW;
+	// Percentage in range 0 - 100
+	double _value = 5.;
+	QColor _color = QColor(0, 255, 0);
+	int _sampleInterval = default_frame_grab_interval;
+
+private:
+	bool Compare(const ImageStats &stats);
+
+	AdvSSFrameReader _frameReader;
+	bool _lastMatch = false;
+	ImageStats _previousStats;
+	static bool _registered;
+	static const std::string id;
+};
+
+class MacroConditionVideoStatsEdit : public QWidget {
+	Q_OBJECT
+
+public:
+	MacroConditionVideoStatsEdit(
+		QWidget *parent,
+		std::shared_ptr<MacroConditionVideoStats> cond = nullptr);
+	void UpdateEntryData();
+	static QWidget *Create(QWidget *parent,
+			       std::shared_ptr<MacroCondition> cond)
+	{
+		return new MacroConditionVideoStatsEdit(
+			parent, std::dynamic_pointer_cast<
+					MacroConditionVideoStats>(cond));
+	}
+
+private slots:
+	void SourceChanged(const QString &text);
+	void ConditionChanged(int cond);
+	void ValueChanged(double value);
+	void ColorButtonClicked();
+	void SampleIntervalChanged(int value);
+
+protected:
+	QComboBox *_videoSelection;
+	QComboBox *_condition;
+	QDoubleSpinBox *_value;
+	QPushButton *_color;
+	QSpinBox *_sampleInterval;
+	std::shared_ptr<MacroConditionVideoStats> _entryData;
+
+private:
+	void UpdateColorButton();
+
+	bool _loading = true;
+};
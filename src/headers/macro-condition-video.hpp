@@ -1,9 +1,13 @@
 #pragma once
 #include "macro.hpp"
 #include "screenshot-helper.hpp"
+#include "template-match.hpp"
 
 #include <QWidget>
 #include <QComboBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
 #include <chrono>
 
 enum class VideoCondition {
@@ -12,6 +16,7 @@ enum class VideoCondition {
 	HAS_NOT_CHANGED,
 	HAS_CHANGED,
 	NO_IMAGE,
+	PATTERN,
 };
 
 class MacroConditionVideo : public MacroCondition {
@@ -25,18 +30,25 @@ public:
 	{
 		return std::make_shared<MacroConditionVideo>();
 	}
-	void GetScreenshot();
+	void ResetFrameGrabber();
 	bool LoadImageFromFile();
 
 	OBSWeakSource _videoSource;
 	VideoCondition _condition = VideoCondition::MATCH;
 	std::string _file = obs_module_text("AdvSceneSwitcher.enterPath");
+	int _sampleInterval = default_frame_grab_interval;
+	// Minimum normalized cross-correlation for pattern matches
+	double _patternThreshold = 0.8;
+	bool _useRegion = false;
+	QRect _region = {0, 0, 100, 100};
 
 private:
-	bool Compare();
+	bool Compare(const QImage &frame);
 
-	std::unique_ptr<AdvSSScreenshotObj> _screenshotData = nullptr;
+	AdvSSFrameReader _frameReader;
+	bool _lastMatch = false;
 	QImage _matchImage;
+	TemplateMatcher _patternMatcher;
 	static bool _registered;
 	static const std::string id;
 };
@@ -65,14 +77,28 @@ private slots:
 	void ConditionChanged(int cond);
 	void FilePathChanged();
 	void BrowseButtonClicked();
+	void SampleIntervalChanged(int value);
+	void PatternThresholdChanged(double value);
+	void UseRegionChanged(int state);
+	void RegionChanged();
 
 protected:
 	QComboBox *_videoSelection;
 	QComboBox *_condition;
 	QLineEdit *_filePath;
 	QPushButton *_browseButton;
+	QSpinBox *_sampleInterval;
+	QWidget *_patternSettings;
+	QDoubleSpinBox *_patternThreshold;
+	QCheckBox *_useRegion;
+	QSpinBox *_regionX;
+	QSpinBox *_regionY;
+	QSpinBox *_regionW;
+	QSpinBox *_regionH;
 	std::shared_ptr<MacroConditionVideo> _entryData;
 
 private:
+	void SetWidgetVisibility();
+
 	bool _loading = true;
 };
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <deque>
+#include <vector>
+#include <chrono>
 #include <memory>
 #include <map>
 #include <obs.hpp>
@@ -42,6 +44,12 @@ public:
 	virtual bool Save(obs_data_t *obj) = 0;
 	virtual bool Load(obs_data_t *obj) = 0;
 	virtual std::string GetId() = 0;
+	// Conditions whose result only depends on their settings and not on
+	// any previous checks can share their result with identical
+	// conditions of other macros within the same interval
+	virtual bool IsStateless() { return false; }
+	size_t GetSettingsHash() { return _settingsHash; }
+	void UpdateSettingsHash();
 
 	LogicType GetLogicType() { return _logic; }
 	void SetLogicType(LogicType logic) { _logic = logic; }
@@ -58,6 +66,7 @@ public:
 private:
 	LogicType _logic;
 	DurationConstraint _duration;
+	size_t _settingsHash = 0;
 };
 
 class MacroAction {
@@ -69,18 +78,56 @@ public:
 	virtual void LogAction();
 };
 
+// Controls how often the actions of a macro are run while its conditions
+// keep matching
+enum class MacroTriggerMode {
+	// Run the actions on every interval the conditions match
+	ALWAYS,
+	// Run the actions only once each time the conditions start matching
+	RISING_EDGE,
+	// Run the actions while the conditions match, but at most once per
+	// repeat interval
+	REPEAT_INTERVAL,
+	// Run the actions once each time the conditions start matching and
+	// whenever the results of the individual conditions change while
+	// matching
+	ON_CHANGE,
+};
+
+struct MacroGroup {
+	// Skip checking the conditions of all macros of the group
+	bool paused = false;
+	// Stop checking the remaining macros of the group once one matched
+	bool exclusive = false;
+	// Only used while checking the macros
+	bool matched = false;
+};
+
 class Macro {
 public:
 	Macro(const std::string &name = "");
 	virtual ~Macro();
 
 	bool CeckMatch();
+	// Returns if the actions have to be run according to the trigger mode
+	// and assumes they are run if true is returned
+	bool ShouldRunActions();
 	bool PerformAction();
 	bool Matched() { return _matched; }
+	// Used for macros which are skipped while checking conditions
+	void ResetMatch();
+	// Unique for the lifetime of the plugin and kept when renaming
+	uint64_t Id() { return _id; }
 	std::string Name() { return _name; }
 	void SetName(const std::string &name);
+	const std::string &Group() { return _group; }
+	void SetGroup(const std::string &group) { _group = group; }
 	void SetPaused(bool pause = true) { _paused = pause; }
 	bool Paused() { return _paused; }
+	MacroTriggerMode GetTriggerMode() { return _triggerMode; }
+	void SetTriggerMode(MacroTriggerMode mode);
+	Duration GetRepeatInterval() { return _repeatInterval; }
+	void SetRepeatInterval(double seconds);
 	int GetCount() { return _count; };
 	void ResetCount() { _count = 0; };
 	std::deque<std::shared_ptr<MacroCondition>> &Conditions()
@@ -103,11 +150,23 @@ private:
 	void ClearHotkeys();
 	void SetHotkeysDesc();
 
+	uint64_t _id = 0;
 	std::string _name = "";
+	std::string _group = "";
 	std::deque<std::shared_ptr<MacroCondition>> _conditions;
 	std::deque<std::shared_ptr<MacroAction>> _actions;
 	bool _matched = false;
 	bool _paused = false;
+
+	MacroTriggerMode _triggerMode = MacroTriggerMode::ALWAYS;
+	Duration _repeatInterval;
+	// Set once the actions were triggered and cleared when the
+	// conditions no longer match
+	bool _triggered = false;
+	std::chrono::high_resolution_clock::time_point _lastRun;
+	std::vector<bool> _conditionResults;
+	std::vector<bool> _lastRunConditionResults;
+
 	int _count = 0;
 	obs_hotkey_id _pauseHotkey = OBS_INVALID_HOTKEY_ID;
 	obs_hotkey_id _unpauseHotkey = OBS_INVALID_HOTKEY_ID;
@@ -116,6 +175,10 @@ private:
 Macro *GetMacroByName(const char *name);
 Macro *GetMacroByQString(const QString &name);
 
+// Handle to a macro which stays valid when macros are reordered, renamed or
+// removed.
+// The cached pointer is only used as long as the macro index was not
+// updated in the meantime and is looked up again by id otherwise.
 class MacroRef {
 public:
 	MacroRef(){};
@@ -130,7 +193,9 @@ public:
 
 private:
 	std::string _name = "";
+	uint64_t _id = 0;
 	Macro *_ref = nullptr;
+	uint64_t _generation = 0;
 };
 
 class MacroRefCondition : public MacroCondition {
@@ -0,0 +1,116 @@
+#pragma once
+#include <asio.hpp>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+struct OSCArgument {
+	// OSC type tag of the argument
+	char type = 0;
+	int64_t i = 0;
+	double f = 0.;
+	// Points into the parsed packet
+	const char *s = nullptr;
+};
+
+// Read-only view of a single OSC message.
+// Parsing does not copy or allocate - all pointers refer to the packet buffer
+// passed to Parse(), which has to outlive this object.
+class OSCMessage {
+public:
+	bool Parse(const uint8_t *data, size_t size);
+	const char *Address() const { return _address; }
+	// Type tags without the leading ','
+	const char *Types() const { return _types; }
+	size_t ArgCount() const { return _argCount; }
+	bool GetArg(size_t idx, OSCArgument &arg) const;
+	// Writes the argument as text to buf
+	void FormatArg(size_t idx, char *buf, size_t size) const;
+
+private:
+	const char *_address = nullptr;
+	const char *_types = "";
+	size_t _argCount = 0;
+	const uint8_t *_args = nullptr;
+	const uint8_t *_end = nullptr;
+};
+
+typedef void (*OSCMessageHandler)(const OSCMessage &message, void *param);
+
+// Calls handler for each message within the given OSC packet, which can
+// either be a single message or a (nested) bundle
+bool ParseOSCPacket(const uint8_t *data, size_t size,
+		    OSCMessageHandler handler, void *param);
+
+// OSC 1.0 address pattern matching supporting '?', '*', '[]' and '{}'
+bool OSCPatternMatch(const char *pattern, const char *address);
+
+constexpr size_t osc_max_address_length = 128;
+constexpr size_t osc_max_value_length = 128;
+// Number of received messages kept for the OSC macro condition
+constexpr size_t osc_message_history = 256;
+// Number of pending /advss/macro requests
+constexpr size_t osc_max_macro_requests = 16;
+
+struct OSCMessageRecord {
+	char address[osc_max_address_length] = {};
+	// First argument formatted as text
+	char value[osc_max_value_length] = {};
+};
+
+// Receives OSC messages via UDP on its own thread.
+//
+// Supported addresses:
+//  /advss/scene <scene> [transition] [duration in ms]
+//    Switches to the given scene immediately
+//  /advss/preview <scene>
+//    Sets the preview scene
+//  /advss/macro <macro>
+//    Runs the actions of the given macro
+//
+// All messages are also stored for the OSC macro condition and wake up the
+// switcher thread so macros are checked without waiting for the next
+// interval.
+class OSCListener {
+public:
+	~OSCListener();
+	bool Start(uint16_t port);
+	void Stop();
+	bool IsRunning() { return _running; }
+	uint64_t GetReceived() { return _received; }
+
+	// Sequence number of the most recently received message
+	uint64_t Sequence();
+	// Copies the message with the given sequence number to record if it is
+	// still available
+	bool GetMessage(uint64_t seq, OSCMessageRecord &record);
+	// Removes and returns the name of a macro requested via /advss/macro
+	bool PopMacroRequest(char *name, size_t size);
+
+private:
+	void Receive();
+	static void HandleMessage(const OSCMessage &message, void *param);
+
+	asio::io_context _io;
+	std::unique_ptr<asio::ip::udp::socket> _socket;
+	asio::ip::udp::endpoint _senderEndpoint;
+	uint8_t _buffer[65536];
+	std::thread _thread;
+	std::atomic_bool _running = {false};
+	std::atomic<uint64_t> _received = {0};
+	// Set if any message of the current packet requires a check of the
+	// macro conditions
+	bool _wakeSwitcher = false;
+
+	std::mutex _mtx;
+	// Protected by _mtx
+	OSCMessageRecord _messages[osc_message_history];
+	uint64_t _sequence = 0;
+	char _macroRequests[osc_max_macro_requests][osc_max_address_length] = {};
+	size_t _macroRequestStart = 0;
+	size_t _macroRequestCount = 0;
+};
+
@@ -0,0 +1,114 @@
+#pragma once
+#include <random>
+#include <vector>
+
+// Draws weighted random indices using Vose's alias method.
+//
+// The alias table is only rebuilt when the weights are changed, so each draw
+// takes constant time and does not allocate.
+// Indices returned within the last "no repeat window" draws are avoided as
+// long as any other eligible index is left.
+class RandomSelector {
+public:
+	RandomSelector();
+
+	template<typename GetWeight>
+	void SetWeights(size_t count, GetWeight getWeight);
+	size_t Size() const { return _weights.size(); }
+	void SetNoRepeatWindow(size_t size);
+	// Returns -1 if no eligible index with a positive weight exists
+	template<typename Eligible> int Draw(Eligible eligible);
+
+private:
+	void Build();
+	size_t AliasDraw();
+	bool RecentlyDrawn(size_t idx) const;
+	void Remember(size_t idx);
+	template<typename Eligible>
+	int ScanDraw(Eligible &eligible, bool avoidRecent);
+
+	std::mt19937 _rng;
+	std::uniform_real_distribution<double> _uniform{0., 1.};
+
+	std::vector<double> _weights;
+	std::vector<double> _probability;
+	std::vector<size_t> _alias;
+	double _totalWeight = 0.;
+
+	std::vector<size_t> _recent;
+	size_t _recentCount = 0;
+	size_t _recentPos = 0;
+};
+
+// Rejected draws are retried this often before falling back to a linear scan
+constexpr int max_random_draw_attempts = 16;
+
+template<typename GetWeight>
+void RandomSelector::SetWeights(size_t count, GetWeight getWeight)
+{
+	_weights.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		double weight = getWeight(i);
+		_weights[i] = weight > 0. ? weight : 0.;
+	}
+	_recentCount = 0;
+	Build();
+}
+
+template<typename Eligible> int RandomSelector::Draw(Eligible eligible)
+{
+	if (_totalWeight <= 0.) {
+		return -1;
+	}
+
+	for (int i = 0; i < max_random_draw_attempts; i++) {
+		size_t idx = AliasDraw();
+		if (_weights[idx] > 0. && !RecentlyDrawn(idx) && eligible(idx)) {
+			Remember(idx);
+			return (int)idx;
+		}
+	}
+
+	// Most of the weight is currently excluded
+	int idx = ScanDraw(eligible, true);
+	if (idx == -1) {
+		idx = ScanDraw(eligible, false);
+	}
+	if (idx != -1) {
+		Remember(idx);
+	}
+	return idx;
+}
+
+template<typename Eligible>
+int RandomSelector::ScanDraw(Eligible &eligible, bool avoidRecent)
+{
+	auto usable = [&](size_t i) {
+		return _weights[i] > 0. && !(avoidRecent && RecentlyDrawn(i)) &&
+		       eligible(i);
+	};
+
+	double total = 0.;
+	int last = -1;
+	for (size_t i = 0; i < _weights.size(); i++) {
+		if (usable(i)) {
+			total += _weights[i];
+			last = (int)i;
+		}
+	}
+	if (last == -1) {
+		return -1;
+	}
+
+	double r = _uniform(_rng) * total;
+	for (size_t i = 0; i < _weights.size(); i++) {
+		if (!usable(i)) {
+			continue;
+		}
+		r -= _weights[i];
+		if (r < 0.) {
+			return (int)i;
+		}
+	}
+	return last;
+}
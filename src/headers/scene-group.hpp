@@ -10,6 +10,8 @@
 #include <QCheckBox>
 #include <obs.hpp>
 
+#include "random-selection.hpp"
+
 auto constexpr invalid_scene_group_name = "invalid-scene-group";
 
 enum class AdvanceCondition {
@@ -37,7 +39,7 @@ struct SceneGroup {
 
 	int currentCount = -1;
 	std::chrono::high_resolution_clock::time_point lastAdvTime;
-	int lastRandomScene = -1;
+	RandomSelector randomSelector;
 
 	inline SceneGroup(){};
 	inline SceneGroup(const std::string &name_) : name(name_){};
@@ -0,0 +1,71 @@
+#pragma once
+#include <obs.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+struct SceneSwitchRequest {
+	OBSWeakSource scene;
+	OBSWeakSource transition;
+	int duration = 0;
+	bool preview = false;
+	// Inform connected network clients after switching
+	bool forward = true;
+	// os_gettime_ns() at which the switch was requested
+	uint64_t origin = 0;
+	// os_gettime_ns() at which the switch should be performed or 0 to
+	// switch as soon as possible
+	uint64_t time = 0;
+};
+
+struct SceneSwitchStats {
+	uint64_t switches = 0;
+	// Requests replaced by a newer request before they were performed
+	uint64_t coalesced = 0;
+	// Time between the request (or its scheduled time) and the completed
+	// switch
+	uint64_t totalLatency = 0;
+	uint64_t maxLatency = 0;
+};
+
+// All scene and preview switches are performed by a single thread.
+//
+// Only the most recent pending scene and preview switch request is kept, so
+// a burst of requests results in a single switch instead of starting a
+// transition for each of them.
+class SceneSwitchQueue {
+public:
+	~SceneSwitchQueue();
+	// If wait is set this function returns once the request was performed
+	// or replaced by a newer one
+	void Push(const SceneSwitchRequest &request, bool wait = false);
+	void Cancel();
+	SceneSwitchStats GetStats();
+	void ResetStats();
+	// Performs the requests using the given function instead of the
+	// frontend, which is not available in the tools.
+	// Has to be set before the first request is pushed.
+	void SetPerformer(std::function<void(const SceneSwitchRequest &)>);
+
+private:
+	void Thread();
+	void Perform(const SceneSwitchRequest &request);
+
+	std::thread _thread;
+	std::mutex _mtx;
+	std::condition_variable _cv;
+	std::condition_variable _doneCv;
+	bool _stop = false;
+
+	bool _scenePending = false;
+	SceneSwitchRequest _scene;
+	uint64_t _sceneSeq = 0;
+	uint64_t _sceneDone = 0;
+
+	bool _previewPending = false;
+	SceneSwitchRequest _preview;
+
+	SceneSwitchStats _stats;
+	std::function<void(const SceneSwitchRequest &)> _performer;
+};
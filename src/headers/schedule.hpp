@@ -0,0 +1,69 @@
+#pragma once
+#include <QDateTime>
+#include <bitset>
+#include <queue>
+#include <string>
+#include <vector>
+
+// Cron like recurrence rule.
+//
+// Expressions consist of five fields "minute hour day-of-month month
+// day-of-week" or six fields with an additional leading seconds field.
+// Each field is either "*", a value, a range "a-b" or a comma separated list
+// of those, each optionally followed by a step "/n".
+// Sunday can be specified as either 0 or 7 in the day-of-week field.
+// If both day fields are restricted, which means neither of them starts with
+// "*", a day matching either of them matches.
+class CronSchedule {
+public:
+	bool Parse(const std::string &expression);
+	bool Valid() const { return _valid; }
+	// Returns the first occurrence strictly after the given time or an
+	// invalid QDateTime if there is none
+	QDateTime Next(const QDateTime &after) const;
+
+private:
+	bool DayMatches(const QDate &date) const;
+	bool FindTime(int &hour, int &minute, int &second) const;
+
+	std::bitset<60> _seconds;
+	std::bitset<60> _minutes;
+	std::bitset<24> _hours;
+	std::bitset<32> _days;
+	std::bitset<13> _months;
+	std::bitset<7> _weekdays;
+	bool _anyDay = true;
+	bool _anyWeekday = true;
+	bool _valid = false;
+};
+
+// Keeps the next occurrence of a set of scheduled entries sorted by time.
+//
+// Entries are identified by an index chosen by the caller.
+// If multiple entries are due at the same time the one with the lowest index
+// is returned first.
+class ScheduleEngine {
+public:
+	void Clear();
+	bool Empty() const { return _queue.empty(); }
+	// Time is given in milliseconds since the epoch
+	void Add(size_t id, qint64 time);
+	// Removes the next entry which is due at or before now
+	bool PopDue(qint64 now, size_t &id, qint64 &time);
+	// Time of the next entry or -1 if no entry is scheduled
+	qint64 NextTime() const;
+
+private:
+	struct Entry {
+		qint64 time;
+		size_t id;
+		bool operator>(const Entry &other) const
+		{
+			return time > other.time ||
+			       (time == other.time && id > other.id);
+		}
+	};
+
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>
+		_queue;
+};
@@ -3,6 +3,11 @@
 #include <string>
 #include <QImage>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <map>
+#include <typeindex>
 
 class AdvSSScreenshotObj {
 public:
@@ -27,3 +32,114 @@ public:
 	bool done = false;
 	std::chrono::high_resolution_clock::time_point time;
 };
+
+constexpr auto default_frame_grab_interval = 100;
+
+// A single frame as published by AdvSSFrameGrabber.
+// Frames are immutable and shared between all consumers.
+struct AdvSSFrame {
+	QImage image;
+	uint64_t id = 0;
+	std::chrono::high_resolution_clock::time_point time;
+
+	// Values derived from the image, see GetFrameValue()
+	mutable std::mutex valuesMtx;
+	mutable std::map<std::type_index, std::shared_ptr<const void>> values;
+};
+
+// Returns a value derived from the image of a frame.
+//
+// As frames are shared by all consumers of a source each value is only
+// computed once per frame, no matter how many consumers request it.
+// Values are identified by their type, so each type must always be computed
+// the same way.
+template<typename T, typename Compute>
+const T &GetFrameValue(const AdvSSFrame &frame, Compute compute)
+{
+	std::lock_guard<std::mutex> lock(frame.valuesMtx);
+	auto &value = frame.values[std::type_index(typeid(T))];
+	if (!value) {
+		value = std::make_shared<const T>(compute(frame.image));
+	}
+	return *static_cast<const T *>(value.get());
+}
+
+// Continuously grabs frames of a single source (or the main output if no
+// source is set) from within the OBS tick callback.
+//
+// Rendering, staging and mapping are pipelined across two staging surfaces,
+// so a frame rendered in one sample is read back in the next sample without
+// stalling on the GPU.
+// Graphics resources are only recreated if the source dimensions change.
+//
+// Use GetFrameGrabber() to get the grabber shared by all consumers of a
+// given source.
+// Each returned pointer subscribes with its own sample interval, which is
+// withdrawn once that pointer and all of its copies are released.
+class AdvSSFrameGrabber {
+public:
+	AdvSSFrameGrabber(obs_weak_source_t *source);
+	~AdvSSFrameGrabber();
+
+	// Returns the most recent frame or nullptr if none is available yet
+	std::shared_ptr<const AdvSSFrame> GetFrame();
+	// Frames are grabbed at the fastest rate requested by any subscriber
+	size_t AddSubscriber(int interval);
+	void RemoveSubscriber(size_t id);
+	int GetInterval() { return _interval; }
+	obs_weak_source_t *GetSource() { return _weakSource; }
+
+	void Tick(float seconds);
+
+private:
+	void UpdateInterval();
+	bool UpdateSize();
+	void Render(OBSSource &source);
+	void Publish(gs_stagesurf_t *surf);
+	void PublishEmpty();
+	void FreeGraphicsData();
+
+	OBSWeakSource _weakSource;
+	std::atomic_int _interval = {default_frame_grab_interval};
+	std::mutex _subscriberMtx;
+	std::map<size_t, int> _subscriberIntervals;
+	size_t _nextSubscriber = 0;
+	float _elapsed = 0.f;
+
+	uint32_t _cx = 0;
+	uint32_t _cy = 0;
+	gs_texrender_t *_texrender = nullptr;
+	gs_stagesurf_t *_stagesurfs[2] = {nullptr, nullptr};
+	int _currentSurf = 0;
+	bool _staged = false;
+
+	std::mutex _mtx;
+	std::shared_ptr<const AdvSSFrame> _frame;
+	uint64_t _frameCount = 0;
+};
+
+std::shared_ptr<AdvSSFrameGrabber>
+GetFrameGrabber(obs_weak_source_t *source,
+		int interval = default_frame_grab_interval);
+
+// Per consumer view of the frames grabbed from a source.
+class AdvSSFrameReader {
+public:
+	// Subscribes to the grabber of source with the given sample interval
+	void SetSource(obs_weak_source_t *source,
+		       int interval = default_frame_grab_interval);
+	bool IsReading(obs_weak_source_t *source);
+	// Unsubscribes from the grabber to stop grabbing frames if no other
+	// consumer is left
+	void Clear() { _grabber.reset(); }
+	// Returns the most recent frame or nullptr if no frame is available or
+	// the most recent one was already returned before
+	std::shared_ptr<const AdvSSFrame> ReadNewFrame();
+	// Makes the next call to ReadNewFrame() return the most recent frame
+	// even if it was already returned before
+	void ResetFrame() { _lastFrameId = 0; }
+
+private:
+	std::shared_ptr<AdvSSFrameGrabber> _grabber;
+	uint64_t _lastFrameId = 0;
+};
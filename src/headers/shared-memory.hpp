@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+// Layout of the shared memory segment used to exchange state and commands
+// with local tools.
+//
+// The segment is named "/advanced-scene-switcher" (shm_open()) on POSIX
+// systems and "Local\advanced-scene-switcher" (OpenFileMapping()) on
+// Windows.
+// Only one OBS instance can own the segment at a time. A segment left behind
+// by a crashed session is replaced once its owner process no longer exists.
+//
+// The state block is protected by a sequence lock. To read it copy the block
+// and retry if the sequence number was odd or changed meanwhile:
+//
+//   do {
+//       seq = atomic_load_acquire(&shm->stateSequence);
+//       copy = shm->state;
+//       atomic_thread_fence_acquire();
+//   } while ((seq & 1) || seq != atomic_load_relaxed(&shm->stateSequence));
+//
+// The magic value is cleared once the segment is closed, in which case tools
+// should map the segment again to pick up a new session.
+//
+// Commands are passed using a single producer single consumer ring buffer,
+// so only one tool may write commands at a time:
+//
+//   head = atomic_load_relaxed(&shm->commandHead);
+//   if (head - atomic_load_acquire(&shm->commandTail) < SHM_COMMAND_COUNT) {
+//       shm->commands[head % SHM_COMMAND_COUNT] = command;
+//       atomic_store_release(&shm->commandHead, head + 1);
+//       sem_post(signal); // or SetEvent(signal) on Windows
+//   }
+//
+// Posting the signal wakes up the switcher right away instead of leaving the
+// command until the next regular check. It is a named semaphore called
+// "/advanced-scene-switcher-commands" (sem_open()) on POSIX systems and an
+// auto reset event called "Local\advanced-scene-switcher-commands"
+// (OpenEvent()) on Windows.
+
+constexpr uint32_t shm_magic = 0x53535641; // "AVSS"
+constexpr uint32_t shm_version = 3;
+constexpr size_t shm_name_length = 256;
+constexpr size_t shm_max_macros = 256;
+constexpr uint32_t shm_command_count = 64;
+
+struct SharedState {
+	char currentScene[shm_name_length];
+	char previousScene[shm_name_length];
+	uint32_t running;
+	// Number of macros reported in macroMatches
+	uint32_t macroCount;
+	// Number of existing macros, which is larger than macroCount if not all
+	// macros fit into macroMatches
+	uint32_t macroTotal;
+	// Bit i is set if the conditions of macro i matched in the most
+	// recent check
+	uint64_t macroMatches[shm_max_macros / 64];
+	// os_gettime_ns() of the last update
+	uint64_t updateTime;
+};
+
+enum class SharedCommandType : uint32_t {
+	NONE,
+	// Switch to the scene named in argument
+	SWITCH_SCENE,
+	// Set the preview scene to the scene named in argument
+	SWITCH_PREVIEW,
+	// Run the actions of the macro named in argument
+	RUN_MACRO,
+};
+
+struct SharedCommand {
+	SharedCommandType type;
+	char argument[shm_name_length - sizeof(SharedCommandType)];
+};
+
+struct SharedMemoryLayout {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	// Process id of the OBS instance owning the segment
+	uint32_t ownerPid;
+	std::atomic<uint32_t> stateSequence;
+	SharedState state;
+
+	// Keep producer and consumer indices on separate cache lines
+	alignas(64) std::atomic<uint32_t> commandHead;
+	alignas(64) std::atomic<uint32_t> commandTail;
+	SharedCommand commands[shm_command_count];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+	      "atomics in shared memory have to be lock free");
+
+// Owns the shared memory segment.
+// All members may be used from any thread.
+// While the segment is open a watcher thread waits for the command signal and
+// requests a check of the switcher, so Close() must not be called while
+// holding switcher->m.
+class SharedMemoryChannel {
+public:
+	~SharedMemoryChannel();
+	bool Open();
+	void Close();
+	bool IsOpen();
+
+	void SetScenes(const char *current, const char *previous);
+	void SetStatus(bool running, const uint64_t *macroMatches,
+		       uint32_t macroCount);
+	bool HasCommands();
+	bool PopCommand(SharedCommand &command);
+
+private:
+	void Publish();
+	void Watch();
+	bool WaitForSignal();
+
+	SharedMemoryLayout *_shm = nullptr;
+#ifdef _WIN32
+	void *_mapping = nullptr;
+#endif
+	// Named semaphore (sem_t) or event (HANDLE) posted by the producer
+	void *_signal = nullptr;
+	std::thread _watcher;
+	std::atomic_bool _stopWatcher = {false};
+
+	// Serializes access to the segment and writers of the state block
+	std::mutex _mtx;
+	SharedState _state = {};
+};
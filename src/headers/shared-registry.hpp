@@ -0,0 +1,57 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Hands out a single instance of T per key, which is shared by all consumers
+// requesting that key.
+//
+// The registry only holds weak references, so an instance is destroyed as
+// soon as its last consumer releases it.
+// Expired entries are removed before each lookup.
+// Keys containing a weak source pointer are therefore safe as long as T holds
+// a reference to that weak source, as the pointer can not be freed and reused
+// while the instance is alive.
+template<typename Key, typename T> class SharedRegistry {
+public:
+	// Returns the instance for key or calls create() to create it
+	template<typename Create>
+	std::shared_ptr<T> Get(const Key &key, Create create)
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		Prune();
+		auto instance = _instances[key].lock();
+		if (!instance) {
+			instance = create();
+			_instances[key] = instance;
+		}
+		return instance;
+	}
+
+	// Calls create() to replace the instance for key.
+	// Consumers still holding the previous instance keep using it.
+	template<typename Create>
+	std::shared_ptr<T> Replace(const Key &key, Create create)
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		Prune();
+		auto instance = create();
+		_instances[key] = instance;
+		return instance;
+	}
+
+private:
+	void Prune()
+	{
+		for (auto it = _instances.begin(); it != _instances.end();) {
+			if (it->second.expired()) {
+				it = _instances.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	std::mutex _mtx;
+	std::map<Key, std::weak_ptr<T>> _instances;
+};
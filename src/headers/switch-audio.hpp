@@ -1,10 +1,10 @@
 #pragma once
 #include <QSpinBox>
-#include <limits>
 
 #include "switch-generic.hpp"
 #include "duration-control.hpp"
 #include "volume-control.hpp"
+#include "audio-level.hpp"
 
 constexpr auto audio_func = 8;
 constexpr auto default_priority_8 = audio_func;
@@ -21,26 +21,16 @@ struct AudioSwitch : virtual SceneSwitcherEntry {
 	audioCondition condition = ABOVE;
 	Duration duration;
 	bool ignoreInactiveSource = true;
-	float peak = -std::numeric_limits<float>::infinity();
-	obs_volmeter_t *volmeter = nullptr;
+	AudioLevelReader audioLevel;
 
 	const char *getType() { return "audio"; }
 	bool initialized();
 	bool valid();
 	void save(obs_data_t *obj);
 	void load(obs_data_t *obj);
-	static void setVolumeLevel(void *data,
-				   const float magnitude[MAX_AUDIO_CHANNELS],
-				   const float peak[MAX_AUDIO_CHANNELS],
-				   const float inputPeak[MAX_AUDIO_CHANNELS]);
 	void resetVolmeter();
 
 	AudioSwitch(){};
-	AudioSwitch(const AudioSwitch &other);
-	AudioSwitch(AudioSwitch &&other);
-	~AudioSwitch();
-	AudioSwitch &operator=(const AudioSwitch &other);
-	AudioSwitch &operator=(AudioSwitch &&other) noexcept;
 	friend void swap(AudioSwitch &first, AudioSwitch &second);
 };
 
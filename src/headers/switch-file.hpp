@@ -64,6 +64,8 @@ struct FileIOData {
 	std::string readPath;
 	bool writeEnabled = false;
 	std::string writePath;
+	// Publish the state via shared memory (see shared-memory.hpp)
+	bool sharedMemoryEnabled = false;
 };
 
 static inline QString MakeFileSwitchName(const QString &scene,
@@ -0,0 +1,88 @@
+#pragma once
+#include <obs.hpp>
+#include <asio.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <map>
+
+struct sceneSwitchInfo;
+
+// Sends scene changes as small UDP datagrams to a multicast group.
+//
+// Each packet carries a per sender sequence number, which is used by the
+// receivers to drop duplicates and detect lost packets.
+// Every packet is sent twice and the most recent scene and preview packets
+// are repeated periodically, so receivers missing a packet still end up on
+// the current scene.
+// Repeated packets are flagged as such and carry the remaining delay, so
+// receivers joining the group later on only use them to synchronize their
+// sequence numbers instead of performing an outdated scene change.
+class MulticastSender {
+public:
+	MulticastSender();
+	~MulticastSender();
+	bool Start(const std::string &address, uint16_t port);
+	void Stop();
+	bool IsRunning() { return _running; }
+	uint32_t GetId() { return _id; }
+	// delay is the time in ms after which receivers should switch
+	void Send(const sceneSwitchInfo &sceneSwitch, bool preview = false,
+		  int delay = 0);
+
+private:
+	void Thread();
+	void SendPacket(const std::vector<uint8_t> &packet);
+	void SendRepeat(std::vector<uint8_t> packet, uint64_t sendTime,
+			int delay);
+
+	asio::io_context _io;
+	asio::ip::udp::socket _socket;
+	asio::ip::udp::endpoint _endpoint;
+	std::thread _thread;
+	std::mutex _mtx;
+	std::condition_variable _cv;
+	std::atomic_bool _running = {false};
+	const uint32_t _id;
+
+	// Protected by _mtx
+	uint32_t _sceneSequence = 0;
+	uint32_t _previewSequence = 0;
+	std::vector<uint8_t> _lastScene;
+	std::vector<uint8_t> _lastPreview;
+	uint64_t _lastSceneTime = 0;
+	uint64_t _lastPreviewTime = 0;
+	int _lastSceneDelay = 0;
+	int _lastPreviewDelay = 0;
+};
+
+// Joins a multicast group and performs the scene changes received from any
+// MulticastSender within that group.
+class MulticastReceiver {
+public:
+	~MulticastReceiver();
+	bool Start(const std::string &address, uint16_t port);
+	void Stop();
+	bool IsRunning() { return _running; }
+	uint64_t GetReceived() { return _received; }
+	uint64_t GetLost() { return _lost; }
+
+private:
+	void Receive();
+	void HandlePacket(const uint8_t *data, size_t size);
+
+	asio::io_context _io;
+	std::unique_ptr<asio::ip::udp::socket> _socket;
+	asio::ip::udp::endpoint _senderEndpoint;
+	uint8_t _buffer[2048];
+	std::thread _thread;
+	std::atomic_bool _running = {false};
+	std::atomic<uint64_t> _received = {0};
+	std::atomic<uint64_t> _lost = {0};
+
+	// Most recent sequence number per sender and channel (scene or
+	// preview) - only accessed from the receive thread
+	std::map<std::pair<uint32_t, bool>, uint32_t> _sequences;
+};
@@ -5,6 +5,7 @@ Most of this code is based on https://github.com/Palakis/obs-websocket
 #pragma once
 
 #include <set>
+#include <map>
 #include <QtCore/QObject>
 #include <QtCore/QMutex>
 #include <QtCore/QSharedPointer>
@@ -12,6 +13,7 @@ Most of this code is based on https://github.com/Palakis/obs-websocket
 #include <QtCore/QThreadPool>
 #include <mutex>
 #include <condition_variable>
+#include <deque>
 
 #include <websocketpp/config/asio_no_tls_client.hpp>
 #include <websocketpp/config/asio_no_tls.hpp>
@@ -36,6 +38,9 @@ public:
 	bool ShouldSendSceneChange();
 	bool ShouldSendFrontendSceneChange();
 	bool ShouldSendPrviewSceneChange();
+	bool ShouldSynchronizeSceneChange();
+	bool ShouldSendMulticast();
+	bool ShouldReceiveMulticast();
 
 	// Server
 	bool ServerEnabled;
@@ -49,6 +54,24 @@ public:
 	bool SendSceneChange;
 	bool SendSceneChangeAll;
 	bool SendPreview;
+	// Scene changes within this interval (in ms) are combined and only the
+	// most recent one is sent
+	int CoalesceInterval;
+	// Delay local scene switches by SyncDelay (in ms) and ask clients to
+	// switch at the same point in time
+	bool SyncSwitch;
+	int SyncDelay;
+
+	// Multicast
+	bool MulticastEnabled;
+	bool MulticastSend;
+	bool MulticastReceive;
+	std::string MulticastAddress;
+	uint64_t MulticastPort;
+
+	// OSC
+	bool OSCEnabled;
+	uint64_t OSCPort;
 };
 
 class WSServer : public QObject {
@@ -59,13 +82,19 @@ public:
 	virtual ~WSServer();
 	void start(quint16 port, bool lockToIPv4);
 	void stop();
-	void sendMessage(sceneSwitchInfo sceneSwitch, bool preview = false);
+	// If switchTime is not zero clients are asked to switch at this time
+	// (in os_gettime_ns() of this instance) instead of immediately
+	void sendMessage(sceneSwitchInfo sceneSwitch, bool preview = false,
+			 uint64_t switchTime = 0);
 	QThreadPool *threadPool() { return &_threadPool; }
 
 private:
 	void onOpen(connection_hdl hdl);
 	void onMessage(connection_hdl hdl, server::message_ptr message);
 	void onClose(connection_hdl hdl);
+	void broadcast(const server::message_ptr &message, bool preview);
+	void flushPending(const websocketpp::lib::error_code &ec);
+	void flushLagging(const websocketpp::lib::error_code &ec);
 
 	QString getRemoteEndpoint(connection_hdl hdl);
 
@@ -75,6 +104,28 @@ private:
 	std::set<connection_hdl, std::owner_less<connection_hdl>> _connections;
 	QMutex _clMutex;
 	QThreadPool _threadPool;
+
+	// Protected by _clMutex
+	server::message_ptr _pendingScene;
+	server::message_ptr _pendingPreview;
+	bool _flushScheduled = false;
+
+	// Connections which could not keep up with the sent messages only
+	// receive the most recent scene and preview change once their send
+	// buffer is drained.
+	// Protected by _clMutex
+	struct LaggingConnection {
+		server::message_ptr scene;
+		server::message_ptr preview;
+	};
+	std::map<connection_hdl, LaggingConnection,
+		 std::owner_less<connection_hdl>>
+		_lagging;
+	bool _laggingFlushScheduled = false;
+
+	// Used to wait for all connections to be closed in stop()
+	std::mutex _closeMtx;
+	std::condition_variable _closeCv;
 };
 
 enum class ServerStatus {
@@ -99,6 +150,9 @@ private:
 	void onMessage(connection_hdl hdl, client::message_ptr message);
 	void onClose(connection_hdl hdl);
 	void connectThread();
+	void sendSyncRequest(const websocketpp::lib::error_code &ec);
+	void handleSyncResponse(obs_data_t *data);
+	std::string processMessage(obs_data_t *data);
 
 	client _client;
 	std::string _uri;
@@ -109,6 +163,17 @@ private:
 	std::mutex _waitMtx;
 	std::condition_variable _cv;
 	std::string _failMsg;
+
+	// Offset between the clock of the server and the local clock in ns
+	// estimated using the sync request with the lowest round trip time
+	// out of the most recent ones
+	struct ClockSample {
+		int64_t offset;
+		int64_t rtt;
+	};
+	std::deque<ClockSample> _clockSamples;
+	std::atomic<int64_t> _clockOffset = {0};
+	std::atomic_bool _clockSynced = {false};
 };
 
 enum class ClientStatus {
@@ -4,6 +4,7 @@
 struct RandomSwitch : SceneSwitcherEntry {
 	static bool pause;
 	double delay = 0.0;
+	double weight = 1.0;
 
 	const char *getType() { return "random"; }
 	void save(obs_data_t *obj);
@@ -23,9 +24,11 @@ public:
 
 private slots:
 	void DelayChanged(double d);
+	void WeightChanged(double w);
 
 private:
 	QDoubleSpinBox *delay;
+	QDoubleSpinBox *weight;
 
 	RandomSwitch *switchData;
 };
@@ -1,7 +1,9 @@
 #pragma once
 #include <QTimeEdit>
+#include <QLineEdit>
 
 #include "switch-generic.hpp"
+#include "schedule.hpp"
 
 constexpr auto time_func = 7;
 constexpr auto default_priority_7 = time_func;
@@ -15,13 +17,22 @@ typedef enum {
 	FRIDAY = 5,
 	SATURDAY = 6,
 	SUNDAY = 7,
-	LIVE = 8
+	LIVE = 8,
+	CRON = 9
 } timeTrigger;
 
 struct TimeSwitch : SceneSwitcherEntry {
 	static bool pause;
 	timeTrigger trigger = ANY_DAY;
 	QTime time = QTime(0, 0);
+	std::string cron;
+	CronSchedule cronSchedule;
+
+	// Returns the first time after the given one the switch should be
+	// triggered in milliseconds since the epoch or -1 if there is none
+	qint64 nextOccurrence(const QDateTime &after,
+			      const QDateTime &liveStart);
+	void setCron(const std::string &expression);
 
 	const char *getType() { return "time"; }
 	void save(obs_data_t *obj);
@@ -41,10 +52,14 @@ public:
 private slots:
 	void TriggerChanged(int index);
 	void TimeChanged(const QTime &time);
+	void CronChanged();
 
 private:
+	void updateVisibility();
+
 	QComboBox *triggers;
 	QTimeEdit *time;
+	QLineEdit *cron;
 
 	TimeSwitch *switchData;
 };
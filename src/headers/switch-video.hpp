@@ -23,7 +23,7 @@ struct VideoSwitch : virtual SceneSwitcherEntry {
 	double duration = 0;
 	bool ignoreInactiveSource = false;
 
-	std::unique_ptr<AdvSSScreenshotObj> screenshotData = nullptr;
+	AdvSSFrameReader frameReader;
 	std::chrono::high_resolution_clock::time_point previousTime{};
 	QImage matchImage;
 
@@ -34,7 +34,7 @@ struct VideoSwitch : virtual SceneSwitcherEntry {
 	bool valid();
 	void save(obs_data_t *obj);
 	void load(obs_data_t *obj);
-	void getScreenshot();
+	void resetFrameGrabber();
 	bool loadImageFromFile();
 	bool checkMatch();
 
@@ -1,7 +1,11 @@
 #pragma once
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 #include <deque>
+#include <unordered_map>
 #include <mutex>
 #include <QDateTime>
 #include <QThread>
@@ -23,6 +27,10 @@
 #include "switch-sequence.hpp"
 #include "switch-video.hpp"
 #include "switch-network.hpp"
+#include "switch-multicast.hpp"
+#include "osc.hpp"
+#include "shared-memory.hpp"
+#include "scene-switch-queue.hpp"
 
 #include "macro.hpp"
 #include "duration-control.hpp"
@@ -69,8 +77,24 @@ struct SwitcherData {
 	bool waitForTransition = false;
 	std::condition_variable transitionCv;
 	bool stop = false;
+	// Set by external triggers to run the next check without waiting for
+	// the check interval to expire
+	bool checkRequested = false;
+	bool waitingForCheck = false;
+	// Earliest point in time at which a time based element has to be
+	// checked again in nanoseconds since the high_resolution_clock epoch
+	std::atomic<int64_t> nextDeadline = {INT64_MAX};
+	// Set whenever an entry might have become invalid, as validating all
+	// entries on every check is expensive
+	std::atomic_bool pruneRequested = {true};
+	// Set while a scene change which must not be sent to other instances
+	// is applied, so the resulting frontend events are not echoed back
+	std::atomic_bool applyingUnforwardedSwitch = {false};
 	bool verbose = false;
 	bool disableHints = false;
+	// Conditions might be modified at any time while the settings window
+	// is opened
+	bool settingsWindowOpened = false;
 	bool showFrame = false;
 	bool transitionOverrideOverride = false;
 	bool adjustActiveTransitionType = true;
@@ -82,6 +106,9 @@ struct SwitcherData {
 	OBSWeakSource previousSceneHelper = nullptr;
 	OBSWeakSource lastRandomScene;
 	SceneGroup *lastRandomSceneGroup;
+	// Weighted selection of the entries in randomSwitches
+	RandomSelector randomSelector;
+	bool randomSelectionChanged = true;
 	OBSWeakSource nonMatchingScene;
 	NoMatch switchIfNotMatching = NO_SWITCH;
 	Duration noMatchDelay;
@@ -92,9 +119,27 @@ struct SwitcherData {
 	std::chrono::high_resolution_clock::time_point lastMatchTime;
 
 	std::deque<Macro> macros;
-	// Allow only one macro scene change per scene switcher interval
-	// with the top macro having the highest priority
+	// Maps macro names and ids to their position in macros.
+	// Has to be updated using updateMacroIndex() whenever macros are
+	// added, removed, reordered or renamed.
+	std::unordered_map<std::string, size_t> macroNameIndex;
+	std::unordered_map<uint64_t, size_t> macroIdIndex;
+	// Incremented on each update of the index to let MacroRef detect
+	// stale pointers
+	uint64_t macroGeneration = 0;
+	// Set once the actions of a macro switching scenes were run and kept
+	// until the conditions were checked again, so macros can react to
+	// scene changes of other macros
 	bool macroSceneSwitched = false;
+	// Macros referenced by the conditions of other macros are checked
+	// first, so their state is already up to date within the same interval.
+	// The order, groups and condition settings hashes are updated whenever
+	// macroDependenciesChanged is set.
+	std::vector<Macro *> macroCheckOrder;
+	// Group of each entry of macroCheckOrder or nullptr
+	std::vector<MacroGroup *> macroCheckGroups;
+	bool macroDependenciesChanged = true;
+	std::map<std::string, MacroGroup> macroGroups;
 
 	std::deque<WindowSwitch> windowSwitches;
 	WindowSwitch *lastMatch;
@@ -113,6 +158,7 @@ struct SwitcherData {
 	IdleData idleData;
 
 	FileIOData fileIO;
+	SharedMemoryChannel sharedMemory;
 	std::deque<FileSwitch> fileSwitches;
 	CURL *curl = nullptr;
 
@@ -128,6 +174,9 @@ struct SwitcherData {
 	std::deque<PauseEntry> pauseEntries;
 
 	std::deque<TimeSwitch> timeSwitches;
+	// Next occurrence of each time switch by index in timeSwitches
+	ScheduleEngine timeSchedule;
+	bool timeScheduleChanged = true;
 	QDateTime liveTime;
 
 	std::deque<AudioSwitch> audioSwitches;
@@ -138,6 +187,10 @@ struct SwitcherData {
 	WSClient client;
 	ClientStatus clientStatus = ClientStatus::DISCONNECTED;
 	NetworkConfig networkConfig;
+	MulticastSender multicastSender;
+	MulticastReceiver multicastReceiver;
+	OSCListener oscListener;
+	SceneSwitchQueue switchQueue;
 
 	std::deque<VideoSwitch> videoSwitches;
 
@@ -195,6 +248,11 @@ struct SwitcherData {
 
 	void setWaitScene();
 	bool sceneChangedDuringWait();
+	// Must not be called while holding m
+	void requestCheck();
+	// Wake up the switcher thread no later than the given point in time
+	// for the next check instead of waiting for the full interval
+	void addDeadline(std::chrono::high_resolution_clock::time_point time);
 
 	bool prioFuncsValid();
 
@@ -207,8 +265,11 @@ struct SwitcherData {
 	bool checkForMatch(OBSWeakSource &scene, OBSWeakSource &transition,
 			   int &linger, bool &setPreviousSceneAsMatch,
 			   bool &macroMatch);
+	void updateMacroIndex();
+	void updateMacroCheckOrder();
 	bool checkMacros();
 	bool runMacros();
+	void runRequestedMacros(const std::vector<Macro *> &requested);
 	bool checkSceneSequence(OBSWeakSource &scene, OBSWeakSource &transition,
 				int &linger, bool &setPrevSceneAfterLinger);
 	bool checkIdleSwitch(OBSWeakSource &scene, OBSWeakSource &transition);
@@ -223,6 +284,7 @@ struct SwitcherData {
 	bool checkRandom(OBSWeakSource &scene, OBSWeakSource &transition,
 			 int &delay);
 	bool checkMediaSwitch(OBSWeakSource &scene, OBSWeakSource &transition);
+	void updateTimeSchedule(const QDateTime &now);
 	bool checkTimeSwitch(OBSWeakSource &scene, OBSWeakSource &transition);
 	bool checkAudioSwitch(OBSWeakSource &scene, OBSWeakSource &transition);
 	void checkAudioSwitchFallback(OBSWeakSource &scene,
@@ -275,6 +337,12 @@ struct SwitcherData {
 	void loadSceneTriggers(obs_data_t *obj);
 	void loadVideoSwitches(obs_data_t *obj);
 	void loadNetworkSettings(obs_data_t *obj);
+	void startMulticast();
+	void startOSC();
+	void getOSCMacroRequests(std::vector<Macro *> &requested);
+	void updateSharedMemoryScenes();
+	void updateSharedMemoryStatus();
+	void processSharedMemoryCommands(std::vector<Macro *> &requested);
 	void loadGeneralSettings(obs_data_t *obj);
 	void loadHotkeys(obs_data_t *obj);
 
@@ -0,0 +1,78 @@
+#pragma once
+#include <QImage>
+#include <QRect>
+#include <QPoint>
+#include <vector>
+#include <cstdint>
+
+// 8 bit luminance image
+struct GrayImage {
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> data;
+
+	const uint8_t *Line(int y) const { return data.data() + y * width; }
+};
+
+// Converts the given region of image to luminance, averaging blocks of
+// scale x scale pixels
+GrayImage ToGrayImage(const QImage &image, const QRect &region, int scale = 1);
+
+// Locates a template image anywhere within a larger image using normalized
+// cross-correlation (NCC).
+//
+// The search is first run on a downscaled copy of the frame to find
+// candidate positions, which are then refined at full resolution.
+// Integral images are used to compute the per window normalization in
+// constant time, so only the correlation itself scales with the template
+// size.
+class TemplateMatcher {
+public:
+	void SetTemplate(const QImage &image);
+	bool Valid() const { return _full.width > 0 && _full.height > 0; }
+
+	// Returns the best NCC score in range -1 to 1 found within region of
+	// frame or -1 if the template does not fit into the region.
+	// An empty region will search the whole frame.
+	double Match(const QImage &frame, QRect region = {},
+		     QPoint *position = nullptr) const;
+
+private:
+	struct Template {
+		int width = 0;
+		int height = 0;
+		// Zero mean pixel values
+		std::vector<float> data;
+		double mean = 0.;
+		double norm = 0.;
+		// Position of the first pixel within the full resolution
+		// template
+		int offsetX = 0;
+		int offsetY = 0;
+	};
+	struct Candidate {
+		double score;
+		int x;
+		int y;
+	};
+	// Integral images of pixel values and squared pixel values
+	struct IntegralImage {
+		IntegralImage(const GrayImage &image);
+		int stride;
+		std::vector<uint64_t> sum;
+		std::vector<uint64_t> sqSum;
+	};
+
+	static Template MakeTemplate(const GrayImage &image);
+	static void AddCandidate(std::vector<Candidate> &best,
+				 size_t maxCandidates, double score, int x,
+				 int y, int minDistance);
+	static void Search(const GrayImage &image,
+			   const IntegralImage &integral, const Template &tmpl,
+			   int x0, int y0, int x1, int y1,
+			   std::vector<Candidate> &best, size_t maxCandidates);
+
+	Template _full;
+	std::vector<Template> _coarse;
+	int _scale = 1;
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include <obs.hpp>
+
+enum class FadeCurve {
+	LINEAR,
+	// Linear in dB, which is perceived as an even change in loudness
+	LOGARITHMIC,
+	// Starts and ends slowly
+	S_CURVE,
+};
+
+// Gradually changes the volume of source to target over the given duration.
+// If source is nullptr the master volume is faded instead.
+//
+// Fades are advanced from an OBS tick callback, so any number of fades can
+// run concurrently without blocking the macro thread.
+// The tick callback is only registered while at least one fade is running.
+// Starting a new fade for a source replaces its current fade and continues
+// from the current volume.
+void StartVolumeFade(obs_weak_source_t *source, float target, double seconds,
+		     FadeCurve curve);
+// Stops the fade of source at its current volume
+void StopVolumeFade(obs_weak_source_t *source);
+bool IsVolumeFading(obs_weak_source_t *source);
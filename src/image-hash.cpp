@@ -0,0 +1,209 @@
+#include "headers/image-hash.hpp"
+#include "headers/shared-registry.hpp"
+
+#include <obs-module.h>
+#include <QDir>
+
+constexpr int hash_grid_width = 9;
+constexpr int hash_grid_height = 8;
+
+ImageHash ComputeImageHash(const QImage &image)
+{
+	if (image.isNull()) {
+		return 0;
+	}
+
+	QImage img = image;
+	if (img.format() != QImage::Format_RGBX8888 &&
+	    img.format() != QImage::Format_RGBA8888) {
+		img = img.convertToFormat(QImage::Format_RGBX8888);
+	}
+
+	const int width = img.width();
+	const int height = img.height();
+
+	// Average the luminance of each grid cell.
+	// Integer weights approximate Rec. 601 luma (77, 150, 29) / 256.
+	uint64_t sums[hash_grid_height][hash_grid_width] = {};
+	uint64_t counts[hash_grid_height][hash_grid_width] = {};
+	std::vector<int> cellX(width);
+	for (int x = 0; x < width; x++) {
+		cellX[x] = x * hash_grid_width / width;
+	}
+
+	for (int y = 0; y < height; y++) {
+		const int cy = y * hash_grid_height / height;
+		const uint8_t *line = img.constScanLine(y);
+		uint64_t *rowSums = sums[cy];
+		uint64_t *rowCounts = counts[cy];
+		for (int x = 0; x < width; x++) {
+			const uint8_t *px = line + x * 4;
+			rowSums[cellX[x]] += 77 * px[0] + 150 * px[1] +
+					     29 * px[2];
+			rowCounts[cellX[x]]++;
+		}
+	}
+
+	ImageHash hash = 0;
+	int bit = 0;
+	for (int y = 0; y < hash_grid_height; y++) {
+		for (int x = 0; x < hash_grid_width - 1; x++) {
+			auto left = counts[y][x] ? sums[y][x] / counts[y][x]
+						 : 0;
+			auto right = counts[y][x + 1] ? sums[y][x + 1] /
+								counts[y][x + 1]
+						      : 0;
+			if (left > right) {
+				hash |= (ImageHash)1 << bit;
+			}
+			bit++;
+		}
+	}
+	return hash;
+}
+
+int HashDistance(ImageHash a, ImageHash b)
+{
+	ImageHash v = a ^ b;
+	int count = 0;
+	while (v) {
+		v &= v - 1;
+		count++;
+	}
+	return count;
+}
+
+void ImageHashIndex::Add(ImageHash hash, size_t value)
+{
+	_size++;
+	if (_nodes.empty()) {
+		_nodes.push_back({hash, {value}, {}});
+		return;
+	}
+
+	size_t cur = 0;
+	while (true) {
+		int dist = HashDistance(hash, _nodes[cur].hash);
+		if (dist == 0) {
+			_nodes[cur].values.push_back(value);
+			return;
+		}
+
+		bool found = false;
+		for (const auto &child : _nodes[cur].children) {
+			if (child.first == dist) {
+				cur = child.second;
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			_nodes.push_back({hash, {value}, {}});
+			_nodes[cur].children.emplace_back(dist,
+							  _nodes.size() - 1);
+			return;
+		}
+	}
+}
+
+bool ImageHashIndex::FindClosest(ImageHash hash, int maxDistance,
+				 std::vector<size_t> &values,
+				 int &distance) const
+{
+	if (_nodes.empty()) {
+		return false;
+	}
+
+	int best = maxDistance + 1;
+	size_t bestNode = 0;
+	std::vector<size_t> stack = {0};
+
+	while (!stack.empty()) {
+		size_t cur = stack.back();
+		stack.pop_back();
+		const Node &node = _nodes[cur];
+
+		int dist = HashDistance(hash, node.hash);
+		if (dist < best) {
+			best = dist;
+			bestNode = cur;
+			if (dist == 0) {
+				break;
+			}
+		}
+
+		// Triangle inequality: only subtrees whose edge distance lies
+		// within the current search radius can contain better matches
+		int radius = best - 1;
+		for (const auto &child : node.children) {
+			if (child.first >= dist - radius &&
+			    child.first <= dist + radius) {
+				stack.push_back(child.second);
+			}
+		}
+	}
+
+	if (best > maxDistance) {
+		return false;
+	}
+	values = _nodes[bestNode].values;
+	distance = best;
+	return true;
+}
+
+ReferenceImageLibrary::ReferenceImageLibrary(const std::string &folder)
+	: _folder(folder)
+{
+	QDir dir(QString::fromStdString(folder));
+	const QStringList filters = {"*.png", "*.jpg", "*.jpeg", "*.bmp"};
+	const auto files = dir.entryInfoList(filters, QDir::Files,
+					     QDir::Name | QDir::IgnoreCase);
+
+	for (const auto &file : files) {
+		QImage image;
+		if (!image.load(file.absoluteFilePath())) {
+			blog(LOG_WARNING,
+			     "Cannot load reference image from file '%s'",
+			     file.absoluteFilePath().toUtf8().constData());
+			continue;
+		}
+		_index.Add(ComputeImageHash(image), _names.size());
+		_names.emplace_back(file.fileName().toStdString());
+	}
+
+	blog(LOG_INFO, "loaded %zu reference images from '%s'", _names.size(),
+	     folder.c_str());
+}
+
+std::vector<std::string>
+ReferenceImageLibrary::Lookup(ImageHash hash, int maxDistance,
+			      int *distance) const
+{
+	std::vector<size_t> indices;
+	int dist = 0;
+	if (!_index.FindClosest(hash, maxDistance, indices, dist)) {
+		return {};
+	}
+	if (distance) {
+		*distance = dist;
+	}
+	std::vector<std::string> names;
+	for (auto idx : indices) {
+		names.emplace_back(_names[idx]);
+	}
+	return names;
+}
+
+static SharedRegistry<std::string, ReferenceImageLibrary> libraries;
+
+std::shared_ptr<ReferenceImageLibrary>
+GetReferenceImageLibrary(const std::string &folder, bool reload)
+{
+	auto create = [&folder]() {
+		return std::make_shared<ReferenceImageLibrary>(folder);
+	};
+	if (reload) {
+		return libraries.Replace(folder, create);
+	}
+	return libraries.Get(folder, create);
+}
@@ -0,0 +1,75 @@
+#include "headers/image-stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ImageStats ComputeImageStats(const QImage &image, int maxSamples)
+{
+	ImageStats stats;
+	if (image.isNull()) {
+		return stats;
+	}
+
+	QImage img = image;
+	if (img.format() != QImage::Format_RGBX8888 &&
+	    img.format() != QImage::Format_RGBA8888) {
+		img = img.convertToFormat(QImage::Format_RGBX8888);
+	}
+
+	const int width = img.width();
+	const int height = img.height();
+	int step = (int)std::ceil(std::sqrt((double)width * height /
+					    std::max(maxSamples, 1)));
+	step = std::max(step, 1);
+
+	// Accumulate in integers to keep the inner loop free of conversions.
+	// Integer weights approximate Rec. 601 luma (77, 150, 29) / 256.
+	uint64_t sum[3] = {0, 0, 0};
+	uint64_t lumaSum = 0;
+	uint64_t lumaSqSum = 0;
+	uint32_t histogram[image_stats_histogram_bins] = {};
+	uint64_t count = 0;
+
+	for (int y = step / 2; y < height; y += step) {
+		const uint8_t *line = img.constScanLine(y);
+		for (int x = step / 2; x < width; x += step) {
+			const uint8_t *px = line + x * 4;
+			uint32_t r = px[0];
+			uint32_t g = px[1];
+			uint32_t b = px[2];
+			uint32_t luma = (77 * r + 150 * g + 29 * b) >> 8;
+			sum[0] += r;
+			sum[1] += g;
+			sum[2] += b;
+			lumaSum += luma;
+			lumaSqSum += luma * luma;
+			histogram[luma * image_stats_histogram_bins / 256]++;
+			count++;
+		}
+	}
+
+	if (count == 0) {
+		return stats;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		stats.mean[i] = (double)sum[i] / count;
+	}
+	stats.luminance = (double)lumaSum / count;
+	stats.luminanceVariance = (double)lumaSqSum / count -
+				  stats.luminance * stats.luminance;
+	for (int i = 0; i < image_stats_histogram_bins; i++) {
+		stats.histogram[i] = (float)histogram[i] / count;
+	}
+	stats.valid = true;
+	return stats;
+}
+
+double HistogramDistance(const ImageStats &a, const ImageStats &b)
+{
+	double dist = 0.;
+	for (int i = 0; i < image_stats_histogram_bins; i++) {
+		dist += std::abs(a.histogram[i] - b.histogram[i]);
+	}
+	return dist / 2.;
+}
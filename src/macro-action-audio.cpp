@@ -16,6 +16,17 @@ const static std::map<AudioAction, std::string> actionTypes = {
 	 "AdvSceneSwitcher.action.audio.type.sourceVolume"},
 	{AudioAction::MASTER_VOLUME,
 	 "AdvSceneSwitcher.action.audio.type.masterVolume"},
+	{AudioAction::SOURCE_VOLUME_FADE,
+	 "AdvSceneSwitcher.action.audio.type.sourceVolumeFade"},
+	{AudioAction::MASTER_VOLUME_FADE,
+	 "AdvSceneSwitcher.action.audio.type.masterVolumeFade"},
+};
+
+const static std::map<FadeCurve, std::string> fadeCurves = {
+	{FadeCurve::LINEAR, "AdvSceneSwitcher.action.audio.fadeCurve.linear"},
+	{FadeCurve::LOGARITHMIC,
+	 "AdvSceneSwitcher.action.audio.fadeCurve.logarithmic"},
+	{FadeCurve::S_CURVE, "AdvSceneSwitcher.action.audio.fadeCurve.sCurve"},
 };
 
 bool MacroActionAudio::PerformAction()
@@ -29,11 +40,24 @@ bool MacroActionAudio::PerformAction()
 		obs_source_set_muted(s, false);
 		break;
 	case AudioAction::SOURCE_VOLUME:
+		// A running fade would otherwise overwrite the new volume
+		StopVolumeFade(_audioSource);
 		obs_source_set_volume(s, (float)_volume / 100.0f);
 		break;
 	case AudioAction::MASTER_VOLUME:
+		StopVolumeFade(nullptr);
 		obs_set_master_volume((float)_volume / 100.0f);
 		break;
+	case AudioAction::SOURCE_VOLUME_FADE:
+		if (_audioSource) {
+			StartVolumeFade(_audioSource, (float)_volume / 100.0f,
+					_fadeDuration.seconds, _fadeCurve);
+		}
+		break;
+	case AudioAction::MASTER_VOLUME_FADE:
+		StartVolumeFade(nullptr, (float)_volume / 100.0f,
+				_fadeDuration.seconds, _fadeCurve);
+		break;
 	default:
 		break;
 	}
@@ -62,6 +86,8 @@ bool MacroActionAudio::Save(obs_data_t *obj)
 			    GetWeakSourceName(_audioSource).c_str());
 	obs_data_set_int(obj, "action", static_cast<int>(_action));
 	obs_data_set_int(obj, "volume", _volume);
+	_fadeDuration.Save(obj, "fadeDuration", "fadeDurationUnit");
+	obs_data_set_int(obj, "fadeCurve", static_cast<int>(_fadeCurve));
 	return true;
 }
 
@@ -72,6 +98,8 @@ bool MacroActionAudio::Load(obs_data_t *obj)
 	_audioSource = GetWeakSourceByName(audioSourceName);
 	_action = static_cast<AudioAction>(obs_data_get_int(obj, "action"));
 	_volume = obs_data_get_int(obj, "volume");
+	_fadeDuration.Load(obj, "fadeDuration", "fadeDurationUnit");
+	_fadeCurve = static_cast<FadeCurve>(obs_data_get_int(obj, "fadeCurve"));
 	return true;
 }
 
@@ -82,6 +110,13 @@ static inline void populateActionSelection(QComboBox *list)
 	}
 }
 
+static inline void populateFadeCurveSelection(QComboBox *list)
+{
+	for (auto entry : fadeCurves) {
+		list->addItem(obs_module_text(entry.second.c_str()));
+	}
+}
+
 MacroActionAudioEdit::MacroActionAudioEdit(
 	QWidget *parent, std::shared_ptr<MacroActionAudio> entryData)
 	: QWidget(parent)
@@ -92,9 +127,13 @@ MacroActionAudioEdit::MacroActionAudioEdit(
 	_volumePercent->setMinimum(0);
 	_volumePercent->setMaximum(2000);
 	_volumePercent->setSuffix("%");
+	_fadeDuration = new DurationSelection();
+	_fadeCurve = new QComboBox();
+	_fadeSettings = new QWidget();
 
 	populateActionSelection(_actions);
 	populateAudioSelection(_audioSources);
+	populateFadeCurveSelection(_fadeCurve);
 
 	QWidget::connect(_actions, SIGNAL(currentIndexChanged(int)), this,
 			 SLOT(ActionChanged(int)));
@@ -103,15 +142,32 @@ MacroActionAudioEdit::MacroActionAudioEdit(
 			 SLOT(SourceChanged(const QString &)));
 	QWidget::connect(_volumePercent, SIGNAL(valueChanged(int)), this,
 			 SLOT(VolumeChanged(int)));
+	QWidget::connect(_fadeDuration, SIGNAL(DurationChanged(double)), this,
+			 SLOT(FadeDurationChanged(double)));
+	QWidget::connect(_fadeDuration, SIGNAL(UnitChanged(DurationUnit)),
+			 this, SLOT(FadeDurationUnitChanged(DurationUnit)));
+	QWidget::connect(_fadeCurve, SIGNAL(currentIndexChanged(int)), this,
+			 SLOT(FadeCurveChanged(int)));
 
-	QHBoxLayout *mainLayout = new QHBoxLayout;
+	QHBoxLayout *actionLayout = new QHBoxLayout;
+	QHBoxLayout *fadeLayout = new QHBoxLayout;
 	std::unordered_map<std::string, QWidget *> widgetPlaceholders = {
 		{"{{audioSources}}", _audioSources},
 		{"{{actions}}", _actions},
 		{"{{volume}}", _volumePercent},
+		{"{{duration}}", _fadeDuration},
+		{"{{curve}}", _fadeCurve},
 	};
 	placeWidgets(obs_module_text("AdvSceneSwitcher.action.audio.entry"),
-		     mainLayout, widgetPlaceholders);
+		     actionLayout, widgetPlaceholders);
+	placeWidgets(obs_module_text("AdvSceneSwitcher.action.audio.entry.fade"),
+		     fadeLayout, widgetPlaceholders);
+	fadeLayout->setContentsMargins(0, 0, 0, 0);
+	_fadeSettings->setLayout(fadeLayout);
+
+	QVBoxLayout *mainLayout = new QVBoxLayout;
+	mainLayout->addLayout(actionLayout);
+	mainLayout->addWidget(_fadeSettings);
 	setLayout(mainLayout);
 
 	_entryData = entryData;
@@ -122,12 +178,21 @@ MacroActionAudioEdit::MacroActionAudioEdit(
 bool hasVolumeControl(AudioAction action)
 {
 	return action == AudioAction::SOURCE_VOLUME ||
-	       action == AudioAction::MASTER_VOLUME;
+	       action == AudioAction::MASTER_VOLUME ||
+	       action == AudioAction::SOURCE_VOLUME_FADE ||
+	       action == AudioAction::MASTER_VOLUME_FADE;
 }
 
 bool hasSourceControl(AudioAction action)
 {
-	return action != AudioAction::MASTER_VOLUME;
+	return action != AudioAction::MASTER_VOLUME &&
+	       action != AudioAction::MASTER_VOLUME_FADE;
+}
+
+static bool hasFadeControl(AudioAction action)
+{
+	return action == AudioAction::SOURCE_VOLUME_FADE ||
+	       action == AudioAction::MASTER_VOLUME_FADE;
 }
 
 void MacroActionAudioEdit::SetWidgetVisibility()
@@ -143,6 +208,8 @@ void MacroActionAudioEdit::SetWidgetVisibility()
 	} else {
 		_audioSources->hide();
 	}
+
+	_fadeSettings->setVisible(hasFadeControl(_entryData->_action));
 }
 
 void MacroActionAudioEdit::UpdateEntryData()
@@ -155,6 +222,8 @@ void MacroActionAudioEdit::UpdateEntryData()
 		GetWeakSourceName(_entryData->_audioSource).c_str());
 	_actions->setCurrentIndex(static_cast<int>(_entryData->_action));
 	_volumePercent->setValue(_entryData->_volume);
+	_fadeDuration->SetDuration(_entryData->_fadeDuration);
+	_fadeCurve->setCurrentIndex(static_cast<int>(_entryData->_fadeCurve));
 
 	SetWidgetVisibility();
 }
@@ -189,3 +258,33 @@ void MacroActionAudioEdit::VolumeChanged(int value)
 	std::lock_guard<std::mutex> lock(switcher->m);
 	_entryData->_volume = value;
 }
+
+void MacroActionAudioEdit::FadeDurationChanged(double value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_fadeDuration.seconds = value;
+}
+
+void MacroActionAudioEdit::FadeDurationUnitChanged(DurationUnit unit)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_fadeDuration.displayUnit = unit;
+}
+
+void MacroActionAudioEdit::FadeCurveChanged(int value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_fadeCurve = static_cast<FadeCurve>(value);
+}
@@ -0,0 +1,265 @@
+#include "headers/macro-condition-edit.hpp"
+#include "headers/macro-condition-audio-spectrum.hpp"
+#include "headers/utility.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+
+const std::string MacroConditionAudioSpectrum::id = "audio_spectrum";
+
+bool MacroConditionAudioSpectrum::_registered =
+	MacroConditionFactory::Register(
+		MacroConditionAudioSpectrum::id,
+		{MacroConditionAudioSpectrum::Create,
+		 MacroConditionAudioSpectrumEdit::Create,
+		 "AdvSceneSwitcher.condition.audioSpectrum"});
+
+static std::map<AudioSpectrumCondition, std::string> conditionTypes = {
+	{AudioSpectrumCondition::BAND_ABOVE,
+	 "AdvSceneSwitcher.condition.audioSpectrum.condition.bandAbove"},
+	{AudioSpectrumCondition::BAND_BELOW,
+	 "AdvSceneSwitcher.condition.audioSpectrum.condition.bandBelow"},
+	{AudioSpectrumCondition::VOICE_ABOVE,
+	 "AdvSceneSwitcher.condition.audioSpectrum.condition.voiceAbove"},
+	{AudioSpectrumCondition::VOICE_BELOW,
+	 "AdvSceneSwitcher.condition.audioSpectrum.condition.voiceBelow"},
+};
+
+static inline bool isBandCondition(AudioSpectrumCondition condition)
+{
+	return condition == AudioSpectrumCondition::BAND_ABOVE ||
+	       condition == AudioSpectrumCondition::BAND_BELOW;
+}
+
+bool MacroConditionAudioSpectrum::CheckCondition()
+{
+	if (!_analyzer) {
+		return false;
+	}
+
+	switch (_condition) {
+	case AudioSpectrumCondition::BAND_ABOVE:
+		return _analyzer->BandLevel(_lowFreq, _highFreq) > _level;
+	case AudioSpectrumCondition::BAND_BELOW:
+		return _analyzer->BandLevel(_lowFreq, _highFreq) < _level;
+	case AudioSpectrumCondition::VOICE_ABOVE:
+		return _analyzer->VoiceActivity() * 100. > _voiceThreshold;
+	case AudioSpectrumCondition::VOICE_BELOW:
+		return _analyzer->VoiceActivity() * 100. < _voiceThreshold;
+	default:
+		break;
+	}
+	return false;
+}
+
+bool MacroConditionAudioSpectrum::Save(obs_data_t *obj)
+{
+	MacroCondition::Save(obj);
+	obs_data_set_string(obj, "audioSource",
+			    GetWeakSourceName(_audioSource).c_str());
+	obs_data_set_int(obj, "condition", static_cast<int>(_condition));
+	obs_data_set_int(obj, "lowFreq", _lowFreq);
+	obs_data_set_int(obj, "highFreq", _highFreq);
+	obs_data_set_double(obj, "level", _level);
+	obs_data_set_double(obj, "voiceThreshold", _voiceThreshold);
+	return true;
+}
+
+bool MacroConditionAudioSpectrum::Load(obs_data_t *obj)
+{
+	MacroCondition::Load(obj);
+	const char *audioSourceName = obs_data_get_string(obj, "audioSource");
+	_audioSource = GetWeakSourceByName(audioSourceName);
+	_condition = static_cast<AudioSpectrumCondition>(
+		obs_data_get_int(obj, "condition"));
+	obs_data_set_default_int(obj, "lowFreq", default_band_low_freq);
+	obs_data_set_default_int(obj, "highFreq", default_band_high_freq);
+	obs_data_set_default_double(obj, "level", default_band_level);
+	obs_data_set_default_double(obj, "voiceThreshold",
+				    default_voice_threshold);
+	_lowFreq = obs_data_get_int(obj, "lowFreq");
+	_highFreq = obs_data_get_int(obj, "highFreq");
+	_level = obs_data_get_double(obj, "level");
+	_voiceThreshold = obs_data_get_double(obj, "voiceThreshold");
+	ResetAnalyzer();
+	return true;
+}
+
+void MacroConditionAudioSpectrum::ResetAnalyzer()
+{
+	if (!_audioSource) {
+		_analyzer.reset();
+		return;
+	}
+	if (_analyzer &&
+	    _analyzer->GetSource() == (obs_weak_source_t *)_audioSource) {
+		return;
+	}
+	_analyzer = GetAudioSpectrumAnalyzer(_audioSource);
+}
+
+static inline void populateConditionSelection(QComboBox *list)
+{
+	for (auto entry : conditionTypes) {
+		list->addItem(obs_module_text(entry.second.c_str()));
+	}
+}
+
+MacroConditionAudioSpectrumEdit::MacroConditionAudioSpectrumEdit(
+	QWidget *parent, std::shared_ptr<MacroConditionAudioSpectrum> entryData)
+	: QWidget(parent)
+{
+	_audioSources = new QComboBox();
+	_condition = new QComboBox();
+	_lowFreq = new QSpinBox();
+	_highFreq = new QSpinBox();
+	_level = new QDoubleSpinBox();
+	_voiceThreshold = new QDoubleSpinBox();
+	_bandSettings = new QWidget();
+
+	for (auto spinBox : {_lowFreq, _highFreq}) {
+		spinBox->setMinimum(0);
+		spinBox->setMaximum(24000);
+		spinBox->setSuffix("Hz");
+	}
+	_level->setMinimum(-100.);
+	_level->setMaximum(0.);
+	_level->setDecimals(1);
+	_level->setSuffix("dB");
+	_voiceThreshold->setMinimum(0.);
+	_voiceThreshold->setMaximum(100.);
+	_voiceThreshold->setSuffix("%");
+
+	QWidget::connect(_audioSources,
+			 SIGNAL(currentTextChanged(const QString &)), this,
+			 SLOT(SourceChanged(const QString &)));
+	QWidget::connect(_condition, SIGNAL(currentIndexChanged(int)), this,
+			 SLOT(ConditionChanged(int)));
+	QWidget::connect(_lowFreq, SIGNAL(valueChanged(int)), this,
+			 SLOT(LowFreqChanged(int)));
+	QWidget::connect(_highFreq, SIGNAL(valueChanged(int)), this,
+			 SLOT(HighFreqChanged(int)));
+	QWidget::connect(_level, SIGNAL(valueChanged(double)), this,
+			 SLOT(LevelChanged(double)));
+	QWidget::connect(_voiceThreshold, SIGNAL(valueChanged(double)), this,
+			 SLOT(VoiceThresholdChanged(double)));
+
+	populateAudioSelection(_audioSources);
+	populateConditionSelection(_condition);
+
+	QHBoxLayout *line1Layout = new QHBoxLayout;
+	QHBoxLayout *line2Layout = new QHBoxLayout;
+	std::unordered_map<std::string, QWidget *> widgetPlaceholders = {
+		{"{{audioSources}}", _audioSources},
+		{"{{condition}}", _condition},
+		{"{{lowFreq}}", _lowFreq},
+		{"{{highFreq}}", _highFreq},
+		{"{{level}}", _level},
+		{"{{voiceThreshold}}", _voiceThreshold},
+	};
+	placeWidgets(obs_module_text(
+			     "AdvSceneSwitcher.condition.audioSpectrum.entry"),
+		     line1Layout, widgetPlaceholders);
+	placeWidgets(
+		obs_module_text(
+			"AdvSceneSwitcher.condition.audioSpectrum.entry.band"),
+		line2Layout, widgetPlaceholders);
+	line2Layout->setContentsMargins(0, 0, 0, 0);
+	_bandSettings->setLayout(line2Layout);
+
+	QVBoxLayout *mainLayout = new QVBoxLayout;
+	mainLayout->addLayout(line1Layout);
+	mainLayout->addWidget(_bandSettings);
+	setLayout(mainLayout);
+
+	_entryData = entryData;
+	UpdateEntryData();
+	_loading = false;
+}
+
+void MacroConditionAudioSpectrumEdit::SetWidgetVisibility()
+{
+	bool band = isBandCondition(_entryData->_condition);
+	_level->setVisible(band);
+	_bandSettings->setVisible(band);
+	_voiceThreshold->setVisible(!band);
+}
+
+void MacroConditionAudioSpectrumEdit::SourceChanged(const QString &text)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_audioSource = GetWeakSourceByQString(text);
+	_entryData->ResetAnalyzer();
+}
+
+void MacroConditionAudioSpectrumEdit::ConditionChanged(int cond)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(switcher->m);
+		_entryData->_condition =
+			static_cast<AudioSpectrumCondition>(cond);
+	}
+	SetWidgetVisibility();
+}
+
+void MacroConditionAudioSpectrumEdit::LowFreqChanged(int value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_lowFreq = value;
+}
+
+void MacroConditionAudioSpectrumEdit::HighFreqChanged(int value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_highFreq = value;
+}
+
+void MacroConditionAudioSpectrumEdit::LevelChanged(double value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_level = value;
+}
+
+void MacroConditionAudioSpectrumEdit::VoiceThresholdChanged(double value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_voiceThreshold = value;
+}
+
+void MacroConditionAudioSpectrumEdit::UpdateEntryData()
+{
+	if (!_entryData) {
+		return;
+	}
+
+	_audioSources->setCurrentText(
+		GetWeakSourceName(_entryData->_audioSource).c_str());
+	_condition->setCurrentIndex(static_cast<int>(_entryData->_condition));
+	_lowFreq->setValue(_entryData->_lowFreq);
+	_highFreq->setValue(_entryData->_highFreq);
+	_level->setValue(_entryData->_level);
+	_voiceThreshold->setValue(_entryData->_voiceThreshold);
+	SetWidgetVisibility();
+}
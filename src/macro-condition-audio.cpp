@@ -15,26 +15,39 @@ static std::map<AudioCondition, std::string> audioConditionTypes = {
 	{AudioCondition::BELOW, "AdvSceneSwitcher.condition.audio.state.below"},
 };
 
-MacroConditionAudio::~MacroConditionAudio()
-{
-	obs_volmeter_remove_callback(_volmeter, SetVolumeLevel, this);
-	obs_volmeter_destroy(_volmeter);
-}
+static std::map<AudioMeasurement, std::string> audioMeasurementTypes = {
+	{AudioMeasurement::VOLUME,
+	 "AdvSceneSwitcher.condition.audio.measurement.volume"},
+	{AudioMeasurement::RMS,
+	 "AdvSceneSwitcher.condition.audio.measurement.rms"},
+	{AudioMeasurement::LUFS,
+	 "AdvSceneSwitcher.condition.audio.measurement.lufs"},
+};
 
 bool MacroConditionAudio::CheckCondition()
 {
+	if (_measurement != AudioMeasurement::VOLUME) {
+		if (!_loudnessMeter) {
+			return false;
+		}
+		double level = _loudnessMeter->Loudness();
+		if (_condition == AudioCondition::ABOVE) {
+			return level > _threshold;
+		}
+		return level < _threshold;
+	}
+
+	// Highest peak since the last check
 	// peak will have a value from -60 db to 0 db
+	float peak = _audioLevel.Read().peak;
 	bool volumeThresholdreached = false;
 
 	if (_condition == AudioCondition::ABOVE) {
-		volumeThresholdreached = ((double)_peak + 60) * 1.7 > _volume;
+		volumeThresholdreached = ((double)peak + 60) * 1.7 > _volume;
 	} else {
-		volumeThresholdreached = ((double)_peak + 60) * 1.7 < _volume;
+		volumeThresholdreached = ((double)peak + 60) * 1.7 < _volume;
 	}
 
-	// Reset for next check
-	_peak = -std::numeric_limits<float>::infinity();
-
 	return volumeThresholdreached;
 }
 
@@ -45,26 +58,12 @@ bool MacroConditionAudio::Save(obs_data_t *obj)
 			    GetWeakSourceName(_audioSource).c_str());
 	obs_data_set_int(obj, "volume", _volume);
 	obs_data_set_int(obj, "condition", static_cast<int>(_condition));
+	obs_data_set_int(obj, "measurement", static_cast<int>(_measurement));
+	obs_data_set_double(obj, "threshold", _threshold);
+	obs_data_set_int(obj, "window", _window);
 	return true;
 }
 
-obs_volmeter_t *AddVolmeterToSource(MacroConditionAudio *entry,
-				    obs_weak_source *source)
-{
-	obs_volmeter_t *volmeter = obs_volmeter_create(OBS_FADER_LOG);
-	obs_volmeter_add_callback(volmeter, MacroConditionAudio::SetVolumeLevel,
-				  entry);
-	obs_source_t *as = obs_weak_source_get_source(source);
-	if (!obs_volmeter_attach_source(volmeter, as)) {
-		const char *name = obs_source_get_name(as);
-		blog(LOG_WARNING, "failed to attach volmeter to source %s",
-		     name);
-	}
-	obs_source_release(as);
-
-	return volmeter;
-}
-
 bool MacroConditionAudio::Load(obs_data_t *obj)
 {
 	MacroCondition::Load(obj);
@@ -73,37 +72,46 @@ bool MacroConditionAudio::Load(obs_data_t *obj)
 	_volume = obs_data_get_int(obj, "volume");
 	_condition =
 		static_cast<AudioCondition>(obs_data_get_int(obj, "condition"));
-	_volmeter = AddVolmeterToSource(this, _audioSource);
+	_measurement = static_cast<AudioMeasurement>(
+		obs_data_get_int(obj, "measurement"));
+	obs_data_set_default_double(obj, "threshold", -20.);
+	_threshold = obs_data_get_double(obj, "threshold");
+	obs_data_set_default_int(obj, "window", default_loudness_window);
+	_window = obs_data_get_int(obj, "window");
+	ResetVolmeter();
 	return true;
 }
 
-void MacroConditionAudio::SetVolumeLevel(
-	void *data, const float magnitude[MAX_AUDIO_CHANNELS],
-	const float peak[MAX_AUDIO_CHANNELS],
-	const float inputPeak[MAX_AUDIO_CHANNELS])
+void MacroConditionAudio::ResetVolmeter()
 {
-	UNUSED_PARAMETER(magnitude);
-	UNUSED_PARAMETER(inputPeak);
-	MacroConditionAudio *c = static_cast<MacroConditionAudio *>(data);
+	if (_measurement == AudioMeasurement::VOLUME || !_audioSource) {
+		_audioLevel.SetSource(_audioSource);
+		_loudnessMeter.reset();
+		return;
+	}
 
-	for (int i = 0; i < MAX_AUDIO_CHANNELS; i++) {
-		if (peak[i] > c->_peak) {
-			c->_peak = peak[i];
-		}
+	_audioLevel.SetSource(nullptr);
+	auto type = _measurement == AudioMeasurement::LUFS ? LoudnessType::LUFS
+							   : LoudnessType::RMS;
+	if (_loudnessMeter &&
+	    _loudnessMeter->GetSource() == (obs_weak_source_t *)_audioSource &&
+	    _loudnessMeter->GetType() == type &&
+	    _loudnessMeter->GetWindow() == _window) {
+		return;
 	}
+	_loudnessMeter = GetAudioLoudnessMeter(_audioSource, type, _window);
 }
 
-void MacroConditionAudio::ResetVolmeter()
+static inline void populateConditionSelection(QComboBox *list)
 {
-	obs_volmeter_remove_callback(_volmeter, SetVolumeLevel, this);
-	obs_volmeter_destroy(_volmeter);
-
-	_volmeter = AddVolmeterToSource(this, _audioSource);
+	for (auto entry : audioConditionTypes) {
+		list->addItem(obs_module_text(entry.second.c_str()));
+	}
 }
 
-static inline void populateConditionSelection(QComboBox *list)
+static inline void populateMeasurementSelection(QComboBox *list)
 {
-	for (auto entry : audioConditionTypes) {
+	for (auto entry : audioMeasurementTypes) {
 		list->addItem(obs_module_text(entry.second.c_str()));
 	}
 }
@@ -120,6 +128,19 @@ MacroConditionAudioEdit::MacroConditionAudioEdit(
 	_volume->setMaximum(100);
 	_volume->setMinimum(0);
 
+	_measurement = new QComboBox();
+	_threshold = new QDoubleSpinBox();
+	_window = new QSpinBox();
+	_windowSettings = new QWidget();
+
+	_threshold->setMinimum(-100.);
+	_threshold->setMaximum(0.);
+	_threshold->setDecimals(1);
+	_threshold->setSuffix("dB");
+	_window->setMinimum(10);
+	_window->setMaximum(60000);
+	_window->setSuffix("ms");
+
 	QWidget::connect(_volume, SIGNAL(valueChanged(int)), this,
 			 SLOT(VolumeThresholdChanged(int)));
 	QWidget::connect(_condition, SIGNAL(currentIndexChanged(int)), this,
@@ -127,22 +148,41 @@ MacroConditionAudioEdit::MacroConditionAudioEdit(
 	QWidget::connect(_audioSources,
 			 SIGNAL(currentTextChanged(const QString &)), this,
 			 SLOT(SourceChanged(const QString &)));
+	QWidget::connect(_measurement, SIGNAL(currentIndexChanged(int)), this,
+			 SLOT(MeasurementChanged(int)));
+	QWidget::connect(_threshold, SIGNAL(valueChanged(double)), this,
+			 SLOT(ThresholdChanged(double)));
+	// Changing the window recreates the loudness meter, so only apply it
+	// once editing is done instead of on every step
+	QWidget::connect(_window, SIGNAL(editingFinished()), this,
+			 SLOT(WindowChanged()));
 
 	populateAudioSelection(_audioSources);
 	populateConditionSelection(_condition);
+	populateMeasurementSelection(_measurement);
 
 	QHBoxLayout *switchLayout = new QHBoxLayout;
+	QHBoxLayout *windowLayout = new QHBoxLayout;
 	std::unordered_map<std::string, QWidget *> widgetPlaceholders = {
 		{"{{audioSources}}", _audioSources},
 		{"{{volume}}", _volume},
 		{"{{condition}}", _condition},
+		{"{{measurement}}", _measurement},
+		{"{{threshold}}", _threshold},
+		{"{{window}}", _window},
 	};
 	placeWidgets(obs_module_text("AdvSceneSwitcher.condition.audio.entry"),
 		     switchLayout, widgetPlaceholders);
+	placeWidgets(obs_module_text(
+			     "AdvSceneSwitcher.condition.audio.entry.window"),
+		     windowLayout, widgetPlaceholders);
+	windowLayout->setContentsMargins(0, 0, 0, 0);
+	_windowSettings->setLayout(windowLayout);
 
 	QVBoxLayout *mainLayout = new QVBoxLayout;
 
 	mainLayout->addLayout(switchLayout);
+	mainLayout->addWidget(_windowSettings);
 
 	setLayout(mainLayout);
 
@@ -169,6 +209,18 @@ void MacroConditionAudioEdit::UpdateVolmeterSource()
 
 	// Slider will default to 0 so set it manually once
 	_volMeter->GetSlider()->setValue(_entryData->_volume);
+	SetWidgetVisibility();
+}
+
+void MacroConditionAudioEdit::SetWidgetVisibility()
+{
+	bool volume = _entryData->_measurement == AudioMeasurement::VOLUME;
+	_volume->setVisible(volume);
+	if (_volMeter) {
+		_volMeter->setVisible(volume);
+	}
+	_threshold->setVisible(!volume);
+	_windowSettings->setVisible(!volume);
 }
 
 void MacroConditionAudioEdit::SourceChanged(const QString &text)
@@ -203,6 +255,41 @@ void MacroConditionAudioEdit::ConditionChanged(int cond)
 	_entryData->_condition = static_cast<AudioCondition>(cond);
 }
 
+void MacroConditionAudioEdit::MeasurementChanged(int value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(switcher->m);
+		_entryData->_measurement = static_cast<AudioMeasurement>(value);
+		_entryData->ResetVolmeter();
+	}
+	SetWidgetVisibility();
+}
+
+void MacroConditionAudioEdit::ThresholdChanged(double value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_threshold = value;
+}
+
+void MacroConditionAudioEdit::WindowChanged()
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_window = _window->value();
+	_entryData->ResetVolmeter();
+}
+
 void MacroConditionAudioEdit::UpdateEntryData()
 {
 	if (!_entryData) {
@@ -213,5 +300,9 @@ void MacroConditionAudioEdit::UpdateEntryData()
 		GetWeakSourceName(_entryData->_audioSource).c_str());
 	_volume->setValue(_entryData->_volume);
 	_condition->setCurrentIndex(static_cast<int>(_entryData->_condition));
+	_measurement->setCurrentIndex(
+		static_cast<int>(_entryData->_measurement));
+	_threshold->setValue(_entryData->_threshold);
+	_window->setValue(_entryData->_window);
 	UpdateVolmeterSource();
 }
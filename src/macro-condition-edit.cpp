@@ -183,6 +183,7 @@ void MacroConditionEdit::ConditionSelectionChanged(const QString &text)
 	_entryData->reset();
 	*_entryData = MacroConditionFactory::Create(id);
 	(*_entryData)->SetLogicType(logic);
+	switcher->macroDependenciesChanged = true;
 	auto widget =
 		MacroConditionFactory::CreateWidget(id, window(), *_entryData);
 	_section->SetContent(widget, false);
@@ -250,6 +251,7 @@ void AdvSceneSwitcher::on_conditionRemove_clicked()
 		return;
 	}
 	macro->Conditions().pop_back();
+	switcher->macroDependenciesChanged = true;
 
 	int count = ui->macroEditConditionLayout->count();
 	auto item = ui->macroEditConditionLayout->takeAt(count - 1);
@@ -35,8 +35,8 @@ static std::map<CounterCondition, std::string> counterConditionTypes = {
 bool MacroConditionMacro::CheckStateCondition()
 {
 	// Note:
-	// Depending on the order the macro conditions are checked Matched() might
-	// still return the state of the previous interval
+	// Referenced macros are checked first so Matched() already returns the
+	// state of the current interval unless the macros form a cycle
 	return _macro->Matched();
 }
 
@@ -246,6 +246,7 @@ void MacroConditionMacroEdit::MacroChanged(const QString &text)
 
 	std::lock_guard<std::mutex> lock(switcher->m);
 	_entryData->_macro.UpdateRef(text);
+	switcher->macroDependenciesChanged = true;
 	ResetTimer();
 }
 
@@ -273,7 +274,9 @@ void MacroConditionMacroEdit::MacroRemove(const QString &name)
 {
 	UNUSED_PARAMETER(name);
 	if (_entryData) {
+		std::lock_guard<std::mutex> lock(switcher->m);
 		_entryData->_macro.UpdateRef();
+		switcher->macroDependenciesChanged = true;
 	}
 }
 
@@ -0,0 +1,125 @@
+#include "headers/macro-condition-edit.hpp"
+#include "headers/macro-condition-osc.hpp"
+#include "headers/utility.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+
+#include <cstring>
+
+const std::string MacroConditionOSC::id = "osc";
+
+bool MacroConditionOSC::_registered = MacroConditionFactory::Register(
+	MacroConditionOSC::id,
+	{MacroConditionOSC::Create, MacroConditionOSCEdit::Create,
+	 "AdvSceneSwitcher.condition.osc"});
+
+MacroConditionOSC::MacroConditionOSC()
+{
+	// Only react to messages received after the condition was created
+	_sequence = switcher->oscListener.Sequence();
+}
+
+bool MacroConditionOSC::CheckCondition()
+{
+	auto &listener = switcher->oscListener;
+	uint64_t sequence = listener.Sequence();
+	if (sequence - _sequence > osc_message_history) {
+		_sequence = sequence - osc_message_history;
+	}
+
+	// Both the address of the message and the configured address may be
+	// patterns
+	bool match = false;
+	OSCMessageRecord record;
+	for (uint64_t seq = _sequence + 1; seq <= sequence && !match; seq++) {
+		if (!listener.GetMessage(seq, record)) {
+			continue;
+		}
+		if (!OSCPatternMatch(record.address, _address.c_str()) &&
+		    !OSCPatternMatch(_address.c_str(), record.address)) {
+			continue;
+		}
+		match = _value.empty() || strcmp(record.value, _value.c_str()) == 0;
+	}
+	_sequence = sequence;
+	return match;
+}
+
+bool MacroConditionOSC::Save(obs_data_t *obj)
+{
+	MacroCondition::Save(obj);
+	obs_data_set_string(obj, "address", _address.c_str());
+	obs_data_set_string(obj, "value", _value.c_str());
+	return true;
+}
+
+bool MacroConditionOSC::Load(obs_data_t *obj)
+{
+	MacroCondition::Load(obj);
+	_address = obs_data_get_string(obj, "address");
+	_value = obs_data_get_string(obj, "value");
+	return true;
+}
+
+MacroConditionOSCEdit::MacroConditionOSCEdit(
+	QWidget *parent, std::shared_ptr<MacroConditionOSC> entryData)
+	: QWidget(parent)
+{
+	_address = new QLineEdit();
+	_value = new QLineEdit();
+	_value->setPlaceholderText(
+		obs_module_text("AdvSceneSwitcher.condition.osc.anyValue"));
+	QLabel *hint = new QLabel(
+		obs_module_text("AdvSceneSwitcher.condition.osc.tip"));
+
+	QWidget::connect(_address, SIGNAL(editingFinished()), this,
+			 SLOT(AddressChanged()));
+	QWidget::connect(_value, SIGNAL(editingFinished()), this,
+			 SLOT(ValueChanged()));
+
+	QHBoxLayout *entryLayout = new QHBoxLayout;
+	std::unordered_map<std::string, QWidget *> widgetPlaceholders = {
+		{"{{address}}", _address},
+		{"{{value}}", _value},
+	};
+	placeWidgets(obs_module_text("AdvSceneSwitcher.condition.osc.entry"),
+		     entryLayout, widgetPlaceholders);
+
+	QVBoxLayout *mainLayout = new QVBoxLayout;
+	mainLayout->addLayout(entryLayout);
+	mainLayout->addWidget(hint);
+	setLayout(mainLayout);
+
+	_entryData = entryData;
+	UpdateEntryData();
+	_loading = false;
+}
+
+void MacroConditionOSCEdit::AddressChanged()
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_address = _address->text().toStdString();
+}
+
+void MacroConditionOSCEdit::ValueChanged()
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_value = _value->text().toStdString();
+}
+
+void MacroConditionOSCEdit::UpdateEntryData()
+{
+	if (!_entryData) {
+		return;
+	}
+
+	_address->setText(QString::fromStdString(_entryData->_address));
+	_value->setText(QString::fromStdString(_entryData->_value));
+}
@@ -0,0 +1,246 @@
+#include "headers/macro-condition-edit.hpp"
+#include "headers/macro-condition-video-hash.hpp"
+#include "headers/utility.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+
+#include <QFileDialog>
+#include <algorithm>
+
+const std::string MacroConditionVideoHash::id = "video_hash";
+
+bool MacroConditionVideoHash::_registered = MacroConditionFactory::Register(
+	MacroConditionVideoHash::id,
+	{MacroConditionVideoHash::Create, MacroConditionVideoHashEdit::Create,
+	 "AdvSceneSwitcher.condition.videoHash"});
+
+bool MacroConditionVideoHash::CheckCondition()
+{
+	if (!_library) {
+		return false;
+	}
+
+	if (!_frameReader.IsReading(_videoSource)) {
+		ResetFrameGrabber();
+	}
+
+	auto frame = _frameReader.ReadNewFrame();
+	if (!frame) {
+		return _lastMatch;
+	}
+	if (frame->image.isNull()) {
+		_lastMatch = false;
+		return false;
+	}
+
+	int distance = 0;
+	auto hash = GetFrameValue<ImageHash>(*frame, ComputeImageHash);
+	auto matches = _library->Lookup(hash, _maxDistance, &distance);
+	if (matches.empty()) {
+		_lastMatch = false;
+	} else {
+		_lastMatch = _reference.empty() ||
+			     std::find(matches.begin(), matches.end(),
+				       _reference) != matches.end();
+		vblog(LOG_INFO, "closest reference image is '%s' (distance %d)",
+		      matches.front().c_str(), distance);
+	}
+	return _lastMatch;
+}
+
+bool MacroConditionVideoHash::Save(obs_data_t *obj)
+{
+	MacroCondition::Save(obj);
+	obs_data_set_string(obj, "videoSource",
+			    GetWeakSourceName(_videoSource).c_str());
+	obs_data_set_string(obj, "folder", _folder.c_str());
+	obs_data_set_string(obj, "reference", _reference.c_str());
+	obs_data_set_int(obj, "maxDistance", _maxDistance);
+	return true;
+}
+
+bool MacroConditionVideoHash::Load(obs_data_t *obj)
+{
+	MacroCondition::Load(obj);
+	const char *videoSourceName = obs_data_get_string(obj, "videoSource");
+	_videoSource = GetWeakSourceByName(videoSourceName);
+	_folder = obs_data_get_string(obj, "folder");
+	_reference = obs_data_get_string(obj, "reference");
+	obs_data_set_default_int(obj, "maxDistance", default_hash_distance);
+	_maxDistance = obs_data_get_int(obj, "maxDistance");
+	ResetFrameGrabber();
+	SetLibrary(GetReferenceImageLibrary(_folder));
+	return true;
+}
+
+void MacroConditionVideoHash::ResetFrameGrabber()
+{
+	_frameReader.SetSource(_videoSource);
+	_lastMatch = false;
+}
+
+void MacroConditionVideoHash::SetLibrary(
+	std::shared_ptr<ReferenceImageLibrary> library)
+{
+	_library = library;
+	_frameReader.ResetFrame();
+	_lastMatch = false;
+}
+
+MacroConditionVideoHashEdit::MacroConditionVideoHashEdit(
+	QWidget *parent, std::shared_ptr<MacroConditionVideoHash> entryData)
+	: QWidget(parent)
+{
+	_videoSelection = new QComboBox();
+	_folder = new QLineEdit();
+	_browseButton =
+		new QPushButton(obs_module_text("AdvSceneSwitcher.browse"));
+	_reference = new QComboBox();
+	_maxDistance = new QSpinBox();
+
+	_folder->setFixedWidth(100);
+	_browseButton->setStyleSheet("border:1px solid gray;");
+	_maxDistance->setMinimum(0);
+	_maxDistance->setMaximum(64);
+	_maxDistance->setToolTip(obs_module_text(
+		"AdvSceneSwitcher.condition.videoHash.maxDistance.tooltip"));
+
+	QWidget::connect(_videoSelection,
+			 SIGNAL(currentTextChanged(const QString &)), this,
+			 SLOT(SourceChanged(const QString &)));
+	QWidget::connect(_folder, SIGNAL(editingFinished()), this,
+			 SLOT(FolderChanged()));
+	QWidget::connect(_browseButton, SIGNAL(clicked()), this,
+			 SLOT(BrowseButtonClicked()));
+	QWidget::connect(_reference, SIGNAL(currentIndexChanged(int)), this,
+			 SLOT(ReferenceChanged(int)));
+	QWidget::connect(_maxDistance, SIGNAL(valueChanged(int)), this,
+			 SLOT(MaxDistanceChanged(int)));
+
+	populateVideoSelection(_videoSelection);
+
+	QHBoxLayout *mainLayout = new QHBoxLayout;
+	std::unordered_map<std::string, QWidget *> widgetPlaceholders = {
+		{"{{videoSources}}", _videoSelection},
+		{"{{folder}}", _folder},
+		{"{{browseButton}}", _browseButton},
+		{"{{reference}}", _reference},
+		{"{{maxDistance}}", _maxDistance},
+	};
+	placeWidgets(
+		obs_module_text("AdvSceneSwitcher.condition.videoHash.entry"),
+		mainLayout, widgetPlaceholders);
+	setLayout(mainLayout);
+
+	_entryData = entryData;
+	UpdateEntryData();
+	_loading = false;
+}
+
+void MacroConditionVideoHashEdit::PopulateReferenceSelection()
+{
+	const QSignalBlocker b(_reference);
+	_reference->clear();
+	_reference->addItem(obs_module_text(
+		"AdvSceneSwitcher.condition.videoHash.anyReference"));
+
+	auto library = _entryData->GetLibrary();
+	if (!library) {
+		return;
+	}
+	for (const auto &name : library->Names()) {
+		_reference->addItem(QString::fromStdString(name));
+	}
+
+	if (_entryData->_reference.empty()) {
+		_reference->setCurrentIndex(0);
+	} else {
+		_reference->setCurrentText(
+			QString::fromStdString(_entryData->_reference));
+	}
+}
+
+void MacroConditionVideoHashEdit::SourceChanged(const QString &text)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_videoSource = GetWeakSourceByQString(text);
+	_entryData->ResetFrameGrabber();
+}
+
+void MacroConditionVideoHashEdit::FolderChanged()
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	// Loading the reference images might take a while so avoid blocking
+	// the switcher thread in the meantime
+	std::string folder = _folder->text().toUtf8().constData();
+	auto library = GetReferenceImageLibrary(folder, true);
+	{
+		std::lock_guard<std::mutex> lock(switcher->m);
+		_entryData->_folder = folder;
+		_entryData->SetLibrary(library);
+	}
+	PopulateReferenceSelection();
+}
+
+void MacroConditionVideoHashEdit::BrowseButtonClicked()
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	QString path = QFileDialog::getExistingDirectory(
+		this,
+		tr(obs_module_text(
+			"AdvSceneSwitcher.condition.videoHash.selectFolder")),
+		QString::fromStdString(_entryData->_folder));
+	if (path.isEmpty()) {
+		return;
+	}
+
+	_folder->setText(path);
+	FolderChanged();
+}
+
+void MacroConditionVideoHashEdit::ReferenceChanged(int idx)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	if (idx <= 0) {
+		_entryData->_reference = "";
+	} else {
+		_entryData->_reference =
+			_reference->itemText(idx).toStdString();
+	}
+}
+
+void MacroConditionVideoHashEdit::MaxDistanceChanged(int value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_maxDistance = value;
+}
+
+void MacroConditionVideoHashEdit::UpdateEntryData()
+{
+	if (!_entryData) {
+		return;
+	}
+
+	_videoSelection->setCurrentText(
+		GetWeakSourceName(_entryData->_videoSource).c_str());
+	_folder->setText(QString::fromStdString(_entryData->_folder));
+	_maxDistance->setValue(_entryData->_maxDistance);
+	PopulateReferenceSelection();
+}
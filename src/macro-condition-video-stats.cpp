@@ -0,0 +1,269 @@
+#include "headers/macro-condition-edit.hpp"
+#include "headers/macro-condition-video-stats.hpp"
+#include "headers/utility.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+
+#include <QColorDialog>
+#include <cmath>
+
+const std::string MacroConditionVideoStats::id = "video_stats";
+
+bool MacroConditionVideoStats::_registered = MacroConditionFactory::Register(
+	MacroConditionVideoStats::id,
+	{MacroConditionVideoStats::Create, MacroConditionVideoStatsEdit::Create,
+	 "AdvSceneSwitcher.condition.videoStats"});
+
+static std::map<VideoStatsCondition, std::string> conditionTypes = {
+	{VideoStatsCondition::BRIGHTNESS_ABOVE,
+	 "AdvSceneSwitcher.condition.videoStats.condition.brightnessAbove"},
+	{VideoStatsCondition::BRIGHTNESS_BELOW,
+	 "AdvSceneSwitcher.condition.videoStats.condition.brightnessBelow"},
+	{VideoStatsCondition::UNIFORM,
+	 "AdvSceneSwitcher.condition.videoStats.condition.uniform"},
+	{VideoStatsCondition::COLOR_SIMILAR,
+	 "AdvSceneSwitcher.condition.videoStats.condition.colorSimilar"},
+	{VideoStatsCondition::CHANGED_MORE,
+	 "AdvSceneSwitcher.condition.videoStats.condition.changedMore"},
+	{VideoStatsCondition::CHANGED_LESS,
+	 "AdvSceneSwitcher.condition.videoStats.condition.changedLess"},
+};
+
+static inline double toPercent(double value)
+{
+	return value / 255. * 100.;
+}
+
+bool MacroConditionVideoStats::CheckCondition()
+{
+	if (!_frameReader.IsReading(_videoSource)) {
+		ResetFrameGrabber();
+	}
+
+	auto frame = _frameReader.ReadNewFrame();
+	if (!frame) {
+		return _lastMatch;
+	}
+
+	const auto &stats = GetFrameValue<ImageStats>(
+		*frame, [](const QImage &image) {
+			return ComputeImageStats(image);
+		});
+	if (!stats.valid) {
+		_lastMatch = false;
+		return false;
+	}
+
+	_lastMatch = Compare(stats);
+	_previousStats = stats;
+	return _lastMatch;
+}
+
+bool MacroConditionVideoStats::Compare(const ImageStats &stats)
+{
+	switch (_condition) {
+	case VideoStatsCondition::BRIGHTNESS_ABOVE:
+		return toPercent(stats.luminance) > _value;
+	case VideoStatsCondition::BRIGHTNESS_BELOW:
+		return toPercent(stats.luminance) < _value;
+	case VideoStatsCondition::UNIFORM:
+		return toPercent(std::sqrt(std::max(
+			       stats.luminanceVariance, 0.))) <= _value;
+	case VideoStatsCondition::COLOR_SIMILAR: {
+		const int target[3] = {_color.red(), _color.green(),
+				       _color.blue()};
+		for (int i = 0; i < 3; i++) {
+			if (toPercent(std::abs(stats.mean[i] - target[i])) >
+			    _value) {
+				return false;
+			}
+		}
+		return true;
+	}
+	case VideoStatsCondition::CHANGED_MORE:
+		return _previousStats.valid &&
+		       HistogramDistance(stats, _previousStats) * 100. > _value;
+	case VideoStatsCondition::CHANGED_LESS:
+		return _previousStats.valid &&
+		       HistogramDistance(stats, _previousStats) * 100. < _value;
+	default:
+		break;
+	}
+	return false;
+}
+
+bool MacroConditionVideoStats::Save(obs_data_t *obj)
+{
+	MacroCondition::Save(obj);
+	obs_data_set_string(obj, "videoSource",
+			    GetWeakSourceName(_videoSource).c_str());
+	obs_data_set_int(obj, "condition", static_cast<int>(_condition));
+	obs_data_set_double(obj, "value", _value);
+	obs_data_set_int(obj, "color", _color.rgb());
+	obs_data_set_int(obj, "sampleInterval", _sampleInterval);
+	return true;
+}
+
+bool MacroConditionVideoStats::Load(obs_data_t *obj)
+{
+	MacroCondition::Load(obj);
+	const char *videoSourceName = obs_data_get_string(obj, "videoSource");
+	_videoSource = GetWeakSourceByName(videoSourceName);
+	_condition = static_cast<VideoStatsCondition>(
+		obs_data_get_int(obj, "condition"));
+	_value = obs_data_get_double(obj, "value");
+	_color = QColor::fromRgb((QRgb)obs_data_get_int(obj, "color"));
+	obs_data_set_default_int(obj, "sampleInterval",
+				 default_frame_grab_interval);
+	_sampleInterval = obs_data_get_int(obj, "sampleInterval");
+	ResetFrameGrabber();
+	return true;
+}
+
+void MacroConditionVideoStats::ResetFrameGrabber()
+{
+	_frameReader.SetSource(_videoSource, _sampleInterval);
+	_lastMatch = false;
+	_previousStats = {};
+}
+
+static inline void populateConditionSelection(QComboBox *list)
+{
+	for (auto entry : conditionTypes) {
+		list->addItem(obs_module_text(entry.second.c_str()));
+	}
+}
+
+MacroConditionVideoStatsEdit::MacroConditionVideoStatsEdit(
+	QWidget *parent, std::shared_ptr<MacroConditionVideoStats> entryData)
+	: QWidget(parent)
+{
+	_videoSelection = new QComboBox();
+	_condition = new QComboBox();
+	_value = new QDoubleSpinBox();
+	_color = new QPushButton();
+	_sampleInterval = new QSpinBox();
+
+	_value->setMinimum(0.);
+	_value->setMaximum(100.);
+	_value->setSuffix("%");
+	_sampleInterval->setMinimum(1);
+	_sampleInterval->setMaximum(10000);
+	_sampleInterval->setSuffix("ms");
+
+	QWidget::connect(_videoSelection,
+			 SIGNAL(currentTextChanged(const QString &)), this,
+			 SLOT(SourceChanged(const QString &)));
+	QWidget::connect(_condition, SIGNAL(currentIndexChanged(int)), this,
+			 SLOT(ConditionChanged(int)));
+	QWidget::connect(_value, SIGNAL(valueChanged(double)), this,
+			 SLOT(ValueChanged(double)));
+	QWidget::connect(_color, SIGNAL(clicked()), this,
+			 SLOT(ColorButtonClicked()));
+	QWidget::connect(_sampleInterval, SIGNAL(valueChanged(int)), this,
+			 SLOT(SampleIntervalChanged(int)));
+
+	populateVideoSelection(_videoSelection);
+	populateConditionSelection(_condition);
+
+	QHBoxLayout *mainLayout = new QHBoxLayout;
+	std::unordered_map<std::string, QWidget *> widgetPlaceholders = {
+		{"{{videoSources}}", _videoSelection},
+		{"{{condition}}", _condition},
+		{"{{value}}", _value},
+		{"{{color}}", _color},
+		{"{{sampleInterval}}", _sampleInterval},
+	};
+	placeWidgets(
+		obs_module_text("AdvSceneSwitcher.condition.videoStats.entry"),
+		mainLayout, widgetPlaceholders);
+	setLayout(mainLayout);
+
+	_entryData = entryData;
+	UpdateEntryData();
+	_loading = false;
+}
+
+void MacroConditionVideoStatsEdit::UpdateColorButton()
+{
+	_color->setStyleSheet(QString("background-color: %1;")
+				      .arg(_entryData->_color.name()));
+	_color->setVisible(_entryData->_condition ==
+			   VideoStatsCondition::COLOR_SIMILAR);
+}
+
+void MacroConditionVideoStatsEdit::SourceChanged(const QString &text)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_videoSource = GetWeakSourceByQString(text);
+	_entryData->ResetFrameGrabber();
+}
+
+void MacroConditionVideoStatsEdit::ConditionChanged(int cond)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(switcher->m);
+		_entryData->_condition = static_cast<VideoStatsCondition>(cond);
+	}
+	UpdateColorButton();
+}
+
+void MacroConditionVideoStatsEdit::ValueChanged(double value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_value = value;
+}
+
+void MacroConditionVideoStatsEdit::ColorButtonClicked()
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	QColor color = QColorDialog::getColor(_entryData->_color, this);
+	if (!color.isValid()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(switcher->m);
+		_entryData->_color = color;
+	}
+	UpdateColorButton();
+}
+
+void MacroConditionVideoStatsEdit::SampleIntervalChanged(int value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_sampleInterval = value;
+	_entryData->ResetFrameGrabber();
+}
+
+void MacroConditionVideoStatsEdit::UpdateEntryData()
+{
+	if (!_entryData) {
+		return;
+	}
+
+	_videoSelection->setCurrentText(
+		GetWeakSourceName(_entryData->_videoSource).c_str());
+	_condition->setCurrentIndex(static_cast<int>(_entryData->_condition));
+	_value->setValue(_entryData->_value);
+	_sampleInterval->setValue(_entryData->_sampleInterval);
+	UpdateColorButton();
+}
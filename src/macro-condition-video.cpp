@@ -26,30 +26,35 @@ static std::map<VideoCondition, std::string> conditionTypes = {
 	 "AdvSceneSwitcher.condition.video.condition.hasChanged"},
 	{VideoCondition::NO_IMAGE,
 	 "AdvSceneSwitcher.condition.video.condition.noImage"},
+	{VideoCondition::PATTERN,
+	 "AdvSceneSwitcher.condition.video.condition.pattern"},
 };
 
 bool requiresFileInput(VideoCondition t)
 {
-	return t == VideoCondition::MATCH || t == VideoCondition::DIFFER;
+	return t == VideoCondition::MATCH || t == VideoCondition::DIFFER ||
+	       t == VideoCondition::PATTERN;
 }
 
 bool MacroConditionVideo::CheckCondition()
 {
-	bool match = false;
-
-	if (_screenshotData) {
-		if (_screenshotData->done) {
-			match = Compare();
+	if (!_frameReader.IsReading(_videoSource)) {
+		ResetFrameGrabber();
+	}
 
-			if (!requiresFileInput(_condition)) {
-				_matchImage = std::move(_screenshotData->image);
-			}
-			_screenshotData.reset(nullptr);
-		}
+	// No new frame available since the last check
+	auto frame = _frameReader.ReadNewFrame();
+	if (!frame) {
+		return _lastMatch;
 	}
 
-	GetScreenshot();
-	return match;
+	_lastMatch = Compare(frame->image);
+
+	if (!requiresFileInput(_condition)) {
+		// Implicitly shared so no copy of the image data is made
+		_matchImage = frame->image;
+	}
+	return _lastMatch;
 }
 
 bool MacroConditionVideo::Save(obs_data_t *obj)
@@ -59,6 +64,13 @@ bool MacroConditionVideo::Save(obs_data_t *obj)
 			    GetWeakSourceName(_videoSource).c_str());
 	obs_data_set_int(obj, "condition", static_cast<int>(_condition));
 	obs_data_set_string(obj, "filePath", _file.c_str());
+	obs_data_set_int(obj, "sampleInterval", _sampleInterval);
+	obs_data_set_double(obj, "patternThreshold", _patternThreshold);
+	obs_data_set_bool(obj, "useRegion", _useRegion);
+	obs_data_set_int(obj, "regionX", _region.x());
+	obs_data_set_int(obj, "regionY", _region.y());
+	obs_data_set_int(obj, "regionWidth", _region.width());
+	obs_data_set_int(obj, "regionHeight", _region.height());
 	return true;
 }
 
@@ -69,6 +81,19 @@ bool MacroConditionVideo::Load(obs_data_t *obj)
 	_condition =
 		static_cast<VideoCondition>(obs_data_get_int(obj, "condition"));
 	_file = obs_data_get_string(obj, "filePath");
+	obs_data_set_default_int(obj, "sampleInterval",
+				 default_frame_grab_interval);
+	_sampleInterval = obs_data_get_int(obj, "sampleInterval");
+	obs_data_set_default_double(obj, "patternThreshold", 0.8);
+	_patternThreshold = obs_data_get_double(obj, "patternThreshold");
+	_useRegion = obs_data_get_bool(obj, "useRegion");
+	obs_data_set_default_int(obj, "regionWidth", 100);
+	obs_data_set_default_int(obj, "regionHeight", 100);
+	_region = QRect(obs_data_get_int(obj, "regionX"),
+			obs_data_get_int(obj, "regionY"),
+			obs_data_get_int(obj, "regionWidth"),
+			obs_data_get_int(obj, "regionHeight"));
+	ResetFrameGrabber();
 
 	if (requiresFileInput(_condition)) {
 		(void)LoadImageFromFile();
@@ -76,11 +101,10 @@ bool MacroConditionVideo::Load(obs_data_t *obj)
 	return true;
 }
 
-void MacroConditionVideo::GetScreenshot()
+void MacroConditionVideo::ResetFrameGrabber()
 {
-	auto source = obs_weak_source_get_source(_videoSource);
-	_screenshotData = std::make_unique<AdvSSScreenshotObj>(source);
-	obs_source_release(source);
+	_frameReader.SetSource(_videoSource, _sampleInterval);
+	_lastMatch = false;
 }
 
 bool MacroConditionVideo::LoadImageFromFile()
@@ -92,22 +116,27 @@ bool MacroConditionVideo::LoadImageFromFile()
 	}
 	_matchImage =
 		_matchImage.convertToFormat(QImage::Format::Format_RGBX8888);
+	_patternMatcher.SetTemplate(_matchImage);
 	return true;
 }
 
-bool MacroConditionVideo::Compare()
+bool MacroConditionVideo::Compare(const QImage &frame)
 {
 	switch (_condition) {
 	case VideoCondition::MATCH:
-		return _screenshotData->image == _matchImage;
+		return frame == _matchImage;
 	case VideoCondition::DIFFER:
-		return _screenshotData->image != _matchImage;
+		return frame != _matchImage;
 	case VideoCondition::HAS_CHANGED:
-		return _screenshotData->image != _matchImage;
+		return frame != _matchImage;
 	case VideoCondition::HAS_NOT_CHANGED:
-		return _screenshotData->image == _matchImage;
+		return frame == _matchImage;
 	case VideoCondition::NO_IMAGE:
-		return _screenshotData->image.isNull();
+		return frame.isNull();
+	case VideoCondition::PATTERN:
+		return _patternMatcher.Match(frame,
+					     _useRegion ? _region : QRect()) >=
+		       _patternThreshold;
 	default:
 		break;
 	}
@@ -130,9 +159,34 @@ MacroConditionVideoEdit::MacroConditionVideoEdit(
 	_filePath = new QLineEdit();
 	_browseButton =
 		new QPushButton(obs_module_text("AdvSceneSwitcher.browse"));
+	_sampleInterval = new QSpinBox();
 
 	_filePath->setFixedWidth(100);
 
+	_sampleInterval->setMinimum(1);
+	_sampleInterval->setMaximum(10000);
+	_sampleInterval->setSuffix("ms");
+
+	_patternSettings = new QWidget();
+	_patternThreshold = new QDoubleSpinBox();
+	_useRegion = new QCheckBox(
+		obs_module_text("AdvSceneSwitcher.condition.video.useRegion"));
+	_regionX = new QSpinBox();
+	_regionY = new QSpinBox();
+	_regionW = new QSpinBox();
+	_regionH = new QSpinBox();
+
+	_patternThreshold->setMinimum(0.);
+	_patternThreshold->setMaximum(100.);
+	_patternThreshold->setSuffix("%");
+	for (auto spinBox : {_regionX, _regionY, _regionW, _regionH}) {
+		spinBox->setMinimum(0);
+		spinBox->setMaximum(100000);
+		spinBox->setSuffix("px");
+		QWidget::connect(spinBox, SIGNAL(valueChanged(int)), this,
+				 SLOT(RegionChanged()));
+	}
+
 	_browseButton->setStyleSheet("border:1px solid gray;");
 
 	QWidget::connect(_videoSelection,
@@ -144,19 +198,41 @@ MacroConditionVideoEdit::MacroConditionVideoEdit(
 			 SLOT(FilePathChanged()));
 	QWidget::connect(_browseButton, SIGNAL(clicked()), this,
 			 SLOT(BrowseButtonClicked()));
+	QWidget::connect(_sampleInterval, SIGNAL(valueChanged(int)), this,
+			 SLOT(SampleIntervalChanged(int)));
+	QWidget::connect(_patternThreshold, SIGNAL(valueChanged(double)), this,
+			 SLOT(PatternThresholdChanged(double)));
+	QWidget::connect(_useRegion, SIGNAL(stateChanged(int)), this,
+			 SLOT(UseRegionChanged(int)));
 
 	populateVideoSelection(_videoSelection);
 	populateConditionSelection(_condition);
 
-	QHBoxLayout *mainLayout = new QHBoxLayout;
+	QVBoxLayout *mainLayout = new QVBoxLayout;
 	std::unordered_map<std::string, QWidget *> widgetPlaceholders = {
 		{"{{videoSources}}", _videoSelection},
 		{"{{condition}}", _condition},
 		{"{{filePath}}", _filePath},
 		{"{{browseButton}}", _browseButton},
+		{"{{sampleInterval}}", _sampleInterval},
+		{"{{patternThreshold}}", _patternThreshold},
+		{"{{useRegion}}", _useRegion},
+		{"{{regionX}}", _regionX},
+		{"{{regionY}}", _regionY},
+		{"{{regionWidth}}", _regionW},
+		{"{{regionHeight}}", _regionH},
 	};
+	QHBoxLayout *line1Layout = new QHBoxLayout;
+	QHBoxLayout *line2Layout = new QHBoxLayout;
 	placeWidgets(obs_module_text("AdvSceneSwitcher.condition.video.entry"),
-		     mainLayout, widgetPlaceholders);
+		     line1Layout, widgetPlaceholders);
+	placeWidgets(obs_module_text(
+			     "AdvSceneSwitcher.condition.video.entry.pattern"),
+		     line2Layout, widgetPlaceholders);
+	line2Layout->setContentsMargins(0, 0, 0, 0);
+	_patternSettings->setLayout(line2Layout);
+	mainLayout->addLayout(line1Layout);
+	mainLayout->addWidget(_patternSettings);
 	setLayout(mainLayout);
 
 	_entryData = entryData;
@@ -204,6 +280,7 @@ void MacroConditionVideoEdit::SourceChanged(const QString &text)
 
 	std::lock_guard<std::mutex> lock(switcher->m);
 	_entryData->_videoSource = GetWeakSourceByQString(text);
+	_entryData->ResetFrameGrabber();
 }
 
 void MacroConditionVideoEdit::ConditionChanged(int cond)
@@ -214,14 +291,7 @@ void MacroConditionVideoEdit::ConditionChanged(int cond)
 
 	std::lock_guard<std::mutex> lock(switcher->m);
 	_entryData->_condition = static_cast<VideoCondition>(cond);
-
-	if (requiresFileInput(_entryData->_condition)) {
-		_filePath->show();
-		_browseButton->show();
-	} else {
-		_filePath->hide();
-		_browseButton->hide();
-	}
+	SetWidgetVisibility();
 
 	// Reload image data to avoid incorrect matches.
 	//
@@ -246,6 +316,63 @@ void MacroConditionVideoEdit::FilePathChanged()
 	}
 }
 
+void MacroConditionVideoEdit::SampleIntervalChanged(int value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_sampleInterval = value;
+	_entryData->ResetFrameGrabber();
+}
+
+void MacroConditionVideoEdit::PatternThresholdChanged(double value)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_patternThreshold = value / 100.;
+}
+
+void MacroConditionVideoEdit::UseRegionChanged(int state)
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(switcher->m);
+		_entryData->_useRegion = state;
+	}
+	SetWidgetVisibility();
+}
+
+void MacroConditionVideoEdit::RegionChanged()
+{
+	if (_loading || !_entryData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	_entryData->_region = QRect(_regionX->value(), _regionY->value(),
+				    _regionW->value(), _regionH->value());
+}
+
+void MacroConditionVideoEdit::SetWidgetVisibility()
+{
+	bool fileInput = requiresFileInput(_entryData->_condition);
+	_filePath->setVisible(fileInput);
+	_browseButton->setVisible(fileInput);
+	_patternSettings->setVisible(_entryData->_condition ==
+				     VideoCondition::PATTERN);
+	for (auto spinBox : {_regionX, _regionY, _regionW, _regionH}) {
+		spinBox->setEnabled(_entryData->_useRegion);
+	}
+}
+
 void MacroConditionVideoEdit::BrowseButtonClicked()
 {
 	if (_loading || !_entryData) {
@@ -318,9 +445,12 @@ void MacroConditionVideoEdit::UpdateEntryData()
 		GetWeakSourceName(_entryData->_videoSource).c_str());
 	_condition->setCurrentIndex(static_cast<int>(_entryData->_condition));
 	_filePath->setText(QString::fromStdString(_entryData->_file));
-
-	if (!requiresFileInput(_entryData->_condition)) {
-		_filePath->hide();
-		_browseButton->hide();
-	}
+	_sampleInterval->setValue(_entryData->_sampleInterval);
+	_patternThreshold->setValue(_entryData->_patternThreshold * 100.);
+	_useRegion->setChecked(_entryData->_useRegion);
+	_regionX->setValue(_entryData->_region.x());
+	_regionY->setValue(_entryData->_region.y());
+	_regionW->setValue(_entryData->_region.width());
+	_regionH->setValue(_entryData->_region.height());
+	SetWidgetVisibility();
 }
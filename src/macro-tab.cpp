@@ -11,6 +11,17 @@ static QMetaObject::Connection addPulse;
 const auto conditionsCollapseThreshold = 4;
 const auto actionsCollapseThreshold = 4;
 
+static std::map<MacroTriggerMode, std::string> triggerModes = {
+	{MacroTriggerMode::ALWAYS,
+	 "AdvSceneSwitcher.macroTab.triggerMode.always"},
+	{MacroTriggerMode::RISING_EDGE,
+	 "AdvSceneSwitcher.macroTab.triggerMode.risingEdge"},
+	{MacroTriggerMode::REPEAT_INTERVAL,
+	 "AdvSceneSwitcher.macroTab.triggerMode.repeatInterval"},
+	{MacroTriggerMode::ON_CHANGE,
+	 "AdvSceneSwitcher.macroTab.triggerMode.onChange"},
+};
+
 bool macroNameExists(std::string name)
 {
 	return !!GetMacroByName(name.c_str());
@@ -49,6 +60,7 @@ bool AdvSceneSwitcher::addNewMacro(std::string &name)
 	{
 		std::lock_guard<std::mutex> lock(switcher->m);
 		switcher->macros.emplace_back(name);
+		switcher->updateMacroIndex();
 	}
 	return true;
 }
@@ -85,6 +97,7 @@ void AdvSceneSwitcher::on_macroRemove_clicked()
 		int idx = ui->macros->currentRow();
 		QString::fromStdString(switcher->macros[idx].Name());
 		switcher->macros.erase(switcher->macros.begin() + idx);
+		switcher->updateMacroIndex();
 	}
 
 	delete item;
@@ -106,9 +119,7 @@ void AdvSceneSwitcher::on_macroUp_clicked()
 		iter_swap(switcher->macros.begin() + index,
 			  switcher->macros.begin() + index - 1);
 
-		for (auto &m : switcher->macros) {
-			m.ResolveMacroRef();
-		}
+		switcher->updateMacroIndex();
 	}
 }
 
@@ -123,9 +134,7 @@ void AdvSceneSwitcher::on_macroDown_clicked()
 		iter_swap(switcher->macros.begin() + index,
 			  switcher->macros.begin() + index + 1);
 
-		for (auto &m : switcher->macros) {
-			m.ResolveMacroRef();
-		}
+		switcher->updateMacroIndex();
 	}
 }
 
@@ -155,6 +164,7 @@ void AdvSceneSwitcher::on_macroName_editingFinished()
 		std::lock_guard<std::mutex> lock(switcher->m);
 		if (nameValid) {
 			macro->SetName(newName.toUtf8().constData());
+			switcher->updateMacroIndex();
 			QListWidgetItem *item = ui->macros->currentItem();
 			// Don't trigger itemChanged()
 			// pause state remains as is
@@ -169,9 +179,106 @@ void AdvSceneSwitcher::on_macroName_editingFinished()
 	emit MacroRenamed(oldName, newName);
 }
 
+void AdvSceneSwitcher::on_macroTriggerMode_currentIndexChanged(int idx)
+{
+	if (loading || idx == -1) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	Macro *macro = getSelectedMacro();
+	if (!macro) {
+		return;
+	}
+	auto mode = static_cast<MacroTriggerMode>(idx);
+	macro->SetTriggerMode(mode);
+	ui->macroRepeatInterval->setVisible(
+		mode == MacroTriggerMode::REPEAT_INTERVAL);
+}
+
+void AdvSceneSwitcher::on_macroRepeatInterval_valueChanged(double value)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	Macro *macro = getSelectedMacro();
+	if (!macro) {
+		return;
+	}
+	macro->SetRepeatInterval(value);
+}
+
+void AdvSceneSwitcher::updateMacroGroupWidgets(Macro &m)
+{
+	bool hasGroup = !m.Group().empty();
+	ui->macroGroupPaused->setEnabled(hasGroup);
+	ui->macroGroupExclusive->setEnabled(hasGroup);
+
+	MacroGroup group;
+	auto it = switcher->macroGroups.find(m.Group());
+	if (hasGroup && it != switcher->macroGroups.end()) {
+		group = it->second;
+	}
+	ui->macroGroupPaused->setChecked(group.paused);
+	ui->macroGroupExclusive->setChecked(group.exclusive);
+}
+
+void AdvSceneSwitcher::on_macroGroup_editingFinished()
+{
+	std::lock_guard<std::mutex> lock(switcher->m);
+	Macro *macro = getSelectedMacro();
+	if (!macro) {
+		return;
+	}
+	std::string group = ui->macroGroup->text().toStdString();
+	if (group == macro->Group()) {
+		return;
+	}
+	macro->SetGroup(group);
+	switcher->macroDependenciesChanged = true;
+	updateMacroGroupWidgets(*macro);
+}
+
+void AdvSceneSwitcher::on_macroGroupPaused_stateChanged(int state)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	Macro *macro = getSelectedMacro();
+	if (!macro || macro->Group().empty()) {
+		return;
+	}
+	switcher->macroGroups[macro->Group()].paused = state;
+}
+
+void AdvSceneSwitcher::on_macroGroupExclusive_stateChanged(int state)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	Macro *macro = getSelectedMacro();
+	if (!macro || macro->Group().empty()) {
+		return;
+	}
+	switcher->macroGroups[macro->Group()].exclusive = state;
+}
+
 void AdvSceneSwitcher::SetEditMacro(Macro &m)
 {
 	ui->macroName->setText(m.Name().c_str());
+	ui->macroRepeatInterval->setValue(m.GetRepeatInterval().seconds);
+	ui->macroTriggerMode->setCurrentIndex(
+		static_cast<int>(m.GetTriggerMode()));
+	ui->macroRepeatInterval->setVisible(
+		m.GetTriggerMode() == MacroTriggerMode::REPEAT_INTERVAL);
+	ui->macroGroup->setText(QString::fromStdString(m.Group()));
+	updateMacroGroupWidgets(m);
 	clearLayout(ui->macroEditConditionLayout);
 	clearLayout(ui->macroEditActionLayout);
 
@@ -279,6 +386,11 @@ void AdvSceneSwitcher::setupMacroTab()
 		ui->macroHelp->setVisible(false);
 	}
 
+	for (auto entry : triggerModes) {
+		ui->macroTriggerMode->addItem(
+			obs_module_text(entry.second.c_str()));
+	}
+
 	ui->macros->setContextMenuPolicy(Qt::CustomContextMenu);
 	connect(ui->macros, SIGNAL(customContextMenuRequested(QPoint)), this,
 		SLOT(showMacroContextMenu(QPoint)));
@@ -306,8 +418,12 @@ void AdvSceneSwitcher::copyMacro()
 		return;
 	}
 
-	switcher->macros.back().Load(data);
-	switcher->macros.back().SetName(name);
+	{
+		std::lock_guard<std::mutex> lock(switcher->m);
+		switcher->macros.back().Load(data);
+		switcher->macros.back().SetName(name);
+		switcher->updateMacroIndex();
+	}
 	obs_data_release(data);
 
 	QString text = QString::fromStdString(name);
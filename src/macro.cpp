@@ -4,7 +4,11 @@
 #include "headers/macro-condition-edit.hpp"
 #include "headers/macro-action-scene-switch.hpp"
 
+#include <util/platform.h>
 #include <limits>
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
 #undef max
 
 const std::map<LogicType, LogicTypeInfo> MacroCondition::logicTypes = {
@@ -17,10 +21,15 @@ const std::map<LogicType, LogicTypeInfo> MacroCondition::logicTypes = {
 	{LogicType::ROOT_NOT, {"AdvSceneSwitcher.logic.not"}},
 };
 
-Macro::Macro(const std::string &name)
+static uint64_t lastMacroId = 0;
+
+Macro::Macro(const std::string &name) : _id(++lastMacroId)
 {
-	SetupHotkeys();
-	SetName(name);
+	// Hotkeys are registered once the name is known, so macros which are
+	// about to be loaded do not have to register and rename them twice
+	if (!name.empty()) {
+		SetName(name);
+	}
 }
 
 Macro::~Macro()
@@ -28,15 +37,37 @@ Macro::~Macro()
 	ClearHotkeys();
 }
 
+// Results of stateless conditions checked within the current interval
+// keyed by their settings hash
+static std::unordered_map<size_t, bool> conditionResults;
+
+static bool checkCondition(MacroCondition *c)
+{
+	if (!c->IsStateless() || switcher->settingsWindowOpened) {
+		return c->CheckCondition();
+	}
+
+	auto it = conditionResults.find(c->GetSettingsHash());
+	if (it != conditionResults.end()) {
+		return it->second;
+	}
+	bool result = c->CheckCondition();
+	conditionResults.emplace(c->GetSettingsHash(), result);
+	return result;
+}
+
 bool Macro::CeckMatch()
 {
 	_matched = false;
+	_conditionResults.resize(_conditions.size());
+	size_t idx = 0;
 	for (auto &c : _conditions) {
-		bool cond = c->CheckCondition();
+		bool cond = checkCondition(c.get());
 		if (!cond) {
 			c->ResetDuration();
 		}
 		cond = cond && c->DurationReached();
+		_conditionResults[idx++] = cond;
 
 		switch (c->GetLogicType()) {
 		case LogicType::NONE:
@@ -83,12 +114,68 @@ bool Macro::CeckMatch()
 	if (_paused) {
 		vblog(LOG_INFO, "Macro %s is paused", _name.c_str());
 		_matched = false;
+		_triggered = false;
 		return false;
 	}
 
+	if (!_matched) {
+		_triggered = false;
+	}
 	return _matched;
 }
 
+void Macro::ResetMatch()
+{
+	_matched = false;
+	_triggered = false;
+}
+
+bool Macro::ShouldRunActions()
+{
+	auto now = std::chrono::high_resolution_clock::now();
+	switch (_triggerMode) {
+	case MacroTriggerMode::RISING_EDGE:
+		if (_triggered) {
+			return false;
+		}
+		break;
+	case MacroTriggerMode::REPEAT_INTERVAL:
+		if (_triggered &&
+		    now - _lastRun < std::chrono::duration<double>(
+					     _repeatInterval.seconds)) {
+			return false;
+		}
+		break;
+	case MacroTriggerMode::ON_CHANGE:
+		if (_triggered &&
+		    _conditionResults == _lastRunConditionResults) {
+			return false;
+		}
+		break;
+	default:
+		break;
+	}
+
+	_triggered = true;
+	_lastRun = now;
+	_lastRunConditionResults = _conditionResults;
+	return true;
+}
+
+void Macro::SetTriggerMode(MacroTriggerMode mode)
+{
+	if (_triggerMode == mode) {
+		return;
+	}
+	_triggerMode = mode;
+	_triggered = false;
+}
+
+void Macro::SetRepeatInterval(double seconds)
+{
+	_repeatInterval.seconds = seconds;
+}
+
 bool Macro::PerformAction()
 {
 	bool ret = true;
@@ -108,13 +195,20 @@ bool Macro::PerformAction()
 void Macro::SetName(const std::string &name)
 {
 	_name = name;
-	SetHotkeysDesc();
+	if (_pauseHotkey == OBS_INVALID_HOTKEY_ID) {
+		SetupHotkeys();
+	} else {
+		SetHotkeysDesc();
+	}
 }
 
 bool Macro::Save(obs_data_t *obj)
 {
 	obs_data_set_string(obj, "name", _name.c_str());
+	obs_data_set_string(obj, "group", _group.c_str());
 	obs_data_set_bool(obj, "pause", _paused);
+	obs_data_set_int(obj, "triggerMode", static_cast<int>(_triggerMode));
+	_repeatInterval.Save(obj, "repeatInterval", "repeatIntervalUnit");
 
 	obs_data_array_t *pauseHotkey = obs_hotkey_save(_pauseHotkey);
 	obs_data_set_array(obj, "pauseHotkey", pauseHotkey);
@@ -187,8 +281,17 @@ void setValidLogic(MacroCondition *c, bool root, std::string name)
 bool Macro::Load(obs_data_t *obj)
 {
 	_name = obs_data_get_string(obj, "name");
+	_group = obs_data_get_string(obj, "group");
 	_paused = obs_data_get_bool(obj, "pause");
+	_triggerMode = static_cast<MacroTriggerMode>(
+		obs_data_get_int(obj, "triggerMode"));
+	_repeatInterval.Load(obj, "repeatInterval", "repeatIntervalUnit");
 
+	if (_pauseHotkey == OBS_INVALID_HOTKEY_ID) {
+		SetupHotkeys();
+	} else {
+		SetHotkeysDesc();
+	}
 	obs_data_array_t *pauseHotkey = obs_data_get_array(obj, "pauseHotkey");
 	obs_hotkey_load(_pauseHotkey, pauseHotkey);
 	obs_data_array_release(pauseHotkey);
@@ -198,8 +301,6 @@ bool Macro::Load(obs_data_t *obj)
 	obs_hotkey_load(_unpauseHotkey, unpauseHotkey);
 	obs_data_array_release(unpauseHotkey);
 
-	SetHotkeysDesc();
-
 	bool root = true;
 	obs_data_array_t *conditions = obs_data_get_array(obj, "conditions");
 	size_t count = obs_data_array_count(conditions);
@@ -358,6 +459,26 @@ bool MacroCondition::Save(obs_data_t *obj)
 	return true;
 }
 
+void MacroCondition::UpdateSettingsHash()
+{
+	// The logic type and duration constraint do not influence the result
+	// of the check itself.
+	// Conditions might store their own settings using the same keys as the
+	// duration constraint, so save a default constraint instead of erasing
+	// its keys.
+	auto duration = _duration;
+	_duration = DurationConstraint();
+	obs_data_t *data = obs_data_create();
+	Save(data);
+	_duration = duration;
+	obs_data_erase(data, "id");
+	obs_data_erase(data, "logic");
+	// Conditions of different types might save the same settings
+	_settingsHash = std::hash<std::string>{}(GetId() + "\n" +
+						 obs_data_get_json(data));
+	obs_data_release(data);
+}
+
 bool MacroCondition::Load(obs_data_t *obj)
 {
 	_logic = static_cast<LogicType>(obs_data_get_int(obj, "logic"));
@@ -415,6 +536,25 @@ void SwitcherData::saveMacros(obs_data_t *obj)
 	}
 	obs_data_set_array(obj, "macros", macroArray);
 	obs_data_array_release(macroArray);
+
+	obs_data_array_t *groupArray = obs_data_array_create();
+	for (auto &g : macroGroups) {
+		bool used = std::any_of(macros.begin(), macros.end(),
+					[&g](Macro &m) {
+						return m.Group() == g.first;
+					});
+		if (!used) {
+			continue;
+		}
+		obs_data_t *array_obj = obs_data_create();
+		obs_data_set_string(array_obj, "name", g.first.c_str());
+		obs_data_set_bool(array_obj, "pause", g.second.paused);
+		obs_data_set_bool(array_obj, "exclusive", g.second.exclusive);
+		obs_data_array_push_back(groupArray, array_obj);
+		obs_data_release(array_obj);
+	}
+	obs_data_set_array(obj, "macroGroups", groupArray);
+	obs_data_array_release(groupArray);
 }
 
 // Temporary helper functions to convert old settings format to new one
@@ -482,35 +622,162 @@ void SwitcherData::loadMacros(obs_data_t *obj)
 		convertOldMacroIdsToString(obj);
 	}
 
+	uint64_t startTime = os_gettime_ns();
 	macros.clear();
+	updateMacroIndex();
 
 	obs_data_array_t *macroArray = obs_data_get_array(obj, "macros");
 	size_t count = obs_data_array_count(macroArray);
 
+	// Default constructed macros do not register any hotkeys yet
+	macros.resize(count);
 	for (size_t i = 0; i < count; i++) {
 		obs_data_t *array_obj = obs_data_array_item(macroArray, i);
-		macros.emplace_back();
-		macros.back().Load(array_obj);
+		macros[i].Load(array_obj);
 		obs_data_release(array_obj);
 	}
 	obs_data_array_release(macroArray);
 
+	macroGroups.clear();
+	obs_data_array_t *groupArray = obs_data_get_array(obj, "macroGroups");
+	size_t groupCount = obs_data_array_count(groupArray);
+	for (size_t i = 0; i < groupCount; i++) {
+		obs_data_t *array_obj = obs_data_array_item(groupArray, i);
+		auto &group =
+			macroGroups[obs_data_get_string(array_obj, "name")];
+		group.paused = obs_data_get_bool(array_obj, "pause");
+		group.exclusive = obs_data_get_bool(array_obj, "exclusive");
+		obs_data_release(array_obj);
+	}
+	obs_data_array_release(groupArray);
+
+	updateMacroIndex();
 	for (auto &m : macros) {
 		m.ResolveMacroRef();
 	}
+
+	vblog(LOG_INFO, "loaded %zu macros in %.1f ms", macros.size(),
+	      (os_gettime_ns() - startTime) / 1000000.);
+}
+
+void SwitcherData::updateMacroIndex()
+{
+	macroGeneration++;
+	macroNameIndex.clear();
+	macroIdIndex.clear();
+	macroNameIndex.reserve(macros.size());
+	macroIdIndex.reserve(macros.size());
+	for (size_t i = 0; i < macros.size(); i++) {
+		macroNameIndex[macros[i].Name()] = i;
+		macroIdIndex[macros[i].Id()] = i;
+	}
+	macroDependenciesChanged = true;
+}
+
+void SwitcherData::updateMacroCheckOrder()
+{
+	macroDependenciesChanged = false;
+	macroCheckOrder.clear();
+	macroCheckOrder.reserve(macros.size());
+
+	std::unordered_map<Macro *, size_t> indices;
+	for (size_t i = 0; i < macros.size(); i++) {
+		indices[&macros[i]] = i;
+	}
+
+	// Edges point from the referenced macro to the macro depending on it
+	std::vector<std::vector<size_t>> dependents(macros.size());
+	std::vector<size_t> pending(macros.size(), 0);
+	for (size_t i = 0; i < macros.size(); i++) {
+		for (auto &c : macros[i].Conditions()) {
+			auto ref = dynamic_cast<MacroRefCondition *>(c.get());
+			if (!ref) {
+				continue;
+			}
+			auto it = indices.find(ref->_macro.get());
+			if (it == indices.end() || it->second == i) {
+				continue;
+			}
+			dependents[it->second].push_back(i);
+			pending[i]++;
+		}
+	}
+
+	// Independent macros keep the order of the macro list
+	std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>>
+		ready;
+	for (size_t i = 0; i < macros.size(); i++) {
+		if (pending[i] == 0) {
+			ready.push(i);
+		}
+	}
+	while (!ready.empty()) {
+		size_t i = ready.top();
+		ready.pop();
+		macroCheckOrder.push_back(&macros[i]);
+		for (auto d : dependents[i]) {
+			if (--pending[d] == 0) {
+				ready.push(d);
+			}
+		}
+	}
+
+	// Macros which are part of or depend on a cycle are checked last and
+	// will see the state of the previous interval for some of their
+	// references
+	for (size_t i = 0; i < macros.size() &&
+			   macroCheckOrder.size() != macros.size();
+	     i++) {
+		if (pending[i] != 0) {
+			blog(LOG_WARNING,
+			     "macro '%s' depends on a dependency cycle",
+			     macros[i].Name().c_str());
+			macroCheckOrder.push_back(&macros[i]);
+		}
+	}
+
+	for (auto &m : macros) {
+		for (auto &c : m.Conditions()) {
+			if (c->IsStateless()) {
+				c->UpdateSettingsHash();
+			}
+		}
+	}
+
+	macroCheckGroups.clear();
+	macroCheckGroups.reserve(macroCheckOrder.size());
+	for (auto m : macroCheckOrder) {
+		const auto &group = m->Group();
+		macroCheckGroups.push_back(group.empty() ? nullptr
+							 : &macroGroups[group]);
+	}
 }
 
 bool SwitcherData::checkMacros()
 {
+	if (macroDependenciesChanged) {
+		updateMacroCheckOrder();
+	}
+
+	for (auto &g : macroGroups) {
+		g.second.matched = false;
+	}
+	conditionResults.clear();
+
 	bool ret = false;
-	for (auto &m : macros) {
-		if (m.CeckMatch()) {
-			ret = true;
-			// This has to be performed here for now as actions are
-			// not performed immediately after checking conditions.
-			if (m.SwitchesScene()) {
-				switcher->macroSceneSwitched = true;
+	for (size_t i = 0; i < macroCheckOrder.size(); i++) {
+		auto m = macroCheckOrder[i];
+		auto group = macroCheckGroups[i];
+		if (group && (group->paused ||
+			      (group->exclusive && group->matched))) {
+			m->ResetMatch();
+			continue;
+		}
+		if (m->CeckMatch()) {
+			if (group) {
+				group->matched = true;
 			}
+			ret = true;
 		}
 	}
 	return ret;
@@ -519,8 +786,11 @@ bool SwitcherData::checkMacros()
 bool SwitcherData::runMacros()
 {
 	for (auto &m : macros) {
-		if (m.Matched()) {
+		if (m.Matched() && m.ShouldRunActions()) {
 			vblog(LOG_INFO, "running macro: %s", m.Name().c_str());
+			if (m.SwitchesScene()) {
+				macroSceneSwitched = true;
+			}
 			if (!m.PerformAction()) {
 				blog(LOG_WARNING, "abort macro: %s",
 				     m.Name().c_str());
@@ -531,15 +801,34 @@ bool SwitcherData::runMacros()
 	return true;
 }
 
-Macro *GetMacroByName(const char *name)
+void SwitcherData::runRequestedMacros(const std::vector<Macro *> &requested)
 {
-	for (auto &m : switcher->macros) {
-		if (m.Name() == name) {
-			return &m;
+	for (auto m : requested) {
+		vblog(LOG_INFO, "running macro: %s", m->Name().c_str());
+		if (!m->PerformAction()) {
+			blog(LOG_WARNING, "abort macro: %s", m->Name().c_str());
 		}
 	}
+}
 
-	return nullptr;
+Macro *GetMacroByName(const char *name)
+{
+	auto it = switcher->macroNameIndex.find(name);
+	if (it == switcher->macroNameIndex.end() ||
+	    it->second >= switcher->macros.size()) {
+		return nullptr;
+	}
+	return &switcher->macros[it->second];
+}
+
+static Macro *getMacroById(uint64_t id)
+{
+	auto it = switcher->macroIdIndex.find(id);
+	if (it == switcher->macroIdIndex.end() ||
+	    it->second >= switcher->macros.size()) {
+		return nullptr;
+	}
+	return &switcher->macros[it->second];
 }
 
 Macro *GetMacroByQString(const QString &name)
@@ -554,6 +843,8 @@ MacroRef::MacroRef(std::string name) : _name(name)
 void MacroRef::UpdateRef()
 {
 	_ref = GetMacroByName(_name.c_str());
+	_id = _ref ? _ref->Id() : 0;
+	_generation = switcher->macroGeneration;
 }
 void MacroRef::UpdateRef(std::string newName)
 {
@@ -567,7 +858,7 @@ void MacroRef::UpdateRef(QString newName)
 }
 void MacroRef::Save(obs_data_t *obj)
 {
-	if (_ref) {
+	if (get()) {
 		obs_data_set_string(obj, "macro", _ref->Name().c_str());
 	}
 }
@@ -579,12 +870,19 @@ void MacroRef::Load(obs_data_t *obj)
 
 Macro *MacroRef::get()
 {
+	if (_generation != switcher->macroGeneration) {
+		_ref = _id ? getMacroById(_id) : nullptr;
+		if (_ref) {
+			_name = _ref->Name();
+		}
+		_generation = switcher->macroGeneration;
+	}
 	return _ref;
 }
 
 Macro *MacroRef::operator->()
 {
-	return _ref;
+	return get();
 }
 
 void MacroRefCondition::ResolveMacroRef()
@@ -0,0 +1,535 @@
+#include "headers/osc.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+#include "headers/utility.hpp"
+
+#include <util/platform.h>
+#include <cstring>
+#include <cstdio>
+
+#define OSC_SCENE "/advss/scene"
+#define OSC_PREVIEW "/advss/preview"
+#define OSC_MACRO "/advss/macro"
+
+// Maximum number of nested bundles to guard against malicious packets
+constexpr int osc_max_bundle_depth = 8;
+
+static uint32_t read32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	       ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint64_t read64(const uint8_t *p)
+{
+	return ((uint64_t)read32(p) << 32) | read32(p + 4);
+}
+
+// Returns the null terminated and 4 byte aligned string at p and advances p
+// past its padding
+static const char *readString(const uint8_t *&p, const uint8_t *end)
+{
+	const uint8_t *start = p;
+	auto nul = static_cast<const uint8_t *>(memchr(p, 0, end - p));
+	if (!nul) {
+		return nullptr;
+	}
+	size_t padded = ((nul - start) + 4) & ~(size_t)3;
+	p = std::min(start + padded, end);
+	return reinterpret_cast<const char *>(start);
+}
+
+bool OSCMessage::Parse(const uint8_t *data, size_t size)
+{
+	const uint8_t *p = data;
+	const uint8_t *end = data + size;
+	if (size < 4 || data[0] != '/') {
+		return false;
+	}
+
+	_address = readString(p, end);
+	if (!_address) {
+		return false;
+	}
+
+	// The type tag string is optional in older implementations
+	_types = "";
+	_argCount = 0;
+	if (p < end && *p == ',') {
+		const char *types = readString(p, end);
+		if (!types) {
+			return false;
+		}
+		_types = types + 1;
+		_argCount = strlen(_types);
+	}
+	_args = p;
+	_end = end;
+	return true;
+}
+
+bool OSCMessage::GetArg(size_t idx, OSCArgument &arg) const
+{
+	if (idx >= _argCount) {
+		return false;
+	}
+
+	const uint8_t *p = _args;
+	for (size_t i = 0; i <= idx; i++) {
+		arg = {};
+		arg.type = _types[i];
+		size_t remaining = _end - p;
+		switch (arg.type) {
+		case 'i':
+		case 'c':
+		case 'r':
+		case 'm':
+			if (remaining < 4) {
+				return false;
+			}
+			arg.i = (int32_t)read32(p);
+			arg.f = (double)arg.i;
+			p += 4;
+			break;
+		case 'f': {
+			if (remaining < 4) {
+				return false;
+			}
+			uint32_t bits = read32(p);
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			arg.f = value;
+			arg.i = (int64_t)value;
+			p += 4;
+			break;
+		}
+		case 'h':
+		case 't':
+			if (remaining < 8) {
+				return false;
+			}
+			arg.i = (int64_t)read64(p);
+			arg.f = (double)arg.i;
+			p += 8;
+			break;
+		case 'd': {
+			if (remaining < 8) {
+				return false;
+			}
+			uint64_t bits = read64(p);
+			memcpy(&arg.f, &bits, sizeof(arg.f));
+			arg.i = (int64_t)arg.f;
+			p += 8;
+			break;
+		}
+		case 's':
+		case 'S':
+			arg.s = readString(p, _end);
+			if (!arg.s) {
+				return false;
+			}
+			break;
+		case 'b': {
+			if (remaining < 4) {
+				return false;
+			}
+			size_t padded = (read32(p) + 3) & ~(size_t)3;
+			if (padded > remaining - 4) {
+				return false;
+			}
+			p += 4 + padded;
+			break;
+		}
+		case 'T':
+			arg.i = 1;
+			arg.f = 1.;
+			break;
+		case 'F':
+		case 'N':
+		case 'I':
+			break;
+		default:
+			// The size of unknown types is unknown as well, so no
+			// further arguments can be read
+			return false;
+		}
+	}
+	return true;
+}
+
+void OSCMessage::FormatArg(size_t idx, char *buf, size_t size) const
+{
+	if (size == 0) {
+		return;
+	}
+	buf[0] = '\0';
+
+	OSCArgument arg;
+	if (!GetArg(idx, arg)) {
+		return;
+	}
+	switch (arg.type) {
+	case 's':
+	case 'S':
+		snprintf(buf, size, "%s", arg.s);
+		break;
+	case 'f':
+	case 'd':
+		snprintf(buf, size, "%g", arg.f);
+		break;
+	case 'T':
+		snprintf(buf, size, "true");
+		break;
+	case 'F':
+		snprintf(buf, size, "false");
+		break;
+	case 'i':
+	case 'c':
+	case 'r':
+	case 'm':
+	case 'h':
+	case 't':
+		snprintf(buf, size, "%lld", (long long)arg.i);
+		break;
+	default:
+		break;
+	}
+}
+
+static bool parsePacket(const uint8_t *data, size_t size,
+			OSCMessageHandler handler, void *param, int depth)
+{
+	static const char bundleTag[] = "#bundle";
+	if (size >= 16 && memcmp(data, bundleTag, sizeof(bundleTag)) == 0) {
+		if (depth >= osc_max_bundle_depth) {
+			return false;
+		}
+		// Skip the bundle tag and the time tag
+		size_t pos = 16;
+		while (pos + 4 <= size) {
+			size_t elementSize = read32(data + pos);
+			pos += 4;
+			if (elementSize > size - pos) {
+				return false;
+			}
+			if (!parsePacket(data + pos, elementSize, handler, param,
+					 depth + 1)) {
+				return false;
+			}
+			pos += elementSize;
+		}
+		return pos == size;
+	}
+
+	OSCMessage message;
+	if (!message.Parse(data, size)) {
+		return false;
+	}
+	handler(message, param);
+	return true;
+}
+
+bool ParseOSCPacket(const uint8_t *data, size_t size,
+		    OSCMessageHandler handler, void *param)
+{
+	return parsePacket(data, size, handler, param, 0);
+}
+
+static inline bool isAddressPartEnd(char c)
+{
+	return c == '\0' || c == '/';
+}
+
+bool OSCPatternMatch(const char *pattern, const char *address)
+{
+	while (*pattern) {
+		switch (*pattern) {
+		case '?':
+			if (isAddressPartEnd(*address)) {
+				return false;
+			}
+			pattern++;
+			address++;
+			break;
+		case '*':
+			pattern++;
+			// '*' does not match across parts of the address
+			for (const char *a = address;; a++) {
+				if (OSCPatternMatch(pattern, a)) {
+					return true;
+				}
+				if (isAddressPartEnd(*a)) {
+					return false;
+				}
+			}
+		case '[': {
+			if (isAddressPartEnd(*address)) {
+				return false;
+			}
+			pattern++;
+			bool negate = *pattern == '!';
+			if (negate) {
+				pattern++;
+			}
+			bool matched = false;
+			while (*pattern && *pattern != ']') {
+				if (pattern[1] == '-' && pattern[2] &&
+				    pattern[2] != ']') {
+					matched |= *address >= pattern[0] &&
+						   *address <= pattern[2];
+					pattern += 3;
+				} else {
+					matched |= *address == *pattern;
+					pattern++;
+				}
+			}
+			if (*pattern != ']' || matched == negate) {
+				return false;
+			}
+			pattern++;
+			address++;
+			break;
+		}
+		case '{': {
+			const char *close = strchr(pattern, '}');
+			if (!close) {
+				return false;
+			}
+			const char *option = pattern + 1;
+			while (option <= close) {
+				const char *optionEnd = option;
+				while (optionEnd < close && *optionEnd != ',') {
+					optionEnd++;
+				}
+				size_t len = optionEnd - option;
+				if (strncmp(option, address, len) == 0 &&
+				    OSCPatternMatch(close + 1, address + len)) {
+					return true;
+				}
+				option = optionEnd + 1;
+			}
+			return false;
+		}
+		default:
+			if (*pattern != *address) {
+				return false;
+			}
+			pattern++;
+			address++;
+			break;
+		}
+	}
+	return *address == '\0';
+}
+
+OSCListener::~OSCListener()
+{
+	Stop();
+}
+
+bool OSCListener::Start(uint16_t port)
+{
+	Stop();
+
+	asio::error_code ec;
+	asio::ip::udp::endpoint endpoint(asio::ip::udp::v4(), port);
+	_socket = std::make_unique<asio::ip::udp::socket>(_io);
+	_socket->open(endpoint.protocol(), ec);
+	if (!ec) {
+		_socket->bind(endpoint, ec);
+	}
+	if (ec) {
+		blog(LOG_WARNING, "osc: failed to listen on port %d: %s", port,
+		     ec.message().c_str());
+		_socket.reset();
+		return false;
+	}
+
+	_received = 0;
+	_io.restart();
+	Receive();
+	_running = true;
+	_thread = std::thread([this]() { _io.run(); });
+
+	blog(LOG_INFO, "osc: listening on port %d", port);
+	return true;
+}
+
+void OSCListener::Stop()
+{
+	if (!_socket) {
+		return;
+	}
+
+	_io.stop();
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+	asio::error_code ec;
+	_socket->close(ec);
+	_socket.reset();
+	_running = false;
+
+	std::lock_guard<std::mutex> lock(_mtx);
+	_macroRequestCount = 0;
+	blog(LOG_INFO, "osc: stopped listening");
+}
+
+uint64_t OSCListener::Sequence()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _sequence;
+}
+
+bool OSCListener::GetMessage(uint64_t seq, OSCMessageRecord &record)
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (seq == 0 || seq > _sequence ||
+	    _sequence - seq >= osc_message_history) {
+		return false;
+	}
+	record = _messages[seq % osc_message_history];
+	return true;
+}
+
+bool OSCListener::PopMacroRequest(char *name, size_t size)
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (_macroRequestCount == 0) {
+		return false;
+	}
+	snprintf(name, size, "%s", _macroRequests[_macroRequestStart]);
+	_macroRequestStart = (_macroRequestStart + 1) % osc_max_macro_requests;
+	_macroRequestCount--;
+	return true;
+}
+
+void OSCListener::Receive()
+{
+	_socket->async_receive_from(
+		asio::buffer(_buffer), _senderEndpoint,
+		[this](const asio::error_code &ec, size_t size) {
+			if (ec == asio::error::operation_aborted) {
+				return;
+			}
+			if (!ec) {
+				_wakeSwitcher = false;
+				if (!ParseOSCPacket(_buffer, size, HandleMessage,
+						    this)) {
+					vblog(LOG_INFO,
+					      "osc: ignoring invalid packet");
+				}
+				if (_wakeSwitcher) {
+					switcher->requestCheck();
+				}
+			}
+			Receive();
+		});
+}
+
+static void handleSceneMessage(const OSCMessage &message, bool preview)
+{
+	OSCArgument scene;
+	if (!message.GetArg(0, scene) || !scene.s) {
+		blog(LOG_WARNING, "osc: %s requires a scene name",
+		     message.Address());
+		return;
+	}
+
+	auto source = GetWeakSourceByName(scene.s);
+	if (!source) {
+		blog(LOG_WARNING, "osc: ignoring unknown scene '%s'", scene.s);
+		return;
+	}
+
+	if (preview) {
+		SceneSwitchRequest request;
+		request.scene = source;
+		request.preview = true;
+		request.origin = os_gettime_ns();
+		switcher->switchQueue.Push(request);
+		return;
+	}
+
+	OSCArgument transition;
+	OSCArgument duration;
+	sceneSwitchInfo info = {source, nullptr, 0};
+	if (message.GetArg(1, transition) && transition.s) {
+		info.transition = GetWeakTransitionByName(transition.s);
+	}
+	if (message.GetArg(2, duration)) {
+		info.duration = (int)duration.i;
+	}
+	switchScene(info, false);
+}
+
+void OSCListener::HandleMessage(const OSCMessage &message, void *param)
+{
+	auto listener = static_cast<OSCListener *>(param);
+	listener->_received++;
+	const char *address = message.Address();
+	vblog(LOG_INFO, "osc: received %s", address);
+
+	// Scene switches are performed right away without involving the
+	// switcher thread
+	if (strcmp(address, OSC_SCENE) == 0) {
+		handleSceneMessage(message, false);
+		return;
+	}
+	if (strcmp(address, OSC_PREVIEW) == 0) {
+		handleSceneMessage(message, true);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(listener->_mtx);
+	if (strcmp(address, OSC_MACRO) == 0) {
+		OSCArgument macro;
+		if (!message.GetArg(0, macro) || !macro.s) {
+			blog(LOG_WARNING, "osc: %s requires a macro name",
+			     address);
+			return;
+		}
+		// Drop the oldest request if the switcher thread cannot keep up
+		if (listener->_macroRequestCount == osc_max_macro_requests) {
+			listener->_macroRequestStart =
+				(listener->_macroRequestStart + 1) %
+				osc_max_macro_requests;
+			listener->_macroRequestCount--;
+		}
+		size_t idx = (listener->_macroRequestStart +
+			      listener->_macroRequestCount) %
+			     osc_max_macro_requests;
+		snprintf(listener->_macroRequests[idx],
+			 sizeof(listener->_macroRequests[idx]), "%s", macro.s);
+		listener->_macroRequestCount++;
+	}
+
+	auto &record =
+		listener->_messages[++listener->_sequence % osc_message_history];
+	snprintf(record.address, sizeof(record.address), "%s", address);
+	message.FormatArg(0, record.value, sizeof(record.value));
+	listener->_wakeSwitcher = true;
+}
+
+void SwitcherData::getOSCMacroRequests(std::vector<Macro *> &requested)
+{
+	char name[osc_max_address_length];
+	while (oscListener.PopMacroRequest(name, sizeof(name))) {
+		auto macro = GetMacroByName(name);
+		if (!macro) {
+			blog(LOG_WARNING, "osc: ignoring unknown macro '%s'",
+			     name);
+			continue;
+		}
+		vblog(LOG_INFO, "macro requested via OSC: %s", name);
+		requested.push_back(macro);
+	}
+}
+
+void SwitcherData::startOSC()
+{
+	if (networkConfig.OSCEnabled) {
+		oscListener.Start(networkConfig.OSCPort);
+	} else {
+		oscListener.Stop();
+	}
+}
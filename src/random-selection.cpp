@@ -0,0 +1,89 @@
+#include "headers/random-selection.hpp"
+
+RandomSelector::RandomSelector() : _rng(std::random_device{}()) {}
+
+void RandomSelector::SetNoRepeatWindow(size_t size)
+{
+	_recent.assign(size, 0);
+	_recentCount = 0;
+	_recentPos = 0;
+}
+
+void RandomSelector::Build()
+{
+	const size_t n = _weights.size();
+	_probability.assign(n, 0.);
+	_alias.assign(n, 0);
+
+	_totalWeight = 0.;
+	for (auto w : _weights) {
+		_totalWeight += w;
+	}
+	if (_totalWeight <= 0.) {
+		return;
+	}
+
+	std::vector<size_t> small, large;
+	small.reserve(n);
+	large.reserve(n);
+	for (size_t i = 0; i < n; i++) {
+		_probability[i] = _weights[i] * n / _totalWeight;
+		if (_probability[i] < 1.) {
+			small.push_back(i);
+		} else {
+			large.push_back(i);
+		}
+	}
+
+	while (!small.empty() && !large.empty()) {
+		size_t s = small.back();
+		small.pop_back();
+		size_t l = large.back();
+		_alias[s] = l;
+		_probability[l] -= 1. - _probability[s];
+		if (_probability[l] < 1.) {
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+
+	// Whatever is left over only differs from 1 due to rounding errors
+	for (auto i : large) {
+		_probability[i] = 1.;
+	}
+	for (auto i : small) {
+		_probability[i] = 1.;
+	}
+}
+
+size_t RandomSelector::AliasDraw()
+{
+	double r = _uniform(_rng) * _weights.size();
+	size_t idx = (size_t)r;
+	if (idx >= _weights.size()) {
+		idx = _weights.size() - 1;
+	}
+	return (r - idx) < _probability[idx] ? idx : _alias[idx];
+}
+
+bool RandomSelector::RecentlyDrawn(size_t idx) const
+{
+	for (size_t i = 0; i < _recentCount; i++) {
+		if (_recent[i] == idx) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void RandomSelector::Remember(size_t idx)
+{
+	if (_recent.empty()) {
+		return;
+	}
+	_recent[_recentPos] = idx;
+	_recentPos = (_recentPos + 1) % _recent.size();
+	if (_recentCount < _recent.size()) {
+		_recentCount++;
+	}
+}
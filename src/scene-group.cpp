@@ -1,6 +1,5 @@
 #include <QVBoxLayout>
 #include <QDialogButtonBox>
-#include <random>
 
 #include "headers/advanced-scene-switcher.hpp"
 #include "headers/name-dialog.hpp"
@@ -46,6 +45,8 @@ OBSWeakSource SceneGroup::getNextSceneTime()
 		advanceIdx();
 		lastAdvTime = now;
 	}
+	switcher->addDeadline(lastAdvTime + std::chrono::milliseconds(
+						    (int64_t)(time * 1000)));
 
 	return scenes[currentIdx];
 }
@@ -57,13 +58,14 @@ OBSWeakSource SceneGroup::getNextSceneRandom()
 		return scenes[currentIdx];
 	}
 
-	int rIdx = lastRandomScene;
-	do {
-		rIdx = rand() % scenes.size();
-	} while (rIdx == lastRandomScene);
+	// All scenes of a group are equally likely
+	if (randomSelector.Size() != scenes.size()) {
+		randomSelector.SetNoRepeatWindow(1);
+		randomSelector.SetWeights(scenes.size(),
+					  [](size_t) { return 1.; });
+	}
 
-	lastRandomScene = rIdx;
-	currentIdx = rIdx;
+	currentIdx = randomSelector.Draw([](size_t) { return true; });
 
 	return scenes[currentIdx];
 }
@@ -178,6 +180,7 @@ void AdvSceneSwitcher::on_sceneGroupRemove_clicked()
 		auto &sg = switcher->sceneGroups;
 		name = QString::fromStdString(sg[idx].name);
 		sg.erase(sg.begin() + idx);
+		switcher->pruneRequested = true;
 	}
 
 	delete item;
@@ -0,0 +1,158 @@
+#include "headers/scene-switch-queue.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <util/platform.h>
+#include <algorithm>
+
+SceneSwitchQueue::~SceneSwitchQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		_stop = true;
+		_sceneDone = _sceneSeq;
+	}
+	_cv.notify_all();
+	_doneCv.notify_all();
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+}
+
+void SceneSwitchQueue::Push(const SceneSwitchRequest &request, bool wait)
+{
+	// The frontend functions used to switch scenes block until the UI
+	// thread handled the request, so it must never wait itself
+	if (wait && QCoreApplication::instance() &&
+	    QThread::currentThread() ==
+		    QCoreApplication::instance()->thread()) {
+		wait = false;
+	}
+
+	std::unique_lock<std::mutex> lock(_mtx);
+	if (_stop) {
+		return;
+	}
+	if (!_thread.joinable()) {
+		_thread = std::thread(&SceneSwitchQueue::Thread, this);
+	}
+
+	uint64_t seq = 0;
+	if (request.preview) {
+		if (_previewPending) {
+			_stats.coalesced++;
+		}
+		_preview = request;
+		_previewPending = true;
+	} else {
+		if (_scenePending) {
+			_stats.coalesced++;
+		}
+		_scene = request;
+		_scenePending = true;
+		seq = ++_sceneSeq;
+	}
+	_cv.notify_all();
+
+	if (wait && seq) {
+		_doneCv.wait(lock, [&]() { return _sceneDone >= seq; });
+	}
+}
+
+void SceneSwitchQueue::Cancel()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	_scenePending = false;
+	_previewPending = false;
+	_sceneDone = _sceneSeq;
+	_doneCv.notify_all();
+}
+
+SceneSwitchStats SceneSwitchQueue::GetStats()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _stats;
+}
+
+void SceneSwitchQueue::ResetStats()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	_stats = {};
+}
+
+void SceneSwitchQueue::SetPerformer(
+	std::function<void(const SceneSwitchRequest &)> performer)
+{
+	_performer = performer;
+}
+
+void SceneSwitchQueue::Thread()
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+	while (!_stop) {
+		if (!_scenePending && !_previewPending) {
+			_cv.wait(lock);
+			continue;
+		}
+
+		// Perform whichever pending request is due first
+		bool preview = !_scenePending ||
+			       (_previewPending && _preview.time < _scene.time);
+		const auto &next = preview ? _preview : _scene;
+		uint64_t now = os_gettime_ns();
+		if (now < next.time) {
+			_cv.wait_for(lock,
+				     std::chrono::nanoseconds(next.time - now));
+			continue;
+		}
+
+		SceneSwitchRequest request = next;
+		uint64_t seq = _sceneSeq;
+		if (preview) {
+			_previewPending = false;
+		} else {
+			_scenePending = false;
+		}
+
+		// Switching might block until the UI thread processed the
+		// request, so do not block new requests meanwhile
+		lock.unlock();
+		Perform(request);
+		uint64_t end = os_gettime_ns();
+		lock.lock();
+
+		uint64_t start = std::max(request.origin, request.time);
+		uint64_t latency = end > start ? end - start : 0;
+		_stats.switches++;
+		_stats.totalLatency += latency;
+		_stats.maxLatency = std::max(_stats.maxLatency, latency);
+		vblog(LOG_INFO, "%s switch took %.3f ms",
+		      request.preview ? "preview" : "scene",
+		      (double)latency / 1000000.);
+
+		if (!preview) {
+			// Cancel() might have marked later requests as done
+			// while this one was performed
+			_sceneDone = std::max(_sceneDone, seq);
+			_doneCv.notify_all();
+		}
+	}
+}
+
+void SceneSwitchQueue::Perform(const SceneSwitchRequest &request)
+{
+	// The frontend emits the scene change events synchronously while the
+	// scene is set
+	switcher->applyingUnforwardedSwitch = !request.forward;
+	if (_performer) {
+		_performer(request);
+	} else if (request.preview) {
+		switchPreviewScene(request.scene);
+	} else {
+		performSceneSwitch({request.scene, request.transition,
+				    request.duration},
+				   request.forward);
+	}
+	switcher->applyingUnforwardedSwitch = false;
+}
@@ -0,0 +1,190 @@
+#include "headers/schedule.hpp"
+
+#include <sstream>
+
+// Occurrences are searched for at most this many days into the future
+constexpr int max_cron_search_days = 366 * 5;
+
+template<size_t N>
+static bool parseField(const std::string &field, int min, int max,
+		       std::bitset<N> &bits)
+{
+	bits.reset();
+	std::stringstream ss(field);
+	std::string part;
+	while (std::getline(ss, part, ',')) {
+		if (part.empty()) {
+			return false;
+		}
+
+		int step = 1;
+		auto slash = part.find('/');
+		if (slash != std::string::npos) {
+			try {
+				step = std::stoi(part.substr(slash + 1));
+			} catch (...) {
+				return false;
+			}
+			if (step < 1) {
+				return false;
+			}
+			part = part.substr(0, slash);
+		}
+
+		int first = min;
+		int last = max;
+		if (part != "*") {
+			auto dash = part.find('-');
+			try {
+				first = std::stoi(part.substr(0, dash));
+				last = dash == std::string::npos
+					       ? (slash == std::string::npos
+							  ? first
+							  : max)
+					       : std::stoi(part.substr(dash + 1));
+			} catch (...) {
+				return false;
+			}
+		}
+		if (first < min || last > max || first > last) {
+			return false;
+		}
+		for (int i = first; i <= last; i += step) {
+			bits.set(i);
+		}
+	}
+	return bits.any();
+}
+
+bool CronSchedule::Parse(const std::string &expression)
+{
+	_valid = false;
+
+	std::stringstream ss(expression);
+	std::vector<std::string> fields;
+	std::string field;
+	while (ss >> field) {
+		fields.push_back(field);
+	}
+	if (fields.size() == 5) {
+		fields.insert(fields.begin(), "0");
+	}
+	if (fields.size() != 6) {
+		return false;
+	}
+
+	std::bitset<8> weekdays;
+	if (!parseField(fields[0], 0, 59, _seconds) ||
+	    !parseField(fields[1], 0, 59, _minutes) ||
+	    !parseField(fields[2], 0, 23, _hours) ||
+	    !parseField(fields[3], 1, 31, _days) ||
+	    !parseField(fields[4], 1, 12, _months) ||
+	    !parseField(fields[5], 0, 7, weekdays)) {
+		return false;
+	}
+
+	// Sunday is 0 in cron but 7 in Qt, so store as Qt day of week - 1
+	_weekdays.reset();
+	for (int i = 1; i <= 7; i++) {
+		_weekdays[i - 1] = weekdays[i % 7] || (i == 7 && weekdays[7]);
+	}
+
+	// Like in standard cron a stepped "*" like "*/2" still counts as
+	// unrestricted when combining both day fields
+	_anyDay = fields[3][0] == '*';
+	_anyWeekday = fields[5][0] == '*';
+	_valid = true;
+	return true;
+}
+
+bool CronSchedule::DayMatches(const QDate &date) const
+{
+	bool day = _days[date.day()];
+	bool weekday = _weekdays[date.dayOfWeek() - 1];
+	if (_anyDay || _anyWeekday) {
+		return day && weekday;
+	}
+	return day || weekday;
+}
+
+// Finds the first matching time of day at or after the given one
+bool CronSchedule::FindTime(int &hour, int &minute, int &second) const
+{
+	for (int h = hour; h < 24; h++) {
+		if (!_hours[h]) {
+			continue;
+		}
+		for (int m = h == hour ? minute : 0; m < 60; m++) {
+			if (!_minutes[m]) {
+				continue;
+			}
+			int start = (h == hour && m == minute) ? second : 0;
+			for (int s = start; s < 60; s++) {
+				if (_seconds[s]) {
+					hour = h;
+					minute = m;
+					second = s;
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+QDateTime CronSchedule::Next(const QDateTime &after) const
+{
+	if (!_valid) {
+		return {};
+	}
+
+	QDateTime start = after.addSecs(1);
+	QDate date = start.date();
+	QTime time = start.time();
+	int hour = time.hour();
+	int minute = time.minute();
+	int second = time.second();
+
+	for (int i = 0; i < max_cron_search_days; i++) {
+		if (!_months[date.month()]) {
+			date = QDate(date.year(), date.month(), 1).addMonths(1);
+			hour = minute = second = 0;
+			continue;
+		}
+		if (DayMatches(date) && FindTime(hour, minute, second)) {
+			return QDateTime(date, QTime(hour, minute, second));
+		}
+		date = date.addDays(1);
+		hour = minute = second = 0;
+	}
+	return {};
+}
+
+void ScheduleEngine::Clear()
+{
+	_queue = {};
+}
+
+void ScheduleEngine::Add(size_t id, qint64 time)
+{
+	_queue.push({time, id});
+}
+
+bool ScheduleEngine::PopDue(qint64 now, size_t &id, qint64 &time)
+{
+	if (_queue.empty() || _queue.top().time > now) {
+		return false;
+	}
+	id = _queue.top().id;
+	time = _queue.top().time;
+	_queue.pop();
+	return true;
+}
+
+qint64 ScheduleEngine::NextTime() const
+{
+	if (_queue.empty()) {
+		return -1;
+	}
+	return _queue.top().time;
+}
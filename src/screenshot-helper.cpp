@@ -1,4 +1,7 @@
 #include "headers/screenshot-helper.hpp"
+#include "headers/shared-registry.hpp"
+
+#include <algorithm>
 
 static void ScreenshotTick(void *param, float);
 
@@ -129,3 +132,253 @@ static void ScreenshotTick(void *param, float)
 
 	data->stage++;
 }
+
+static void FrameGrabberTick(void *param, float seconds)
+{
+	auto grabber = reinterpret_cast<AdvSSFrameGrabber *>(param);
+	grabber->Tick(seconds);
+}
+
+AdvSSFrameGrabber::AdvSSFrameGrabber(obs_weak_source_t *source)
+	: _weakSource(source)
+{
+	obs_add_tick_callback(FrameGrabberTick, this);
+}
+
+AdvSSFrameGrabber::~AdvSSFrameGrabber()
+{
+	// Removing the tick callback will wait for a running tick to finish
+	obs_remove_tick_callback(FrameGrabberTick, this);
+
+	obs_enter_graphics();
+	FreeGraphicsData();
+	obs_leave_graphics();
+}
+
+std::shared_ptr<const AdvSSFrame> AdvSSFrameGrabber::GetFrame()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _frame;
+}
+
+size_t AdvSSFrameGrabber::AddSubscriber(int interval)
+{
+	std::lock_guard<std::mutex> lock(_subscriberMtx);
+	size_t id = _nextSubscriber++;
+	_subscriberIntervals[id] = std::max(interval, 1);
+	UpdateInterval();
+	return id;
+}
+
+void AdvSSFrameGrabber::RemoveSubscriber(size_t id)
+{
+	std::lock_guard<std::mutex> lock(_subscriberMtx);
+	_subscriberIntervals.erase(id);
+	UpdateInterval();
+}
+
+void AdvSSFrameGrabber::UpdateInterval()
+{
+	if (_subscriberIntervals.empty()) {
+		return;
+	}
+	int interval = _subscriberIntervals.begin()->second;
+	for (const auto &s : _subscriberIntervals) {
+		interval = std::min(interval, s.second);
+	}
+	_interval = interval;
+}
+
+void AdvSSFrameGrabber::Tick(float seconds)
+{
+	_elapsed += seconds * 1000.f;
+	if (_elapsed < (float)_interval) {
+		return;
+	}
+	_elapsed = 0.f;
+
+	OBSSource source = OBSGetStrongRef(_weakSource);
+	if (_weakSource && !source) {
+		PublishEmpty();
+		return;
+	}
+
+	obs_enter_graphics();
+
+	if (!UpdateSize()) {
+		obs_leave_graphics();
+		PublishEmpty();
+		return;
+	}
+
+	// Read back the frame staged during the previous sample while the
+	// current one is being rendered and staged to the other surface
+	if (_staged) {
+		Publish(_stagesurfs[_currentSurf]);
+	}
+	_currentSurf ^= 1;
+
+	Render(source);
+	gs_stage_texture(_stagesurfs[_currentSurf],
+			 gs_texrender_get_texture(_texrender));
+	_staged = true;
+
+	obs_leave_graphics();
+}
+
+bool AdvSSFrameGrabber::UpdateSize()
+{
+	uint32_t cx, cy;
+	obs_source_t *source = obs_weak_source_get_source(_weakSource);
+	if (source) {
+		cx = obs_source_get_base_width(source);
+		cy = obs_source_get_base_height(source);
+		obs_source_release(source);
+	} else {
+		obs_video_info ovi;
+		obs_get_video_info(&ovi);
+		cx = ovi.base_width;
+		cy = ovi.base_height;
+	}
+
+	if (!cx || !cy) {
+		FreeGraphicsData();
+		return false;
+	}
+
+	if (cx == _cx && cy == _cy && _texrender) {
+		return true;
+	}
+
+	FreeGraphicsData();
+	_cx = cx;
+	_cy = cy;
+	_texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+	_stagesurfs[0] = gs_stagesurface_create(cx, cy, GS_RGBA);
+	_stagesurfs[1] = gs_stagesurface_create(cx, cy, GS_RGBA);
+	return true;
+}
+
+void AdvSSFrameGrabber::Render(OBSSource &source)
+{
+	gs_texrender_reset(_texrender);
+	if (!gs_texrender_begin(_texrender, _cx, _cy)) {
+		return;
+	}
+
+	vec4 zero;
+	vec4_zero(&zero);
+
+	gs_clear(GS_CLEAR_COLOR, &zero, 0.0f, 0);
+	gs_ortho(0.0f, (float)_cx, 0.0f, (float)_cy, -100.0f, 100.0f);
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+	if (source) {
+		obs_source_inc_showing(source);
+		obs_source_video_render(source);
+		obs_source_dec_showing(source);
+	} else {
+		obs_render_main_texture();
+	}
+
+	gs_blend_state_pop();
+	gs_texrender_end(_texrender);
+}
+
+void AdvSSFrameGrabber::Publish(gs_stagesurf_t *surf)
+{
+	uint8_t *videoData = nullptr;
+	uint32_t videoLinesize = 0;
+	if (!gs_stagesurface_map(surf, &videoData, &videoLinesize)) {
+		return;
+	}
+
+	// Frames are never modified after being published so each sample
+	// requires a new image buffer, which is then shared by all consumers
+	auto frame = std::make_shared<AdvSSFrame>();
+	frame->image = QImage(_cx, _cy, QImage::Format::Format_RGBX8888);
+	int linesize = frame->image.bytesPerLine();
+	for (int y = 0; y < (int)_cy; y++) {
+		memcpy(frame->image.scanLine(y),
+		       videoData + (y * videoLinesize), linesize);
+	}
+	gs_stagesurface_unmap(surf);
+
+	frame->time = std::chrono::high_resolution_clock::now();
+	frame->id = ++_frameCount;
+
+	std::lock_guard<std::mutex> lock(_mtx);
+	_frame = frame;
+}
+
+void AdvSSFrameGrabber::PublishEmpty()
+{
+	_staged = false;
+	auto frame = std::make_shared<AdvSSFrame>();
+	frame->time = std::chrono::high_resolution_clock::now();
+	frame->id = ++_frameCount;
+
+	std::lock_guard<std::mutex> lock(_mtx);
+	_frame = frame;
+}
+
+void AdvSSFrameGrabber::FreeGraphicsData()
+{
+	gs_stagesurface_destroy(_stagesurfs[0]);
+	gs_stagesurface_destroy(_stagesurfs[1]);
+	gs_texrender_destroy(_texrender);
+	_stagesurfs[0] = nullptr;
+	_stagesurfs[1] = nullptr;
+	_texrender = nullptr;
+	_staged = false;
+	_cx = 0;
+	_cy = 0;
+}
+
+static SharedRegistry<obs_weak_source_t *, AdvSSFrameGrabber> grabbers;
+
+std::shared_ptr<AdvSSFrameGrabber> GetFrameGrabber(obs_weak_source_t *source,
+						   int interval)
+{
+	struct Subscription {
+		std::shared_ptr<AdvSSFrameGrabber> grabber;
+		size_t id;
+		~Subscription() { grabber->RemoveSubscriber(id); }
+	};
+
+	auto subscription = std::make_shared<Subscription>();
+	subscription->grabber = grabbers.Get(source, [source]() {
+		return std::make_shared<AdvSSFrameGrabber>(source);
+	});
+	subscription->id = subscription->grabber->AddSubscriber(interval);
+	// The returned pointer keeps the subscription and thereby the grabber
+	// alive
+	return std::shared_ptr<AdvSSFrameGrabber>(
+		subscription, subscription->grabber.get());
+}
+
+void AdvSSFrameReader::SetSource(obs_weak_source_t *source, int interval)
+{
+	_grabber = GetFrameGrabber(source, interval);
+	_lastFrameId = 0;
+}
+
+bool AdvSSFrameReader::IsReading(obs_weak_source_t *source)
+{
+	return _grabber && _grabber->GetSource() == source;
+}
+
+std::shared_ptr<const AdvSSFrame> AdvSSFrameReader::ReadNewFrame()
+{
+	if (!_grabber) {
+		return nullptr;
+	}
+	auto frame = _grabber->GetFrame();
+	if (!frame || frame->id == _lastFrameId) {
+		return nullptr;
+	}
+	_lastFrameId = frame->id;
+	return frame;
+}
@@ -0,0 +1,390 @@
+#include "headers/shared-memory.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+
+#include <util/platform.h>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#define SHM_NAME "Local\\advanced-scene-switcher"
+#define SHM_SIGNAL_NAME "Local\\advanced-scene-switcher-commands"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <semaphore.h>
+#define SHM_NAME "/advanced-scene-switcher"
+#define SHM_SIGNAL_NAME "/advanced-scene-switcher-commands"
+#endif
+
+#ifndef _WIN32
+// Segments of crashed sessions are never unlinked, so an existing segment is
+// only considered to be in use as long as its owner is still running
+static bool segmentOwnerAlive()
+{
+	int fd = shm_open(SHM_NAME, O_RDONLY, 0);
+	if (fd == -1) {
+		return false;
+	}
+
+	bool alive = true;
+	struct stat st;
+	if (fstat(fd, &st) == 0 &&
+	    st.st_size >= (off_t)sizeof(SharedMemoryLayout)) {
+		void *mem = mmap(nullptr, sizeof(SharedMemoryLayout),
+				 PROT_READ, MAP_SHARED, fd, 0);
+		if (mem != MAP_FAILED) {
+			auto shm = static_cast<const SharedMemoryLayout *>(mem);
+			if (shm->magic == shm_magic &&
+			    shm->version == shm_version &&
+			    kill((pid_t)shm->ownerPid, 0) == -1 &&
+			    errno == ESRCH) {
+				alive = false;
+			}
+			munmap(mem, sizeof(SharedMemoryLayout));
+		}
+	}
+	close(fd);
+	return alive;
+}
+
+static int createSegment()
+{
+	int fd = shm_open(SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd != -1 || errno != EEXIST || segmentOwnerAlive()) {
+		return fd;
+	}
+
+	blog(LOG_INFO, "replacing shared memory %s of a previous session",
+	     SHM_NAME);
+	shm_unlink(SHM_NAME);
+	return shm_open(SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0600);
+}
+#endif
+
+SharedMemoryChannel::~SharedMemoryChannel()
+{
+	Close();
+}
+
+bool SharedMemoryChannel::Open()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (_shm) {
+		return true;
+	}
+
+	const size_t size = sizeof(SharedMemoryLayout);
+	void *mem = nullptr;
+#ifdef _WIN32
+	_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr,
+				      PAGE_READWRITE, 0, (DWORD)size, SHM_NAME);
+	if (!_mapping) {
+		blog(LOG_WARNING, "failed to create shared memory (%lu)",
+		     GetLastError());
+		return false;
+	}
+	if (GetLastError() == ERROR_ALREADY_EXISTS) {
+		CloseHandle(_mapping);
+		_mapping = nullptr;
+		blog(LOG_WARNING,
+		     "shared memory %s is already used by another OBS instance",
+		     SHM_NAME);
+		return false;
+	}
+	mem = MapViewOfFile(_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!mem) {
+		CloseHandle(_mapping);
+		_mapping = nullptr;
+	}
+#else
+	int fd = createSegment();
+	if (fd == -1) {
+		if (errno == EEXIST) {
+			blog(LOG_WARNING,
+			     "shared memory %s is already used by another OBS instance",
+			     SHM_NAME);
+		} else {
+			blog(LOG_WARNING, "failed to create shared memory: %s",
+			     strerror(errno));
+		}
+		return false;
+	}
+	if (ftruncate(fd, size) == 0) {
+		mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			   fd, 0);
+		if (mem == MAP_FAILED) {
+			mem = nullptr;
+		}
+	}
+	close(fd);
+	if (!mem) {
+		shm_unlink(SHM_NAME);
+	}
+#endif
+	if (!mem) {
+		blog(LOG_WARNING, "failed to map shared memory");
+		return false;
+	}
+
+	// The segment was newly created, so it is zero initialized
+	_shm = static_cast<SharedMemoryLayout *>(mem);
+	_shm->version = shm_version;
+	_shm->size = (uint32_t)size;
+#ifdef _WIN32
+	_shm->ownerPid = (uint32_t)GetCurrentProcessId();
+#else
+	_shm->ownerPid = (uint32_t)getpid();
+#endif
+	// Consumers check the magic value last to know the segment is ready
+	std::atomic_thread_fence(std::memory_order_release);
+	_shm->magic = shm_magic;
+
+	// Without the signal commands are still picked up by the regular checks
+#ifdef _WIN32
+	_signal = CreateEventA(nullptr, FALSE, FALSE, SHM_SIGNAL_NAME);
+#else
+	sem_unlink(SHM_SIGNAL_NAME);
+	sem_t *sem = sem_open(SHM_SIGNAL_NAME, O_CREAT | O_EXCL, 0600, 0);
+	_signal = sem != SEM_FAILED ? sem : nullptr;
+#endif
+	if (_signal) {
+		_stopWatcher = false;
+		_watcher = std::thread([this]() { Watch(); });
+	} else {
+		blog(LOG_WARNING, "failed to create shared memory signal %s",
+		     SHM_SIGNAL_NAME);
+	}
+
+	Publish();
+	blog(LOG_INFO, "shared memory %s opened", SHM_NAME);
+	return true;
+}
+
+void SharedMemoryChannel::Close()
+{
+	// The watcher uses _mtx itself, so it has to be stopped first
+	if (_watcher.joinable()) {
+		_stopWatcher = true;
+#ifdef _WIN32
+		SetEvent(_signal);
+#else
+		sem_post(static_cast<sem_t *>(_signal));
+#endif
+		_watcher.join();
+	}
+
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (!_shm) {
+		return;
+	}
+
+	_shm->magic = 0;
+#ifdef _WIN32
+	UnmapViewOfFile(_shm);
+	CloseHandle(_mapping);
+	_mapping = nullptr;
+	if (_signal) {
+		CloseHandle(_signal);
+	}
+#else
+	munmap(_shm, sizeof(SharedMemoryLayout));
+	shm_unlink(SHM_NAME);
+	if (_signal) {
+		sem_close(static_cast<sem_t *>(_signal));
+		sem_unlink(SHM_SIGNAL_NAME);
+	}
+#endif
+	_shm = nullptr;
+	_signal = nullptr;
+	blog(LOG_INFO, "shared memory %s closed", SHM_NAME);
+}
+
+bool SharedMemoryChannel::WaitForSignal()
+{
+#ifdef _WIN32
+	return WaitForSingleObject(_signal, INFINITE) == WAIT_OBJECT_0;
+#else
+	int ret;
+	do {
+		ret = sem_wait(static_cast<sem_t *>(_signal));
+	} while (ret == -1 && errno == EINTR);
+	return ret == 0;
+#endif
+}
+
+void SharedMemoryChannel::Watch()
+{
+	while (WaitForSignal() && !_stopWatcher) {
+		if (HasCommands()) {
+			switcher->requestCheck();
+		}
+	}
+}
+
+void SharedMemoryChannel::SetScenes(const char *current, const char *previous)
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	snprintf(_state.currentScene, sizeof(_state.currentScene), "%s",
+		 current ? current : "");
+	snprintf(_state.previousScene, sizeof(_state.previousScene), "%s",
+		 previous ? previous : "");
+	Publish();
+}
+
+void SharedMemoryChannel::SetStatus(bool running, const uint64_t *macroMatches,
+				    uint32_t macroCount)
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (macroCount > shm_max_macros && _state.macroTotal <= shm_max_macros) {
+		blog(LOG_WARNING,
+		     "shared memory only reports the state of the first %zu of %u macros",
+		     shm_max_macros, macroCount);
+	}
+	_state.running = running;
+	_state.macroTotal = macroCount;
+	_state.macroCount = std::min(macroCount, (uint32_t)shm_max_macros);
+	memset(_state.macroMatches, 0, sizeof(_state.macroMatches));
+	if (macroMatches) {
+		memcpy(_state.macroMatches, macroMatches,
+		       (_state.macroCount + 63) / 64 * sizeof(uint64_t));
+	}
+	Publish();
+}
+
+void SharedMemoryChannel::Publish()
+{
+	if (!_shm) {
+		return;
+	}
+
+	_state.updateTime = os_gettime_ns();
+
+	// Sequence lock: an odd sequence number marks an update in progress
+	uint32_t seq = _shm->stateSequence.load(std::memory_order_relaxed);
+	_shm->stateSequence.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(&_shm->state, &_state, sizeof(_state));
+	_shm->stateSequence.store(seq + 2, std::memory_order_release);
+}
+
+bool SharedMemoryChannel::IsOpen()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _shm != nullptr;
+}
+
+bool SharedMemoryChannel::HasCommands()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (!_shm) {
+		return false;
+	}
+	return _shm->commandTail.load(std::memory_order_relaxed) !=
+	       _shm->commandHead.load(std::memory_order_acquire);
+}
+
+bool SharedMemoryChannel::PopCommand(SharedCommand &command)
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (!_shm) {
+		return false;
+	}
+
+	uint32_t tail = _shm->commandTail.load(std::memory_order_relaxed);
+	uint32_t head = _shm->commandHead.load(std::memory_order_acquire);
+	if (tail == head) {
+		return false;
+	}
+	// Guard against producers which do not respect the ring size
+	if (head - tail > shm_command_count) {
+		blog(LOG_WARNING, "shared memory command queue overrun");
+		_shm->commandTail.store(head, std::memory_order_release);
+		return false;
+	}
+
+	command = _shm->commands[tail % shm_command_count];
+	command.argument[sizeof(command.argument) - 1] = '\0';
+	_shm->commandTail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+void SwitcherData::updateSharedMemoryScenes()
+{
+	if (!sharedMemory.IsOpen()) {
+		return;
+	}
+
+	obs_source_t *current = obs_frontend_get_current_scene();
+	sharedMemory.SetScenes(obs_source_get_name(current),
+			       GetWeakSourceName(previousScene).c_str());
+	obs_source_release(current);
+}
+
+void SwitcherData::updateSharedMemoryStatus()
+{
+	if (!sharedMemory.IsOpen()) {
+		return;
+	}
+
+	uint64_t matches[shm_max_macros / 64] = {};
+	for (size_t i = 0; i < macros.size() && i < shm_max_macros; i++) {
+		if (macros[i].Matched()) {
+			matches[i / 64] |= (uint64_t)1 << (i % 64);
+		}
+	}
+	sharedMemory.SetStatus(th && th->isRunning() && !stop, matches,
+			       (uint32_t)macros.size());
+}
+
+void SwitcherData::processSharedMemoryCommands(
+	std::vector<Macro *> &requested)
+{
+	SharedCommand command;
+	while (sharedMemory.PopCommand(command)) {
+		switch (command.type) {
+		case SharedCommandType::SWITCH_SCENE:
+		case SharedCommandType::SWITCH_PREVIEW: {
+			auto scene = GetWeakSourceByName(command.argument);
+			if (!scene) {
+				blog(LOG_WARNING,
+				     "shared memory: unknown scene '%s'",
+				     command.argument);
+				break;
+			}
+			if (command.type == SharedCommandType::SWITCH_SCENE) {
+				switchScene({scene, nullptr, 0}, false);
+				break;
+			}
+			SceneSwitchRequest request;
+			request.scene = scene;
+			request.preview = true;
+			request.origin = os_gettime_ns();
+			switchQueue.Push(request);
+			break;
+		}
+		case SharedCommandType::RUN_MACRO: {
+			auto macro = GetMacroByName(command.argument);
+			if (!macro) {
+				blog(LOG_WARNING,
+				     "shared memory: unknown macro '%s'",
+				     command.argument);
+				break;
+			}
+			vblog(LOG_INFO, "macro requested via shared memory: %s",
+			      command.argument);
+			requested.push_back(macro);
+			break;
+		}
+		default:
+			blog(LOG_WARNING, "shared memory: unknown command %u",
+			     (uint32_t)command.type);
+			break;
+		}
+	}
+}
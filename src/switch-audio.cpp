@@ -129,20 +129,19 @@ bool SwitcherData::checkAudioSwitch(OBSWeakSource &scene,
 			}
 		}
 
+		// Highest peak since the last check
 		// peak will have a value from -60 db to 0 db
+		float peak = s.audioLevel.Read().peak;
 		bool volumeThresholdreached = false;
 
 		if (s.condition == ABOVE) {
-			volumeThresholdreached = ((double)s.peak + 60) * 1.7 >
+			volumeThresholdreached = ((double)peak + 60) * 1.7 >
 						 s.volumeThreshold;
 		} else {
-			volumeThresholdreached = ((double)s.peak + 60) * 1.7 <
+			volumeThresholdreached = ((double)peak + 60) * 1.7 <
 						 s.volumeThreshold;
 		}
 
-		// Reset for next check
-		s.peak = -FLT_MAX;
-
 		if (!volumeThresholdreached) {
 			s.duration.Reset();
 		}
@@ -238,43 +237,9 @@ void AdvSceneSwitcher::setupAudioTab()
 	ui->audioFallback->setChecked(switcher->audioFallback.enable);
 }
 
-void AudioSwitch::setVolumeLevel(void *data,
-				 const float magnitude[MAX_AUDIO_CHANNELS],
-				 const float peak[MAX_AUDIO_CHANNELS],
-				 const float inputPeak[MAX_AUDIO_CHANNELS])
-{
-	UNUSED_PARAMETER(magnitude);
-	UNUSED_PARAMETER(inputPeak);
-	AudioSwitch *s = static_cast<AudioSwitch *>(data);
-
-	for (int i = 0; i < MAX_AUDIO_CHANNELS; i++) {
-		if (peak[i] > s->peak) {
-			s->peak = peak[i];
-		}
-	}
-}
-
-obs_volmeter_t *AddVolmeterToSource(AudioSwitch *entry, obs_weak_source *source)
-{
-	obs_volmeter_t *volmeter = obs_volmeter_create(OBS_FADER_LOG);
-	obs_volmeter_add_callback(volmeter, AudioSwitch::setVolumeLevel, entry);
-	obs_source_t *as = obs_weak_source_get_source(source);
-	if (!obs_volmeter_attach_source(volmeter, as)) {
-		const char *name = obs_source_get_name(as);
-		blog(LOG_WARNING, "failed to attach volmeter to source %s",
-		     name);
-	}
-	obs_source_release(as);
-
-	return volmeter;
-}
-
 void AudioSwitch::resetVolmeter()
 {
-	obs_volmeter_remove_callback(volmeter, setVolumeLevel, this);
-	obs_volmeter_destroy(volmeter);
-
-	volmeter = AddVolmeterToSource(this, audioSource);
+	audioLevel.SetSource(audioSource);
 }
 
 bool AudioSwitch::initialized()
@@ -313,7 +278,7 @@ void AudioSwitch::load(obs_data_t *obj)
 	duration.Load(obj, "duration");
 	ignoreInactiveSource = obs_data_get_bool(obj, "ignoreInactiveSource");
 
-	volmeter = AddVolmeterToSource(this, audioSource);
+	resetVolmeter();
 }
 
 void AudioSwitchFallback::save(obs_data_t *obj)
@@ -336,57 +301,6 @@ void AudioSwitchFallback::load(obs_data_t *obj)
 	duration.Load(obj, "audioFallbackDuration");
 }
 
-AudioSwitch::AudioSwitch(const AudioSwitch &other)
-	: SceneSwitcherEntry(other.targetType, other.group, other.scene,
-			     other.transition, other.usePreviousScene),
-	  audioSource(other.audioSource),
-	  volumeThreshold(other.volumeThreshold),
-	  condition(other.condition),
-	  duration(other.duration)
-{
-	volmeter = AddVolmeterToSource(this, other.audioSource);
-}
-
-AudioSwitch::AudioSwitch(AudioSwitch &&other)
-	: SceneSwitcherEntry(other.targetType, other.group, other.scene,
-			     other.transition, other.usePreviousScene),
-	  audioSource(other.audioSource),
-	  volumeThreshold(other.volumeThreshold),
-	  condition(other.condition),
-	  duration(other.duration),
-	  volmeter(other.volmeter)
-{
-	other.volmeter = nullptr;
-}
-
-AudioSwitch::~AudioSwitch()
-{
-	obs_volmeter_remove_callback(volmeter, setVolumeLevel, this);
-	obs_volmeter_destroy(volmeter);
-}
-
-AudioSwitch &AudioSwitch::operator=(const AudioSwitch &other)
-{
-	AudioSwitch t(other);
-	swap(*this, t);
-	return *this = AudioSwitch(other);
-}
-
-AudioSwitch &AudioSwitch::operator=(AudioSwitch &&other) noexcept
-{
-	if (this == &other) {
-		return *this;
-	}
-
-	swap(*this, other);
-
-	obs_volmeter_remove_callback(other.volmeter, setVolumeLevel, this);
-	obs_volmeter_destroy(other.volmeter);
-	other.volmeter = nullptr;
-
-	return *this;
-}
-
 void swap(AudioSwitch &first, AudioSwitch &second)
 {
 	std::swap(first.targetType, second.targetType);
@@ -398,10 +312,7 @@ void swap(AudioSwitch &first, AudioSwitch &second)
 	std::swap(first.volumeThreshold, second.volumeThreshold);
 	std::swap(first.condition, second.condition);
 	std::swap(first.duration, second.duration);
-	std::swap(first.peak, second.peak);
-	std::swap(first.volmeter, second.volmeter);
-	first.resetVolmeter();
-	second.resetVolmeter();
+	std::swap(first.audioLevel, second.audioLevel);
 }
 
 static inline void populateConditionSelection(QComboBox *list)
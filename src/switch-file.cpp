@@ -72,6 +72,26 @@ void AdvSceneSwitcher::on_writePathLineEdit_textChanged(const QString &text)
 	switcher->fileIO.writePath = text.toUtf8().constData();
 }
 
+void AdvSceneSwitcher::on_sharedMemoryCheckBox_stateChanged(int state)
+{
+	if (loading) {
+		return;
+	}
+
+	if (!state) {
+		// Closing waits for the command watcher, which might be waiting
+		// for switcher->m to request a check
+		switcher->sharedMemory.Close();
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->fileIO.sharedMemoryEnabled = state;
+	if (state && switcher->sharedMemory.Open()) {
+		switcher->updateSharedMemoryScenes();
+		switcher->updateSharedMemoryStatus();
+	}
+}
+
 void AdvSceneSwitcher::on_browseButton_2_clicked()
 {
 	QString path = QFileDialog::getOpenFileName(
@@ -367,6 +387,8 @@ void SwitcherData::saveFileSwitches(obs_data_t *obj)
 	obs_data_set_string(obj, "readPath", fileIO.readPath.c_str());
 	obs_data_set_bool(obj, "writeEnabled", fileIO.writeEnabled);
 	obs_data_set_string(obj, "writePath", fileIO.writePath.c_str());
+	obs_data_set_bool(obj, "sharedMemoryEnabled",
+			  fileIO.sharedMemoryEnabled);
 }
 
 void SwitcherData::loadFileSwitches(obs_data_t *obj)
@@ -391,6 +413,8 @@ void SwitcherData::loadFileSwitches(obs_data_t *obj)
 	obs_data_set_default_bool(obj, "writeEnabled", false);
 	fileIO.writeEnabled = obs_data_get_bool(obj, "writeEnabled");
 	fileIO.writePath = obs_data_get_string(obj, "writePath");
+	fileIO.sharedMemoryEnabled =
+		obs_data_get_bool(obj, "sharedMemoryEnabled");
 }
 
 void AdvSceneSwitcher::setupFileTab()
@@ -428,6 +452,8 @@ void AdvSceneSwitcher::setupFileTab()
 	ui->readFileCheckBox->setChecked(switcher->fileIO.readEnabled);
 	ui->writePathLineEdit->setText(
 		QString::fromStdString(switcher->fileIO.writePath.c_str()));
+	ui->sharedMemoryCheckBox->setChecked(
+		switcher->fileIO.sharedMemoryEnabled);
 
 	if (ui->readFileCheckBox->checkState()) {
 		ui->browseButton_2->setDisabled(false);
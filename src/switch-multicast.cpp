@@ -0,0 +1,432 @@
+#include "headers/switch-multicast.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+#include "headers/utility.hpp"
+
+#include <util/platform.h>
+#include <random>
+#include <cstring>
+
+// Packet layout (all values in network byte order):
+//  0  magic "ASSM"
+//  4  version
+//  5  flags (bit 0 = preview, bit 1 = repeated packet)
+//  6  delay in ms after which the switch should be performed
+//     (the remaining delay for repeated packets)
+//  8  sender id
+// 12  sequence number
+// 16  FNV-1a hash of the full scene name
+// 20  transition duration in ms
+// 24  scene name length
+// 25  transition name length
+// 26  reserved
+// 28  scene name followed by transition name
+static const uint8_t packet_magic[4] = {'A', 'S', 'S', 'M'};
+constexpr uint8_t packet_version = 1;
+constexpr uint8_t packet_flag_preview = 1;
+constexpr uint8_t packet_flag_repeat = 2;
+constexpr size_t packet_header_size = 28;
+constexpr size_t max_name_length = 255;
+
+// Number of times each packet is sent to compensate for lost datagrams
+constexpr int multicast_redundancy = 2;
+// Interval in ms in which the most recent scene changes are repeated
+constexpr int multicast_repeat_interval = 1000;
+
+static uint32_t nameHash(const std::string &name)
+{
+	uint32_t hash = 2166136261u;
+	for (unsigned char c : name) {
+		hash ^= c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static void write16(uint8_t *p, uint16_t v)
+{
+	p[0] = v >> 8;
+	p[1] = v & 0xff;
+}
+
+static void write32(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = (v >> 16) & 0xff;
+	p[2] = (v >> 8) & 0xff;
+	p[3] = v & 0xff;
+}
+
+static uint16_t read16(const uint8_t *p)
+{
+	return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t read32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	       ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static std::vector<uint8_t> makePacket(uint32_t id, uint32_t sequence,
+				       bool preview, const std::string &scene,
+				       const std::string &transition,
+				       int duration, int delay)
+{
+	size_t sceneLen = std::min(scene.size(), max_name_length);
+	size_t transitionLen = std::min(transition.size(), max_name_length);
+
+	std::vector<uint8_t> packet(packet_header_size + sceneLen +
+				    transitionLen);
+	uint8_t *p = packet.data();
+	memcpy(p, packet_magic, sizeof(packet_magic));
+	p[4] = packet_version;
+	p[5] = preview ? packet_flag_preview : 0;
+	write16(p + 6, (uint16_t)std::min(std::max(delay, 0), 0xffff));
+	write32(p + 8, id);
+	write32(p + 12, sequence);
+	write32(p + 16, nameHash(scene));
+	write32(p + 20, (uint32_t)duration);
+	p[24] = (uint8_t)sceneLen;
+	p[25] = (uint8_t)transitionLen;
+	memcpy(p + packet_header_size, scene.data(), sceneLen);
+	memcpy(p + packet_header_size + sceneLen, transition.data(),
+	       transitionLen);
+	return packet;
+}
+
+static OBSWeakSource getSceneByHash(uint32_t hash)
+{
+	struct Search {
+		uint32_t hash;
+		OBSWeakSource scene;
+	} search = {hash, nullptr};
+
+	auto checkScene = [](void *param, obs_source_t *source) {
+		auto search = reinterpret_cast<Search *>(param);
+		const char *name = obs_source_get_name(source);
+		if (!name || nameHash(name) != search->hash) {
+			return true;
+		}
+		auto weak = obs_source_get_weak_source(source);
+		search->scene = weak;
+		obs_weak_source_release(weak);
+		return false;
+	};
+	obs_enum_scenes(checkScene, &search);
+	return search.scene;
+}
+
+static uint32_t generateSenderId()
+{
+	std::random_device rd;
+	return rd();
+}
+
+MulticastSender::MulticastSender() : _socket(_io), _id(generateSenderId()) {}
+
+MulticastSender::~MulticastSender()
+{
+	Stop();
+}
+
+bool MulticastSender::Start(const std::string &address, uint16_t port)
+{
+	Stop();
+
+	asio::error_code ec;
+	auto addr = asio::ip::make_address(address, ec);
+	if (ec || !addr.is_multicast()) {
+		blog(LOG_WARNING, "multicast: invalid group address '%s'",
+		     address.c_str());
+		return false;
+	}
+	_endpoint = asio::ip::udp::endpoint(addr, port);
+
+	_socket.open(_endpoint.protocol(), ec);
+	if (ec) {
+		blog(LOG_WARNING, "multicast: failed to open socket: %s",
+		     ec.message().c_str());
+		return false;
+	}
+	// Keep the packets within the local network but allow receivers on
+	// the same machine
+	_socket.set_option(asio::ip::multicast::hops(1), ec);
+	_socket.set_option(asio::ip::multicast::enable_loopback(true), ec);
+
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		_lastScene.clear();
+		_lastPreview.clear();
+		_running = true;
+	}
+	_thread = std::thread(&MulticastSender::Thread, this);
+
+	blog(LOG_INFO, "multicast: sending to %s:%d", address.c_str(), port);
+	return true;
+}
+
+void MulticastSender::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		_running = false;
+	}
+	_cv.notify_all();
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+	if (_socket.is_open()) {
+		asio::error_code ec;
+		_socket.close(ec);
+		blog(LOG_INFO, "multicast: sender stopped");
+	}
+}
+
+void MulticastSender::Send(const sceneSwitchInfo &sceneSwitch, bool preview,
+			   int delay)
+{
+	if (!_running || !sceneSwitch.scene) {
+		return;
+	}
+
+	std::string scene = GetWeakSourceName(sceneSwitch.scene);
+	std::string transition = GetWeakSourceName(sceneSwitch.transition);
+
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (!_running) {
+		return;
+	}
+
+	uint32_t sequence = preview ? ++_previewSequence : ++_sceneSequence;
+	auto packet = makePacket(_id, sequence, preview, scene, transition,
+				 sceneSwitch.duration, delay);
+	for (int i = 0; i < multicast_redundancy; i++) {
+		SendPacket(packet);
+	}
+	if (preview) {
+		_lastPreview = std::move(packet);
+		_lastPreviewTime = os_gettime_ns();
+		_lastPreviewDelay = delay;
+	} else {
+		_lastScene = std::move(packet);
+		_lastSceneTime = os_gettime_ns();
+		_lastSceneDelay = delay;
+	}
+
+	vblog(LOG_INFO, "multicast: sent %s '%s' (sequence %u)",
+	      preview ? "preview" : "scene", scene.c_str(), sequence);
+}
+
+void MulticastSender::SendPacket(const std::vector<uint8_t> &packet)
+{
+	asio::error_code ec;
+	_socket.send_to(asio::buffer(packet), _endpoint, 0, ec);
+	if (ec) {
+		blog(LOG_WARNING, "multicast: send failed: %s",
+		     ec.message().c_str());
+	}
+}
+
+void MulticastSender::SendRepeat(std::vector<uint8_t> packet,
+				 uint64_t sendTime, int delay)
+{
+	int elapsed = (int)((os_gettime_ns() - sendTime) / 1000000);
+	packet[5] |= packet_flag_repeat;
+	write16(packet.data() + 6,
+		(uint16_t)std::min(std::max(delay - elapsed, 0), 0xffff));
+	SendPacket(packet);
+}
+
+void MulticastSender::Thread()
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+	while (_running) {
+		_cv.wait_for(lock, std::chrono::milliseconds(
+					   multicast_repeat_interval));
+		if (!_running) {
+			break;
+		}
+		// Receivers drop packets they already know, so this only
+		// affects receivers which missed them
+		if (!_lastScene.empty()) {
+			SendRepeat(_lastScene, _lastSceneTime,
+				   _lastSceneDelay);
+		}
+		if (!_lastPreview.empty()) {
+			SendRepeat(_lastPreview, _lastPreviewTime,
+				   _lastPreviewDelay);
+		}
+	}
+}
+
+MulticastReceiver::~MulticastReceiver()
+{
+	Stop();
+}
+
+bool MulticastReceiver::Start(const std::string &address, uint16_t port)
+{
+	Stop();
+
+	asio::error_code ec;
+	auto addr = asio::ip::make_address(address, ec);
+	if (ec || !addr.is_multicast()) {
+		blog(LOG_WARNING, "multicast: invalid group address '%s'",
+		     address.c_str());
+		return false;
+	}
+
+	asio::ip::udp::endpoint listenEndpoint(
+		addr.is_v4() ? asio::ip::udp::v4() : asio::ip::udp::v6(),
+		port);
+	_socket = std::make_unique<asio::ip::udp::socket>(_io);
+	_socket->open(listenEndpoint.protocol(), ec);
+	if (!ec) {
+		// Allow multiple receivers on the same machine
+		_socket->set_option(asio::ip::udp::socket::reuse_address(true),
+				    ec);
+		_socket->bind(listenEndpoint, ec);
+	}
+	if (!ec) {
+		_socket->set_option(asio::ip::multicast::join_group(addr), ec);
+	}
+	if (ec) {
+		blog(LOG_WARNING, "multicast: failed to join %s:%d: %s",
+		     address.c_str(), port, ec.message().c_str());
+		_socket.reset();
+		return false;
+	}
+
+	_received = 0;
+	_lost = 0;
+	_sequences.clear();
+	_io.restart();
+	Receive();
+	_running = true;
+	_thread = std::thread([this]() { _io.run(); });
+
+	blog(LOG_INFO, "multicast: receiving from %s:%d", address.c_str(),
+	     port);
+	return true;
+}
+
+void MulticastReceiver::Stop()
+{
+	if (!_socket) {
+		return;
+	}
+
+	_io.stop();
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+	asio::error_code ec;
+	_socket->close(ec);
+	_socket.reset();
+	_running = false;
+	blog(LOG_INFO, "multicast: receiver stopped");
+}
+
+void MulticastReceiver::Receive()
+{
+	_socket->async_receive_from(
+		asio::buffer(_buffer), _senderEndpoint,
+		[this](const asio::error_code &ec, size_t size) {
+			if (ec == asio::error::operation_aborted) {
+				return;
+			}
+			if (!ec) {
+				HandlePacket(_buffer, size);
+			}
+			Receive();
+		});
+}
+
+void MulticastReceiver::HandlePacket(const uint8_t *data, size_t size)
+{
+	if (size < packet_header_size ||
+	    memcmp(data, packet_magic, sizeof(packet_magic)) != 0 ||
+	    data[4] != packet_version) {
+		return;
+	}
+
+	bool preview = data[5] & packet_flag_preview;
+	bool repeat = data[5] & packet_flag_repeat;
+	int delay = read16(data + 6);
+	uint32_t id = read32(data + 8);
+	uint32_t sequence = read32(data + 12);
+	uint32_t hash = read32(data + 16);
+	int duration = (int32_t)read32(data + 20);
+	size_t sceneLen = data[24];
+	size_t transitionLen = data[25];
+	if (packet_header_size + sceneLen + transitionLen > size) {
+		return;
+	}
+
+	// Packets of the local sender are looped back
+	if (id == switcher->multicastSender.GetId()) {
+		return;
+	}
+
+	auto key = std::make_pair(id, preview);
+	auto it = _sequences.find(key);
+	if (it != _sequences.end()) {
+		int32_t diff = (int32_t)(sequence - it->second);
+		// Duplicate, repeated or reordered packet
+		if (diff <= 0) {
+			return;
+		}
+		if (diff > 1) {
+			_lost += diff - 1;
+			blog(LOG_WARNING,
+			     "multicast: missed %d packets from sender %08x",
+			     diff - 1, id);
+		}
+	} else if (repeat) {
+		// The scene change might have happened long before this
+		// receiver was started, so only synchronize the sequence
+		_sequences[key] = sequence;
+		vblog(LOG_INFO,
+		      "multicast: synchronized with sender %08x (sequence %u)",
+		      id, sequence);
+		return;
+	}
+	_sequences[key] = sequence;
+	_received++;
+
+	std::string sceneName((const char *)data + packet_header_size,
+			      sceneLen);
+	std::string transitionName(
+		(const char *)data + packet_header_size + sceneLen,
+		transitionLen);
+
+	// Names longer than max_name_length are truncated so fall back to
+	// the hash of the full name
+	auto scene = GetWeakSourceByName(sceneName.c_str());
+	if (!scene) {
+		scene = getSceneByHash(hash);
+	}
+	if (!scene) {
+		blog(LOG_WARNING, "multicast: ignoring unknown scene '%s'",
+		     sceneName.c_str());
+		return;
+	}
+
+	// Scene changes received via multicast are not forwarded to avoid
+	// loops between multiple senders, which includes the frontend scene
+	// change events caused by them
+	SceneSwitchRequest request;
+	request.scene = scene;
+	request.transition = GetWeakTransitionByName(transitionName.c_str());
+	request.duration = duration;
+	request.preview = preview;
+	request.forward = false;
+	request.origin = os_gettime_ns();
+	if (delay > 0) {
+		request.time = request.origin + (uint64_t)delay * 1000000;
+	}
+	switcher->switchQueue.Push(request);
+
+	vblog(LOG_INFO, "multicast: received %s '%s' (sequence %u)",
+	      preview ? "preview" : "scene", sceneName.c_str(), sequence);
+}
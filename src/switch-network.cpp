@@ -10,6 +10,9 @@ Most of this code is based on https://github.com/Palakis/obs-websocket
 #include "headers/advanced-scene-switcher.hpp"
 #include "headers/utility.hpp"
 
+#include <util/platform.h>
+#include <algorithm>
+
 #define PARAM_SERVER_ENABLE "ServerEnabled"
 #define PARAM_SERVER_PORT "ServerPort"
 #define PARAM_LOCKTOIPV4 "LockToIPv4"
@@ -20,13 +23,43 @@ Most of this code is based on https://github.com/Palakis/obs-websocket
 #define PARAM_CLIENT_SEND_SCENE_CHANGE "SendSceneChange"
 #define PARAM_CLIENT_SEND_SCENE_CHANGE_ALL "SendSceneChangeAll"
 #define PARAM_CLIENT_SENDPREVIEW "SendPreview"
+#define PARAM_COALESCE_INTERVAL "CoalesceInterval"
+#define PARAM_SYNC_SWITCH "SyncSwitch"
+#define PARAM_SYNC_DELAY "SyncDelay"
+
+#define PARAM_MULTICAST_ENABLE "MulticastEnabled"
+#define PARAM_MULTICAST_SEND "MulticastSend"
+#define PARAM_MULTICAST_RECEIVE "MulticastReceive"
+#define PARAM_MULTICAST_ADDRESS "MulticastAddress"
+#define PARAM_MULTICAST_PORT "MulticastPort"
+
+#define PARAM_OSC_ENABLE "OSCEnabled"
+#define PARAM_OSC_PORT "OSCPort"
 
 #define RECONNECT_DELAY 10
+// Time in seconds to wait for clients to acknowledge closing the connection
+#define CLOSE_TIMEOUT 5
+// Interval in seconds in which clients resynchronize their clock
+#define CLOCK_SYNC_INTERVAL 2
+// Number of clock sync results to choose the most accurate one from
+#define CLOCK_SYNC_SAMPLES 8
 
 #define SCENE_ENTRY "scene"
 #define TRANSITION_ENTRY "transition"
 #define TRANSITION_DURATION "duration"
 #define SET_PREVIEW "preview"
+#define SWITCH_TIME "switchAt"
+#define SYNC_REQUEST "syncRequest"
+#define SYNC_RESPONSE "syncResponse"
+#define SERVER_TIME "serverTime"
+
+// Clients with more than this many bytes waiting to be sent are considered
+// lagging and will only receive the most recent state
+constexpr size_t lagging_buffer_size = 4 * 1024;
+// Clients with more than this many bytes waiting to be sent are disconnected
+constexpr size_t max_buffer_size = 1024 * 1024;
+// Interval in ms in which messages for lagging clients are retried
+constexpr long lagging_retry_interval = 50;
 
 using websocketpp::lib::placeholders::_1;
 using websocketpp::lib::placeholders::_2;
@@ -41,7 +74,17 @@ NetworkConfig::NetworkConfig()
 	  ClientPort(55555),
 	  SendSceneChange(true),
 	  SendSceneChangeAll(true),
-	  SendPreview(true)
+	  SendPreview(true),
+	  CoalesceInterval(0),
+	  SyncSwitch(false),
+	  SyncDelay(200),
+	  MulticastEnabled(false),
+	  MulticastSend(true),
+	  MulticastReceive(false),
+	  MulticastAddress("239.255.43.21"),
+	  MulticastPort(55556),
+	  OSCEnabled(false),
+	  OSCPort(9000)
 {
 }
 
@@ -61,6 +104,18 @@ void NetworkConfig::Load(obs_data_t *obj)
 	SendSceneChangeAll =
 		obs_data_get_bool(obj, PARAM_CLIENT_SEND_SCENE_CHANGE_ALL);
 	SendPreview = obs_data_get_bool(obj, PARAM_CLIENT_SENDPREVIEW);
+	CoalesceInterval = obs_data_get_int(obj, PARAM_COALESCE_INTERVAL);
+	SyncSwitch = obs_data_get_bool(obj, PARAM_SYNC_SWITCH);
+	SyncDelay = obs_data_get_int(obj, PARAM_SYNC_DELAY);
+
+	MulticastEnabled = obs_data_get_bool(obj, PARAM_MULTICAST_ENABLE);
+	MulticastSend = obs_data_get_bool(obj, PARAM_MULTICAST_SEND);
+	MulticastReceive = obs_data_get_bool(obj, PARAM_MULTICAST_RECEIVE);
+	MulticastAddress = obs_data_get_string(obj, PARAM_MULTICAST_ADDRESS);
+	MulticastPort = obs_data_get_int(obj, PARAM_MULTICAST_PORT);
+
+	OSCEnabled = obs_data_get_bool(obj, PARAM_OSC_ENABLE);
+	OSCPort = obs_data_get_int(obj, PARAM_OSC_PORT);
 }
 
 void NetworkConfig::Save(obs_data_t *obj)
@@ -76,6 +131,19 @@ void NetworkConfig::Save(obs_data_t *obj)
 	obs_data_set_bool(obj, PARAM_CLIENT_SEND_SCENE_CHANGE_ALL,
 			  SendSceneChangeAll);
 	obs_data_set_bool(obj, PARAM_CLIENT_SENDPREVIEW, SendPreview);
+	obs_data_set_int(obj, PARAM_COALESCE_INTERVAL, CoalesceInterval);
+	obs_data_set_bool(obj, PARAM_SYNC_SWITCH, SyncSwitch);
+	obs_data_set_int(obj, PARAM_SYNC_DELAY, SyncDelay);
+
+	obs_data_set_bool(obj, PARAM_MULTICAST_ENABLE, MulticastEnabled);
+	obs_data_set_bool(obj, PARAM_MULTICAST_SEND, MulticastSend);
+	obs_data_set_bool(obj, PARAM_MULTICAST_RECEIVE, MulticastReceive);
+	obs_data_set_string(obj, PARAM_MULTICAST_ADDRESS,
+			    MulticastAddress.c_str());
+	obs_data_set_int(obj, PARAM_MULTICAST_PORT, MulticastPort);
+
+	obs_data_set_bool(obj, PARAM_OSC_ENABLE, OSCEnabled);
+	obs_data_set_int(obj, PARAM_OSC_PORT, OSCPort);
 }
 
 void NetworkConfig::SetDefaults(obs_data_t *obj)
@@ -92,6 +160,22 @@ void NetworkConfig::SetDefaults(obs_data_t *obj)
 	obs_data_set_default_bool(obj, PARAM_CLIENT_SEND_SCENE_CHANGE_ALL,
 				  SendSceneChangeAll);
 	obs_data_set_default_bool(obj, PARAM_CLIENT_SENDPREVIEW, SendPreview);
+	obs_data_set_default_int(obj, PARAM_COALESCE_INTERVAL,
+				 CoalesceInterval);
+	obs_data_set_default_bool(obj, PARAM_SYNC_SWITCH, SyncSwitch);
+	obs_data_set_default_int(obj, PARAM_SYNC_DELAY, SyncDelay);
+
+	obs_data_set_default_bool(obj, PARAM_MULTICAST_ENABLE,
+				  MulticastEnabled);
+	obs_data_set_default_bool(obj, PARAM_MULTICAST_SEND, MulticastSend);
+	obs_data_set_default_bool(obj, PARAM_MULTICAST_RECEIVE,
+				  MulticastReceive);
+	obs_data_set_default_string(obj, PARAM_MULTICAST_ADDRESS,
+				    MulticastAddress.c_str());
+	obs_data_set_default_int(obj, PARAM_MULTICAST_PORT, MulticastPort);
+
+	obs_data_set_default_bool(obj, PARAM_OSC_ENABLE, OSCEnabled);
+	obs_data_set_default_int(obj, PARAM_OSC_PORT, OSCPort);
 }
 
 std::string NetworkConfig::GetClientUri()
@@ -101,7 +185,7 @@ std::string NetworkConfig::GetClientUri()
 
 bool NetworkConfig::ShouldSendSceneChange()
 {
-	return ServerEnabled && SendSceneChange;
+	return (ServerEnabled || ShouldSendMulticast()) && SendSceneChange;
 }
 
 bool NetworkConfig::ShouldSendFrontendSceneChange()
@@ -111,7 +195,22 @@ bool NetworkConfig::ShouldSendFrontendSceneChange()
 
 bool NetworkConfig::ShouldSendPrviewSceneChange()
 {
-	return ServerEnabled && SendPreview;
+	return (ServerEnabled || ShouldSendMulticast()) && SendPreview;
+}
+
+bool NetworkConfig::ShouldSynchronizeSceneChange()
+{
+	return ShouldSendSceneChange() && SyncSwitch && SyncDelay > 0;
+}
+
+bool NetworkConfig::ShouldSendMulticast()
+{
+	return MulticastEnabled && MulticastSend;
+}
+
+bool NetworkConfig::ShouldReceiveMulticast()
+{
+	return MulticastEnabled && MulticastReceive;
 }
 
 WSServer::WSServer()
@@ -207,25 +306,65 @@ void WSServer::stop()
 	}
 
 	_server.stop_listening();
-	for (connection_hdl hdl : _connections) {
-		websocketpp::lib::error_code ec;
-		_server.close(hdl, websocketpp::close::status::going_away,
-			      "Server stopping", ec);
+	{
+		QMutexLocker locker(&_clMutex);
+		for (connection_hdl hdl : _connections) {
+			websocketpp::lib::error_code ec;
+			_server.close(hdl,
+				      websocketpp::close::status::going_away,
+				      "Server stopping", ec);
+		}
+		_pendingScene.reset();
+		_pendingPreview.reset();
+		_flushScheduled = false;
+		_lagging.clear();
+		_laggingFlushScheduled = false;
 	}
 
 	_threadPool.waitForDone();
 
-	while (_connections.size() > 0) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	std::unique_lock<std::mutex> lock(_closeMtx);
+	bool closed = _closeCv.wait_for(
+		lock, std::chrono::seconds(CLOSE_TIMEOUT), [this]() {
+			QMutexLocker locker(&_clMutex);
+			return _connections.empty();
+		});
+	lock.unlock();
+
+	// Clients which did not react in time (e.g. because of a stalled
+	// network connection) are dropped by stopping the io loop
+	if (!closed) {
+		blog(LOG_WARNING,
+		     "server: clients did not close the connection in time");
+		_server.stop();
+		QMutexLocker locker(&_clMutex);
+		_connections.clear();
 	}
 
 	switcher->serverStatus = ServerStatus::NOT_RUNNING;
 	blog(LOG_INFO, "server stopped successfully");
 }
 
-void WSServer::sendMessage(sceneSwitchInfo sceneSwitch, bool preview)
+static server::message_ptr makeMessage(const std::string &payload)
+{
+	// Frame the message only once so the same buffer can be queued on all
+	// connections instead of copying and framing it for each of them
+	auto message = websocketpp::lib::make_shared<
+		server::message_ptr::element_type>(
+		nullptr, websocketpp::frame::opcode::text);
+	websocketpp::frame::basic_header header(
+		websocketpp::frame::opcode::text, payload.size(), true, false);
+	websocketpp::frame::extended_header extHeader(payload.size());
+	message->set_header(websocketpp::frame::prepare_header(header, extHeader));
+	message->set_payload(payload);
+	message->set_prepared(true);
+	return message;
+}
+
+void WSServer::sendMessage(sceneSwitchInfo sceneSwitch, bool preview,
+			   uint64_t switchTime)
 {
-	if (!sceneSwitch.scene) {
+	if (!sceneSwitch.scene || !_server.is_listening()) {
 		return;
 	}
 
@@ -236,13 +375,82 @@ void WSServer::sendMessage(sceneSwitchInfo sceneSwitch, bool preview)
 			    GetWeakSourceName(sceneSwitch.transition).c_str());
 	obs_data_set_int(data, TRANSITION_DURATION, sceneSwitch.duration);
 	obs_data_set_bool(data, SET_PREVIEW, preview);
-	std::string message = obs_data_get_json(data);
+	if (switchTime) {
+		obs_data_set_int(data, SWITCH_TIME, switchTime);
+	}
+	auto message = makeMessage(obs_data_get_json(data));
 	obs_data_release(data);
 
+	int interval = switcher->networkConfig.CoalesceInterval;
+	if (interval <= 0) {
+		broadcast(message, preview);
+		return;
+	}
+
+	QMutexLocker locker(&_clMutex);
+	if (preview) {
+		_pendingPreview = message;
+	} else {
+		_pendingScene = message;
+	}
+	if (!_flushScheduled) {
+		_flushScheduled = true;
+		_server.set_timer(interval,
+				  bind(&WSServer::flushPending, this, ::_1));
+	}
+}
+
+void WSServer::flushPending(const websocketpp::lib::error_code &ec)
+{
+	QMutexLocker locker(&_clMutex);
+	_flushScheduled = false;
+	if (ec) {
+		return;
+	}
+
+	if (_pendingScene) {
+		broadcast(_pendingScene, false);
+		_pendingScene.reset();
+	}
+	if (_pendingPreview) {
+		broadcast(_pendingPreview, true);
+		_pendingPreview.reset();
+	}
+}
+
+void WSServer::broadcast(const server::message_ptr &message, bool preview)
+{
+	QMutexLocker locker(&_clMutex);
 	for (connection_hdl hdl : _connections) {
 		websocketpp::lib::error_code ec;
-		_server.send(hdl, message, websocketpp::frame::opcode::text,
-			     ec);
+		auto con = _server.get_con_from_hdl(hdl, ec);
+		if (ec) {
+			continue;
+		}
+
+		size_t buffered = con->get_buffered_amount();
+		if (buffered > max_buffer_size) {
+			blog(LOG_WARNING,
+			     "server: disconnecting client %s - %zu bytes not sent",
+			     con->get_remote_endpoint().c_str(), buffered);
+			con->close(websocketpp::close::status::try_again_later,
+				   "Send buffer exceeded", ec);
+			_lagging.erase(hdl);
+			continue;
+		}
+
+		auto it = _lagging.find(hdl);
+		if (buffered > lagging_buffer_size || it != _lagging.end()) {
+			auto &lagging = _lagging[hdl];
+			if (preview) {
+				lagging.preview = message;
+			} else {
+				lagging.scene = message;
+			}
+			continue;
+		}
+
+		ec = con->send(message);
 		if (ec) {
 			std::string errorCodeMessage = ec.message();
 			blog(LOG_INFO, "server: send failed: %s",
@@ -250,8 +458,61 @@ void WSServer::sendMessage(sceneSwitchInfo sceneSwitch, bool preview)
 		}
 	}
 
+	if (!_lagging.empty() && !_laggingFlushScheduled) {
+		_laggingFlushScheduled = true;
+		_server.set_timer(lagging_retry_interval,
+				  bind(&WSServer::flushLagging, this, ::_1));
+	}
+
 	if (switcher->verbose) {
-		blog(LOG_INFO, "server sent message:\n%s", message.c_str());
+		blog(LOG_INFO, "server sent message:\n%s",
+		     message->get_payload().c_str());
+	}
+}
+
+void WSServer::flushLagging(const websocketpp::lib::error_code &ec)
+{
+	QMutexLocker locker(&_clMutex);
+	_laggingFlushScheduled = false;
+	if (ec) {
+		return;
+	}
+
+	for (auto it = _lagging.begin(); it != _lagging.end();) {
+		websocketpp::lib::error_code conError;
+		auto con = _server.get_con_from_hdl(it->first, conError);
+		if (conError ||
+		    _connections.find(it->first) == _connections.end()) {
+			it = _lagging.erase(it);
+			continue;
+		}
+		size_t buffered = con->get_buffered_amount();
+		if (buffered > max_buffer_size) {
+			blog(LOG_WARNING,
+			     "server: disconnecting client %s - %zu bytes not sent",
+			     con->get_remote_endpoint().c_str(), buffered);
+			con->close(websocketpp::close::status::try_again_later,
+				   "Send buffer exceeded", conError);
+			it = _lagging.erase(it);
+			continue;
+		}
+		if (buffered > lagging_buffer_size) {
+			++it;
+			continue;
+		}
+		if (it->second.scene) {
+			con->send(it->second.scene);
+		}
+		if (it->second.preview) {
+			con->send(it->second.preview);
+		}
+		it = _lagging.erase(it);
+	}
+
+	if (!_lagging.empty()) {
+		_laggingFlushScheduled = true;
+		_server.set_timer(lagging_retry_interval,
+				  bind(&WSServer::flushLagging, this, ::_1));
 	}
 }
 
@@ -266,18 +527,8 @@ void WSServer::onOpen(connection_hdl hdl)
 	     clientIp.toUtf8().constData());
 }
 
-std::string processMessage(std::string payload)
+std::string WSClient::processMessage(obs_data_t *data)
 {
-	auto config = switcher->networkConfig;
-	std::string msgContainer(payload);
-	const char *msg = msgContainer.c_str();
-
-	OBSData data = obs_data_create_from_json(msg);
-	if (!data) {
-		blog(LOG_ERROR, "invalid JSON payload received for '%s'", msg);
-		return "invalid JSON payload";
-	}
-
 	if (!obs_data_has_user_value(data, SCENE_ENTRY) ||
 	    !obs_data_has_user_value(data, TRANSITION_ENTRY) ||
 	    !obs_data_has_user_value(data, TRANSITION_DURATION) ||
@@ -290,8 +541,7 @@ std::string processMessage(std::string payload)
 		obs_data_get_string(data, TRANSITION_ENTRY);
 	int duration = obs_data_get_int(data, TRANSITION_DURATION);
 	bool preview = obs_data_get_bool(data, SET_PREVIEW);
-
-	obs_data_release(data);
+	uint64_t switchTime = obs_data_get_int(data, SWITCH_TIME);
 
 	auto scene = GetWeakSourceByName(sceneName.c_str());
 	if (!scene) {
@@ -305,23 +555,54 @@ std::string processMessage(std::string payload)
 		ret += " - ignoring invalid transition: '" + transitionName +
 		       "'";
 	}
-	if (preview) {
-		switchPreviewScene(scene);
-	} else {
-		switchScene({scene, transition, duration});
+
+	// Do not block the client thread until the switch was performed
+	SceneSwitchRequest request;
+	request.scene = scene;
+	request.transition = transition;
+	request.duration = duration;
+	request.preview = preview;
+	request.forward = !switchTime;
+	request.origin = os_gettime_ns();
+	if (switchTime && _clockSynced) {
+		request.time = switchTime - _clockOffset;
 	}
+	switcher->switchQueue.Push(request);
 	return ret;
 }
 
 void WSServer::onMessage(connection_hdl hdl, server::message_ptr message)
 {
-	UNUSED_PARAMETER(hdl);
+	// Take the timestamp as early as possible to keep the clock sync
+	// accurate
+	uint64_t receiveTime = os_gettime_ns();
 
 	auto opcode = message->get_opcode();
 	if (opcode != websocketpp::frame::opcode::text) {
 		return;
 	}
 
+	// Answer clock sync requests right away on the io thread.
+	// Responses to scene switch messages are plain text, so only parse
+	// payloads which look like JSON objects
+	const auto &payload = message->get_payload();
+	OBSData data;
+	if (!payload.empty() && payload[0] == '{') {
+		data = obs_data_create_from_json(payload.c_str());
+		obs_data_release(data);
+	}
+	if (data && obs_data_has_user_value(data, SYNC_REQUEST)) {
+		OBSData response = obs_data_create();
+		obs_data_release(response);
+		obs_data_set_int(response, SYNC_RESPONSE,
+				 obs_data_get_int(data, SYNC_REQUEST));
+		obs_data_set_int(response, SERVER_TIME, receiveTime);
+		websocketpp::lib::error_code ec;
+		_server.send(hdl, obs_data_get_json(response),
+			     websocketpp::frame::opcode::text, ec);
+		return;
+	}
+
 	QtConcurrent::run(&_threadPool, [=]() {
 		if (message->get_payload() != "message ok") {
 			blog(LOG_WARNING, "received response: %s",
@@ -334,8 +615,14 @@ void WSServer::onClose(connection_hdl hdl)
 {
 	QMutexLocker locker(&_clMutex);
 	_connections.erase(hdl);
+	_lagging.erase(hdl);
 	locker.unlock();
 
+	{
+		std::lock_guard<std::mutex> lock(_closeMtx);
+		_closeCv.notify_all();
+	}
+
 	auto conn = _server.get_con_from_hdl(hdl);
 	auto localCloseCode = conn->get_local_close_code();
 
@@ -454,6 +741,66 @@ void WSClient::onOpen(connection_hdl hdl)
 	UNUSED_PARAMETER(hdl);
 	blog(LOG_INFO, "connection to %s opened", _uri.c_str());
 	switcher->clientStatus = ClientStatus::CONNECTED;
+
+	_clockSamples.clear();
+	_clockSynced = false;
+	sendSyncRequest({});
+}
+
+void WSClient::sendSyncRequest(const websocketpp::lib::error_code &ec)
+{
+	if (ec || !_connected) {
+		return;
+	}
+
+	OBSData data = obs_data_create();
+	obs_data_release(data);
+	obs_data_set_int(data, SYNC_REQUEST, os_gettime_ns());
+	websocketpp::lib::error_code errorCode;
+	_client.send(_connection, obs_data_get_json(data),
+		     websocketpp::frame::opcode::text, errorCode);
+	if (errorCode) {
+		return;
+	}
+
+	// Collect the first samples quickly so synchronized switches are
+	// possible shortly after connecting
+	long delay = _clockSamples.size() < CLOCK_SYNC_SAMPLES
+			     ? 100
+			     : CLOCK_SYNC_INTERVAL * 1000;
+	_client.set_timer(delay, bind(&WSClient::sendSyncRequest, this, ::_1));
+}
+
+void WSClient::handleSyncResponse(obs_data_t *data)
+{
+	// NTP style offset estimation assuming symmetric network delays
+	int64_t receiveTime = os_gettime_ns();
+	int64_t sendTime = obs_data_get_int(data, SYNC_RESPONSE);
+	int64_t serverTime = obs_data_get_int(data, SERVER_TIME);
+
+	ClockSample sample;
+	sample.rtt = receiveTime - sendTime;
+	sample.offset = serverTime - (sendTime + receiveTime) / 2;
+	if (sample.rtt < 0) {
+		return;
+	}
+
+	_clockSamples.push_back(sample);
+	if (_clockSamples.size() > CLOCK_SYNC_SAMPLES) {
+		_clockSamples.pop_front();
+	}
+
+	// The sample with the lowest round trip time is least affected by
+	// asymmetric delays
+	auto best = std::min_element(_clockSamples.begin(), _clockSamples.end(),
+				     [](const auto &a, const auto &b) {
+					     return a.rtt < b.rtt;
+				     });
+	_clockOffset = best->offset;
+	_clockSynced = true;
+
+	vblog(LOG_INFO, "clock offset to server %lld ns (round trip %lld ns)",
+	      (long long)best->offset, (long long)best->rtt);
 }
 
 void WSClient::onFail(connection_hdl hdl)
@@ -470,7 +817,21 @@ void WSClient::onMessage(connection_hdl hdl, client::message_ptr message)
 	}
 
 	std::string payload = message->get_payload();
-	std::string response = processMessage(payload);
+	OBSData data = obs_data_create_from_json(payload.c_str());
+	obs_data_release(data);
+
+	std::string response;
+	if (!data) {
+		blog(LOG_ERROR, "invalid JSON payload received for '%s'",
+		     payload.c_str());
+		response = "invalid JSON payload";
+	} else if (obs_data_has_user_value(data, SYNC_RESPONSE)) {
+		handleSyncResponse(data);
+		return;
+	} else {
+		response = processMessage(data);
+	}
+
 	websocketpp::lib::error_code errorCode;
 	_client.send(hdl, response, websocketpp::frame::opcode::text,
 		     errorCode);
@@ -504,6 +865,29 @@ void SwitcherData::saveNetworkSwitches(obs_data_t *obj)
 	if (!networkConfig.ServerEnabled) {
 		server.stop();
 	}
+	if (!networkConfig.ShouldSendMulticast()) {
+		multicastSender.Stop();
+	}
+	if (!networkConfig.ShouldReceiveMulticast()) {
+		multicastReceiver.Stop();
+	}
+}
+
+void SwitcherData::startMulticast()
+{
+	if (networkConfig.ShouldSendMulticast()) {
+		multicastSender.Start(networkConfig.MulticastAddress,
+				      networkConfig.MulticastPort);
+	} else {
+		multicastSender.Stop();
+	}
+
+	if (networkConfig.ShouldReceiveMulticast()) {
+		multicastReceiver.Start(networkConfig.MulticastAddress,
+					networkConfig.MulticastPort);
+	} else {
+		multicastReceiver.Stop();
+	}
 }
 
 void AdvSceneSwitcher::setupNetworkTab()
@@ -520,13 +904,32 @@ void AdvSceneSwitcher::setupNetworkTab()
 	ui->restrictSend->setChecked(
 		!switcher->networkConfig.SendSceneChangeAll);
 	ui->sendPreview->setChecked(switcher->networkConfig.SendPreview);
+	ui->coalesceInterval->setValue(
+		switcher->networkConfig.CoalesceInterval);
+	ui->syncSwitch->setChecked(switcher->networkConfig.SyncSwitch);
+	ui->syncDelay->setValue(switcher->networkConfig.SyncDelay);
 	ui->restrictSend->setDisabled(!switcher->networkConfig.SendSceneChange);
 
+	ui->multicastSettings->setChecked(
+		switcher->networkConfig.MulticastEnabled);
+	ui->multicastAddress->setText(
+		switcher->networkConfig.MulticastAddress.c_str());
+	ui->multicastPort->setValue(switcher->networkConfig.MulticastPort);
+	ui->multicastSend->setChecked(switcher->networkConfig.MulticastSend);
+	ui->multicastReceive->setChecked(
+		switcher->networkConfig.MulticastReceive);
+
+	ui->oscSettings->setChecked(switcher->networkConfig.OSCEnabled);
+	ui->oscPort->setValue(switcher->networkConfig.OSCPort);
+
 	QTimer *statusTimer = new QTimer(this);
 	connect(statusTimer, SIGNAL(timeout()), this,
 		SLOT(updateClientStatus()));
 	connect(statusTimer, SIGNAL(timeout()), this,
 		SLOT(updateServerStatus()));
+	connect(statusTimer, SIGNAL(timeout()), this,
+		SLOT(updateMulticastStatus()));
+	connect(statusTimer, SIGNAL(timeout()), this, SLOT(updateOSCStatus()));
 	statusTimer->start(500);
 }
 
@@ -665,6 +1068,36 @@ void AdvSceneSwitcher::on_sendPreview_stateChanged(int state)
 	switcher->networkConfig.SendPreview = state;
 }
 
+void AdvSceneSwitcher::on_coalesceInterval_valueChanged(int value)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->networkConfig.CoalesceInterval = value;
+}
+
+void AdvSceneSwitcher::on_syncSwitch_stateChanged(int state)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->networkConfig.SyncSwitch = state;
+}
+
+void AdvSceneSwitcher::on_syncDelay_valueChanged(int value)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->networkConfig.SyncDelay = value;
+}
+
 void AdvSceneSwitcher::on_clientReconnect_clicked()
 {
 	if (loading) {
@@ -698,3 +1131,141 @@ void AdvSceneSwitcher::updateClientStatus()
 		break;
 	}
 }
+
+void AdvSceneSwitcher::on_multicastSettings_toggled(bool on)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->networkConfig.MulticastEnabled = on;
+	switcher->startMulticast();
+}
+
+void AdvSceneSwitcher::on_multicastAddress_textChanged(const QString &text)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->networkConfig.MulticastAddress = text.toUtf8().constData();
+}
+
+void AdvSceneSwitcher::on_multicastPort_valueChanged(int value)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->networkConfig.MulticastPort = value;
+}
+
+void AdvSceneSwitcher::on_multicastSend_stateChanged(int state)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->networkConfig.MulticastSend = state;
+	switcher->startMulticast();
+}
+
+void AdvSceneSwitcher::on_multicastReceive_stateChanged(int state)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->networkConfig.MulticastReceive = state;
+	switcher->startMulticast();
+}
+
+void AdvSceneSwitcher::on_multicastRestart_clicked()
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->startMulticast();
+}
+
+void AdvSceneSwitcher::updateMulticastStatus()
+{
+	bool sending = switcher->multicastSender.IsRunning();
+	bool receiving = switcher->multicastReceiver.IsRunning();
+	if (!sending && !receiving) {
+		ui->multicastStatus->setText(obs_module_text(
+			"AdvSceneSwitcher.networkTab.multicast.status.notRunning"));
+		return;
+	}
+
+	QString status;
+	if (sending) {
+		status = obs_module_text(
+			"AdvSceneSwitcher.networkTab.multicast.status.sending");
+	}
+	if (receiving) {
+		if (!status.isEmpty()) {
+			status += " / ";
+		}
+		status += QString(obs_module_text(
+				  "AdvSceneSwitcher.networkTab.multicast.status.receiving"))
+				  .arg(switcher->multicastReceiver.GetReceived())
+				  .arg(switcher->multicastReceiver.GetLost());
+	}
+	ui->multicastStatus->setText(status);
+}
+
+// The OSC listener is started and stopped without holding the switcher lock
+// as its thread might be waiting for the lock to wake up the switcher thread
+
+void AdvSceneSwitcher::on_oscSettings_toggled(bool on)
+{
+	if (loading) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(switcher->m);
+		switcher->networkConfig.OSCEnabled = on;
+	}
+	switcher->startOSC();
+}
+
+void AdvSceneSwitcher::on_oscPort_valueChanged(int value)
+{
+	if (loading) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switcher->networkConfig.OSCPort = value;
+}
+
+void AdvSceneSwitcher::on_oscRestart_clicked()
+{
+	if (loading) {
+		return;
+	}
+
+	switcher->startOSC();
+}
+
+void AdvSceneSwitcher::updateOSCStatus()
+{
+	if (!switcher->oscListener.IsRunning()) {
+		ui->oscStatus->setText(obs_module_text(
+			"AdvSceneSwitcher.networkTab.osc.status.notRunning"));
+		return;
+	}
+	ui->oscStatus->setText(
+		QString(obs_module_text(
+				"AdvSceneSwitcher.networkTab.osc.status.running"))
+			.arg(switcher->oscListener.GetReceived()));
+}
@@ -1,5 +1,3 @@
-#include <random>
-
 #include "headers/advanced-scene-switcher.hpp"
 #include "headers/utility.hpp"
 
@@ -10,6 +8,7 @@ void AdvSceneSwitcher::on_randomAdd_clicked()
 {
 	std::lock_guard<std::mutex> lock(switcher->m);
 	switcher->randomSwitches.emplace_back();
+	switcher->randomSelectionChanged = true;
 
 	listAddClicked(ui->randomSwitches,
 		       new RandomSwitchWidget(this,
@@ -31,6 +30,7 @@ void AdvSceneSwitcher::on_randomRemove_clicked()
 		int idx = ui->randomSwitches->currentRow();
 		auto &switches = switcher->randomSwitches;
 		switches.erase(switches.begin() + idx);
+		switcher->randomSelectionChanged = true;
 	}
 
 	delete item;
@@ -43,40 +43,41 @@ bool SwitcherData::checkRandom(OBSWeakSource &scene, OBSWeakSource &transition,
 		return false;
 	}
 
-	std::deque<RandomSwitch> rs(randomSwitches);
-	std::random_device rng;
-	std::mt19937 urng(rng());
-	std::shuffle(rs.begin(), rs.end(), urng);
-	bool match = false;
-	for (RandomSwitch &r : rs) {
+	if (randomSelectionChanged) {
+		randomSelector.SetWeights(
+			randomSwitches.size(),
+			[this](size_t i) { return randomSwitches[i].weight; });
+		randomSelectionChanged = false;
+	}
+
+	int idx = randomSelector.Draw([this](size_t i) {
+		RandomSwitch &r = randomSwitches[i];
 		if (!r.initialized()) {
-			continue;
+			return false;
 		}
-
-		if (randomSwitches.size() != 1) {
-			if (r.targetType == SwitchTargetType::Scene &&
-			    r.scene == lastRandomScene) {
-				continue;
-			} else if (r.targetType ==
-					   SwitchTargetType::SceneGroup &&
-				   r.group && r.group == lastRandomSceneGroup) {
-				continue;
-			}
+		if (randomSwitches.size() == 1) {
+			return true;
 		}
+		if (r.targetType == SwitchTargetType::Scene) {
+			return r.scene != lastRandomScene;
+		}
+		return !(r.group && r.group == lastRandomSceneGroup);
+	});
+	if (idx == -1) {
+		return false;
+	}
 
-		scene = r.getScene();
-		transition = r.transition;
-		delay = (int)r.delay * 1000;
-		match = true;
-		lastRandomScene = r.scene;
-		lastRandomSceneGroup = r.group;
+	RandomSwitch &r = randomSwitches[idx];
+	scene = r.getScene();
+	transition = r.transition;
+	delay = (int)r.delay * 1000;
+	lastRandomScene = r.scene;
+	lastRandomSceneGroup = r.group;
 
-		if (verbose) {
-			r.logMatch();
-		}
-		break;
+	if (verbose) {
+		r.logMatch();
 	}
-	return match;
+	return true;
 }
 
 void SwitcherData::saveRandomSwitches(obs_data_t *obj)
@@ -97,6 +98,7 @@ void SwitcherData::saveRandomSwitches(obs_data_t *obj)
 void SwitcherData::loadRandomSwitches(obs_data_t *obj)
 {
 	randomSwitches.clear();
+	randomSelectionChanged = true;
 
 	obs_data_array_t *randomArray =
 		obs_data_get_array(obj, "randomSwitches");
@@ -148,34 +150,46 @@ void RandomSwitch::save(obs_data_t *obj)
 {
 	SceneSwitcherEntry::save(obj, "targetType", "scene");
 	obs_data_set_double(obj, "delay", delay);
+	obs_data_set_double(obj, "weight", weight);
 }
 
 void RandomSwitch::load(obs_data_t *obj)
 {
 	SceneSwitcherEntry::load(obj, "targetType", "scene");
 	delay = obs_data_get_double(obj, "delay");
+	obs_data_set_default_double(obj, "weight", 1.0);
+	weight = obs_data_get_double(obj, "weight");
 }
 
 RandomSwitchWidget::RandomSwitchWidget(QWidget *parent, RandomSwitch *s)
 	: SwitchWidget(parent, s, false, true)
 {
 	delay = new QDoubleSpinBox();
+	weight = new QDoubleSpinBox();
 
 	QWidget::connect(delay, SIGNAL(valueChanged(double)), this,
 			 SLOT(DelayChanged(double)));
+	QWidget::connect(weight, SIGNAL(valueChanged(double)), this,
+			 SLOT(WeightChanged(double)));
 
 	delay->setSuffix("s");
 	delay->setMaximum(999999999.9);
+	weight->setMinimum(0.0);
+	weight->setMaximum(1000.0);
+	weight->setToolTip(
+		obs_module_text("AdvSceneSwitcher.randomTab.weight.tip"));
 
 	if (s) {
 		delay->setValue(s->delay);
+		weight->setValue(s->weight);
 	}
 
 	QHBoxLayout *mainLayout = new QHBoxLayout;
 	std::unordered_map<std::string, QWidget *> widgetPlaceholders = {
 		{"{{scenes}}", scenes},
 		{"{{transitions}}", transitions},
-		{"{{delay}}", delay}};
+		{"{{delay}}", delay},
+		{"{{weight}}", weight}};
 	placeWidgets(obs_module_text("AdvSceneSwitcher.randomTab.entry"),
 		     mainLayout, widgetPlaceholders);
 	setLayout(mainLayout);
@@ -214,3 +228,14 @@ void RandomSwitchWidget::DelayChanged(double d)
 	std::lock_guard<std::mutex> lock(switcher->m);
 	switchData->delay = d;
 }
+
+void RandomSwitchWidget::WeightChanged(double w)
+{
+	if (loading || !switchData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switchData->weight = w;
+	switcher->randomSelectionChanged = true;
+}
@@ -1,6 +1,8 @@
 #include "headers/advanced-scene-switcher.hpp"
 #include "headers/utility.hpp"
 
+#include <algorithm>
+
 bool TimeSwitch::pause = false;
 static QMetaObject::Connection addPulse;
 
@@ -8,6 +10,7 @@ void AdvSceneSwitcher::on_timeAdd_clicked()
 {
 	std::lock_guard<std::mutex> lock(switcher->m);
 	switcher->timeSwitches.emplace_back();
+	switcher->timeScheduleChanged = true;
 
 	listAddClicked(ui->timeSwitches,
 		       new TimeSwitchWidget(this,
@@ -29,6 +32,7 @@ void AdvSceneSwitcher::on_timeRemove_clicked()
 		int idx = ui->timeSwitches->currentRow();
 		auto &switches = switcher->timeSwitches;
 		switches.erase(switches.begin() + idx);
+		switcher->timeScheduleChanged = true;
 	}
 
 	delete item;
@@ -51,6 +55,7 @@ void AdvSceneSwitcher::on_timeUp_clicked()
 
 	std::swap(switcher->timeSwitches[index],
 		  switcher->timeSwitches[index - 1]);
+	switcher->timeScheduleChanged = true;
 }
 
 void AdvSceneSwitcher::on_timeDown_clicked()
@@ -71,79 +76,121 @@ void AdvSceneSwitcher::on_timeDown_clicked()
 
 	std::swap(switcher->timeSwitches[index],
 		  switcher->timeSwitches[index + 1]);
+	switcher->timeScheduleChanged = true;
 }
 
-bool timesAreInInterval(QTime &time1, QTime &time2, int &interval)
+qint64 TimeSwitch::nextOccurrence(const QDateTime &after,
+				  const QDateTime &liveStart)
 {
-	if (time1.isNull() || time2.isNull()) {
-		return false;
+	switch (trigger) {
+	case LIVE: {
+		if (liveStart.isNull()) {
+			return -1;
+		}
+		QDateTime next = liveStart.addMSecs(time.msecsSinceStartOfDay());
+		return next > after ? next.toMSecsSinceEpoch() : -1;
+	}
+	case CRON: {
+		QDateTime next = cronSchedule.Next(after);
+		return next.isValid() ? next.toMSecsSinceEpoch() : -1;
+	}
+	default:
+		break;
 	}
 
-	bool ret = false;
-	QTime validSwitchTimeWindow = time1.addMSecs(interval);
-
-	ret = time1 <= time2 && time2 <= validSwitchTimeWindow;
-	// Check for overflow
-	if (!ret && validSwitchTimeWindow.msecsSinceStartOfDay() < interval) {
-		ret = time2 >= time1 || time2 <= validSwitchTimeWindow;
+	for (int i = 0; i <= 7; i++) {
+		QDate date = after.date().addDays(i);
+		if (trigger != ANY_DAY && trigger != date.dayOfWeek()) {
+			continue;
+		}
+		QDateTime next(date, time);
+		if (next > after) {
+			return next.toMSecsSinceEpoch();
+		}
 	}
-	return ret;
+	return -1;
 }
 
-bool checkLiveTime(TimeSwitch &s, QDateTime &start, int &interval)
+void TimeSwitch::setCron(const std::string &expression)
 {
-	if (start.isNull()) {
-		return false;
+	cron = expression;
+	if (!cronSchedule.Parse(cron) && trigger == CRON) {
+		blog(LOG_WARNING, "invalid cron expression \"%s\"",
+		     cron.c_str());
 	}
-
-	QDateTime now = QDateTime::currentDateTime();
-	QTime timePassed = QTime(0, 0).addMSecs(start.msecsTo(now));
-
-	return timesAreInInterval(s.time, timePassed, interval);
 }
 
-bool checkRegularTime(TimeSwitch &s, int &interval)
+void SwitcherData::updateTimeSchedule(const QDateTime &now)
 {
-	if (s.trigger != ANY_DAY &&
-	    s.trigger != QDate::currentDate().dayOfWeek())
-		return false;
-
-	QTime now = QTime::currentTime();
-
-	return timesAreInInterval(s.time, now, interval);
+	timeScheduleChanged = false;
+	timeSchedule.Clear();
+	for (size_t i = 0; i < timeSwitches.size(); i++) {
+		auto &s = timeSwitches[i];
+		qint64 next = s.nextOccurrence(now.addMSecs(-1), liveTime);
+		if (next >= 0) {
+			timeSchedule.Add(i, next);
+		}
+	}
 }
 
 bool SwitcherData::checkTimeSwitch(OBSWeakSource &scene,
 				   OBSWeakSource &transition)
 {
 	if (TimeSwitch::pause) {
+		// Do not catch up on time points passed while paused
+		timeScheduleChanged = true;
 		return false;
 	}
 
-	bool match = false;
-	for (TimeSwitch &s : timeSwitches) {
+	QDateTime now = QDateTime::currentDateTime();
+	if (timeScheduleChanged) {
+		updateTimeSchedule(now);
+	}
+
+	// Time points which were missed by more than one interval, for example
+	// due to switching methods with a higher priority, are skipped
+	const qint64 nowMs = now.toMSecsSinceEpoch();
+	const qint64 maxDelay = std::max(interval, 1000);
+
+	TimeSwitch *match = nullptr;
+	size_t matchIdx = 0;
+	size_t idx;
+	qint64 time;
+	while (timeSchedule.PopDue(nowMs, idx, time)) {
+		auto &s = timeSwitches[idx];
+		qint64 next = s.nextOccurrence(now, liveTime);
+		if (next >= 0) {
+			timeSchedule.Add(idx, next);
+		}
 		if (!s.initialized()) {
 			continue;
 		}
-
-		if (s.trigger == LIVE) {
-			match = checkLiveTime(s, liveTime, interval);
-		} else {
-			match = checkRegularTime(s, interval);
+		if (nowMs - time > maxDelay) {
+			vblog(LOG_INFO, "skipping missed time switch");
+			continue;
+		}
+		if (!match || idx < matchIdx) {
+			match = &s;
+			matchIdx = idx;
 		}
+	}
 
-		if (match) {
-			scene = s.getScene();
-			transition = s.transition;
-			match = true;
+	qint64 nextTime = timeSchedule.NextTime();
+	if (nextTime >= 0) {
+		addDeadline(std::chrono::high_resolution_clock::now() +
+			    std::chrono::milliseconds(nextTime - nowMs));
+	}
 
-			if (verbose) {
-				s.logMatch();
-			}
-			break;
-		}
+	if (!match) {
+		return false;
 	}
-	return match;
+
+	scene = match->getScene();
+	transition = match->transition;
+	if (verbose) {
+		match->logMatch();
+	}
+	return true;
 }
 
 void SwitcherData::saveTimeSwitches(obs_data_t *obj)
@@ -164,6 +211,7 @@ void SwitcherData::saveTimeSwitches(obs_data_t *obj)
 void SwitcherData::loadTimeSwitches(obs_data_t *obj)
 {
 	timeSwitches.clear();
+	timeScheduleChanged = true;
 
 	obs_data_array_t *timeArray = obs_data_get_array(obj, "timeSwitches");
 	size_t count = obs_data_array_count(timeArray);
@@ -206,6 +254,7 @@ void TimeSwitch::save(obs_data_t *obj)
 
 	obs_data_set_int(obj, "trigger", trigger);
 	obs_data_set_string(obj, "time", time.toString().toStdString().c_str());
+	obs_data_set_string(obj, "cron", cron.c_str());
 }
 
 void TimeSwitch::load(obs_data_t *obj)
@@ -214,6 +263,7 @@ void TimeSwitch::load(obs_data_t *obj)
 
 	trigger = (timeTrigger)obs_data_get_int(obj, "trigger");
 	time = QTime::fromString(obs_data_get_string(obj, "time"));
+	setCron(obs_data_get_string(obj, "cron"));
 }
 
 static inline void populateTriggers(QComboBox *list)
@@ -228,9 +278,13 @@ static inline void populateTriggers(QComboBox *list)
 	list->addItem(obs_module_text("AdvSceneSwitcher.timeTab.sundays"));
 	list->addItem(obs_module_text("AdvSceneSwitcher.timeTab.afterstart"));
 
+	list->addItem(obs_module_text("AdvSceneSwitcher.timeTab.cron"));
+
 	list->setItemData(
 		8, obs_module_text("AdvSceneSwitcher.timeTab.afterstart.tip"),
 		Qt::ToolTipRole);
+	list->setItemData(9, obs_module_text("AdvSceneSwitcher.timeTab.cron.tip"),
+			  Qt::ToolTipRole);
 }
 
 TimeSwitchWidget::TimeSwitchWidget(QWidget *parent, TimeSwitch *s)
@@ -238,11 +292,15 @@ TimeSwitchWidget::TimeSwitchWidget(QWidget *parent, TimeSwitch *s)
 {
 	triggers = new QComboBox();
 	time = new QTimeEdit();
+	cron = new QLineEdit();
+	cron->setPlaceholderText("*/15 9-17 * * 1-5");
 
 	QWidget::connect(triggers, SIGNAL(currentIndexChanged(int)), this,
 			 SLOT(TriggerChanged(int)));
 	QWidget::connect(time, SIGNAL(timeChanged(const QTime &)), this,
 			 SLOT(TimeChanged(const QTime &)));
+	QWidget::connect(cron, SIGNAL(editingFinished()), this,
+			 SLOT(CronChanged()));
 
 	populateTriggers(triggers);
 	time->setDisplayFormat("HH:mm:ss");
@@ -250,12 +308,15 @@ TimeSwitchWidget::TimeSwitchWidget(QWidget *parent, TimeSwitch *s)
 	if (s) {
 		triggers->setCurrentIndex(s->trigger);
 		time->setTime(s->time);
+		cron->setText(QString::fromStdString(s->cron));
 	}
+	updateVisibility();
 
 	QHBoxLayout *mainLayout = new QHBoxLayout;
 	std::unordered_map<std::string, QWidget *> widgetPlaceholders = {
 		{"{{triggers}}", triggers},
 		{"{{time}}", time},
+		{"{{cron}}", cron},
 		{"{{scenes}}", scenes},
 		{"{{transitions}}", transitions}};
 	placeWidgets(obs_module_text("AdvSceneSwitcher.timeTab.entry"),
@@ -293,8 +354,12 @@ void TimeSwitchWidget::TriggerChanged(int index)
 		return;
 	}
 
-	std::lock_guard<std::mutex> lock(switcher->m);
-	switchData->trigger = (timeTrigger)index;
+	{
+		std::lock_guard<std::mutex> lock(switcher->m);
+		switchData->trigger = (timeTrigger)index;
+		switcher->timeScheduleChanged = true;
+	}
+	updateVisibility();
 }
 
 void TimeSwitchWidget::TimeChanged(const QTime &time)
@@ -305,4 +370,23 @@ void TimeSwitchWidget::TimeChanged(const QTime &time)
 
 	std::lock_guard<std::mutex> lock(switcher->m);
 	switchData->time = time;
+	switcher->timeScheduleChanged = true;
+}
+
+void TimeSwitchWidget::CronChanged()
+{
+	if (loading || !switchData) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(switcher->m);
+	switchData->setCron(cron->text().toStdString());
+	switcher->timeScheduleChanged = true;
+}
+
+void TimeSwitchWidget::updateVisibility()
+{
+	bool isCron = triggers->currentIndex() == CRON;
+	time->setVisible(!isCron);
+	cron->setVisible(isCron);
 }
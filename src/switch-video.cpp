@@ -251,11 +251,9 @@ void VideoSwitch::load(obs_data_t *obj)
 	}
 }
 
-void VideoSwitch::getScreenshot()
+void VideoSwitch::resetFrameGrabber()
 {
-	auto source = obs_weak_source_get_source(videoSource);
-	screenshotData = std::make_unique<AdvSSScreenshotObj>(source);
-	obs_source_release(source);
+	frameReader.SetSource(videoSource);
 }
 
 bool VideoSwitch::loadImageFromFile()
@@ -278,66 +276,55 @@ bool VideoSwitch::checkMatch()
 		obs_source_release(vs);
 
 		if (!videoActive) {
-			screenshotData.reset(nullptr);
+			frameReader.Clear();
 			return false;
 		}
 	}
 
-	bool match = false;
-
-	if (screenshotData) {
-		if (screenshotData->done) {
-			bool conditionMatch = false;
-
-			switch (condition) {
-			case videoSwitchType::MATCH:
-				conditionMatch = screenshotData->image ==
-						 matchImage;
-				break;
-			case videoSwitchType::DIFFER:
-				conditionMatch = screenshotData->image !=
-						 matchImage;
-				break;
-			case videoSwitchType::HAS_NOT_CHANGED:
-				conditionMatch = screenshotData->image ==
-						 matchImage;
-				break;
-			case videoSwitchType::HAS_CHANGED:
-				conditionMatch = screenshotData->image !=
-						 matchImage;
-				break;
-			default:
-				break;
-			}
-
-			if (conditionMatch) {
-				currentMatchDuration +=
-					std::chrono::duration_cast<
-						std::chrono::milliseconds>(
-						screenshotData->time -
-						previousTime);
-			} else {
-				currentMatchDuration = {};
-			}
+	if (!frameReader.IsReading(videoSource)) {
+		resetFrameGrabber();
+	}
 
-			bool durationMatch = currentMatchDuration.count() >=
-					     duration * 1000;
+	auto frame = frameReader.ReadNewFrame();
+	if (!frame) {
+		return false;
+	}
 
-			if (conditionMatch && durationMatch) {
-				match = true;
-			}
+	bool conditionMatch = false;
+
+	switch (condition) {
+	case videoSwitchType::MATCH:
+		conditionMatch = frame->image == matchImage;
+		break;
+	case videoSwitchType::DIFFER:
+		conditionMatch = frame->image != matchImage;
+		break;
+	case videoSwitchType::HAS_NOT_CHANGED:
+		conditionMatch = frame->image == matchImage;
+		break;
+	case videoSwitchType::HAS_CHANGED:
+		conditionMatch = frame->image != matchImage;
+		break;
+	default:
+		break;
+	}
+
+	if (conditionMatch) {
+		currentMatchDuration +=
+			std::chrono::duration_cast<std::chrono::milliseconds>(
+				frame->time - previousTime);
+	} else {
+		currentMatchDuration = {};
+	}
 
-			if (!requiresFileInput(condition)) {
-				matchImage = std::move(screenshotData->image);
-			}
-			previousTime = std::move(screenshotData->time);
+	bool durationMatch = currentMatchDuration.count() >= duration * 1000;
 
-			screenshotData.reset(nullptr);
-		}
+	if (!requiresFileInput(condition)) {
+		matchImage = frame->image;
 	}
+	previousTime = frame->time;
 
-	getScreenshot();
-	return match;
+	return conditionMatch && durationMatch;
 }
 
 void swap(VideoSwitch &first, VideoSwitch &second)
@@ -1,49 +1,40 @@
 #include "headers/switcher-data-structs.hpp"
 #include "headers/utility.hpp"
 
-void SwitcherData::Prune()
+#include <algorithm>
+
+// Removes all invalid entries in a single pass
+template<typename T> static bool pruneEntries(std::deque<T> &entries)
 {
-	for (size_t i = 0; i < windowSwitches.size(); i++) {
-		WindowSwitch &s = windowSwitches[i];
-		if (!s.valid()) {
-			windowSwitches.erase(windowSwitches.begin() + i--);
-		}
+	auto it = std::remove_if(entries.begin(), entries.end(),
+				 [](T &s) { return !s.valid(); });
+	if (it == entries.end()) {
+		return false;
 	}
+	entries.erase(it, entries.end());
+	return true;
+}
+
+void SwitcherData::Prune()
+{
+	pruneRequested = false;
+
+	pruneEntries(windowSwitches);
 
 	if (nonMatchingScene && !WeakSourceValid(nonMatchingScene)) {
 		switchIfNotMatching = NO_SWITCH;
 		nonMatchingScene = nullptr;
 	}
 
-	for (size_t i = 0; i < randomSwitches.size(); i++) {
-		RandomSwitch &s = randomSwitches[i];
-		if (!s.valid()) {
-			randomSwitches.erase(randomSwitches.begin() + i--);
-		}
+	if (pruneEntries(randomSwitches)) {
+		randomSelectionChanged = true;
 	}
 
-	for (size_t i = 0; i < screenRegionSwitches.size(); i++) {
-		ScreenRegionSwitch &s = screenRegionSwitches[i];
-		if (!s.valid()) {
-			screenRegionSwitches.erase(
-				screenRegionSwitches.begin() + i--);
-		}
-	}
-
-	for (size_t i = 0; i < pauseEntries.size(); i++) {
-		PauseEntry &s = pauseEntries[i];
-		if (!s.valid()) {
-			pauseEntries.erase(pauseEntries.begin() + i--);
-		}
-	}
-
-	for (size_t i = 0; i < sceneSequenceSwitches.size(); i++) {
-		SceneSequenceSwitch &s = sceneSequenceSwitches[i];
-		if (!s.valid()) {
-			sceneSequenceSwitches.erase(
-				sceneSequenceSwitches.begin() + i--);
-		}
+	pruneEntries(screenRegionSwitches);
+	pruneEntries(pauseEntries);
+	pruneEntries(sceneSequenceSwitches);
 
+	for (auto &s : sceneSequenceSwitches) {
 		auto cur = &s;
 		while (cur != nullptr) {
 			if (cur->extendedSequence &&
@@ -55,66 +46,28 @@ void SwitcherData::Prune()
 		}
 	}
 
-	for (size_t i = 0; i < sceneTransitions.size(); i++) {
-		SceneTransition &s = sceneTransitions[i];
-		if (!s.valid()) {
-			sceneTransitions.erase(sceneTransitions.begin() + i--);
-		}
-	}
-
-	for (size_t i = 0; i < defaultSceneTransitions.size(); i++) {
-		DefaultSceneTransition &s = defaultSceneTransitions[i];
-		if (!s.valid()) {
-			defaultSceneTransitions.erase(
-				defaultSceneTransitions.begin() + i--);
-		}
-	}
+	pruneEntries(sceneTransitions);
+	pruneEntries(defaultSceneTransitions);
+	pruneEntries(executableSwitches);
+	pruneEntries(fileSwitches);
 
-	for (size_t i = 0; i < executableSwitches.size(); i++) {
-		ExecutableSwitch &s = executableSwitches[i];
-		if (!s.valid()) {
-			executableSwitches.erase(executableSwitches.begin() +
-						 i--);
-		}
-	}
-
-	for (size_t i = 0; i < fileSwitches.size(); i++) {
-		FileSwitch &s = fileSwitches[i];
-		if (!s.valid()) {
-			fileSwitches.erase(fileSwitches.begin() + i--);
-		}
-	}
-
-	for (size_t i = 0; i < timeSwitches.size(); i++) {
-		TimeSwitch &s = timeSwitches[i];
-		if (!s.valid()) {
-			timeSwitches.erase(timeSwitches.begin() + i--);
-		}
+	if (pruneEntries(timeSwitches)) {
+		timeScheduleChanged = true;
 	}
 
 	if (!idleData.valid()) {
 		idleData.idleEnable = false;
 	}
 
-	for (size_t i = 0; i < mediaSwitches.size(); i++) {
-		MediaSwitch &s = mediaSwitches[i];
-		if (!s.valid()) {
-			mediaSwitches.erase(mediaSwitches.begin() + i--);
-		}
-	}
-
-	for (size_t i = 0; i < audioSwitches.size(); i++) {
-		AudioSwitch &s = audioSwitches[i];
-		if (!s.valid()) {
-			audioSwitches.erase(audioSwitches.begin() + i--);
-		}
-	}
+	pruneEntries(mediaSwitches);
+	pruneEntries(audioSwitches);
 
 	for (auto &sg : sceneGroups) {
-		for (size_t i = 0; i < sg.scenes.size(); i++)
-			if (!WeakSourceValid(sg.scenes[i])) {
-				sg.scenes.erase(sg.scenes.begin() + i--);
-			}
+		auto it = std::remove_if(sg.scenes.begin(), sg.scenes.end(),
+					 [](const OBSWeakSource &scene) {
+						 return !WeakSourceValid(scene);
+					 });
+		sg.scenes.erase(it, sg.scenes.end());
 	}
 }
 
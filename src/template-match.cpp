@@ -0,0 +1,333 @@
+#include "headers/template-match.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Preferred edge length of the template after downscaling for the coarse
+// search
+constexpr int coarse_template_size = 8;
+// Small templates are still downscaled down to this edge length, as a full
+// resolution search of the whole frame is the most expensive case.
+// Only templates smaller than twice this size are searched at full
+// resolution, for which the correlation costs at most 49 operations per
+// position.
+constexpr int min_coarse_template_size = 4;
+constexpr size_t coarse_candidate_count = 4;
+// Coarse templates with few pixels produce less reliable scores, so more
+// candidates are refined for them
+constexpr int small_coarse_template_pixels = 64;
+constexpr size_t small_coarse_candidate_count = 16;
+constexpr double flat_epsilon = 1e-6;
+
+GrayImage ToGrayImage(const QImage &image, const QRect &region, int scale)
+{
+	GrayImage gray;
+	scale = std::max(scale, 1);
+	QRect r = region.intersected(image.rect());
+	if (r.isEmpty()) {
+		return gray;
+	}
+
+	QImage img = image;
+	if (img.format() != QImage::Format_RGBX8888 &&
+	    img.format() != QImage::Format_RGBA8888) {
+		img = img.convertToFormat(QImage::Format_RGBX8888);
+	}
+
+	gray.width = r.width() / scale;
+	gray.height = r.height() / scale;
+	gray.data.resize((size_t)gray.width * gray.height);
+	if (gray.data.empty()) {
+		return gray;
+	}
+
+	std::vector<uint32_t> rowSums(gray.width);
+	const uint32_t div = scale * scale * 256;
+
+	for (int oy = 0; oy < gray.height; oy++) {
+		std::fill(rowSums.begin(), rowSums.end(), 0);
+		for (int sy = 0; sy < scale; sy++) {
+			const uint8_t *line =
+				img.constScanLine(r.y() + oy * scale + sy) +
+				r.x() * 4;
+			for (int ox = 0; ox < gray.width; ox++) {
+				const uint8_t *px = line + ox * scale * 4;
+				uint32_t sum = 0;
+				for (int sx = 0; sx < scale; sx++, px += 4) {
+					// Rec. 601 luma (77, 150, 29) / 256
+					sum += 77 * px[0] + 150 * px[1] +
+					       29 * px[2];
+				}
+				rowSums[ox] += sum;
+			}
+		}
+		uint8_t *out = gray.data.data() + (size_t)oy * gray.width;
+		for (int ox = 0; ox < gray.width; ox++) {
+			out[ox] = (uint8_t)(rowSums[ox] / div);
+		}
+	}
+	return gray;
+}
+
+TemplateMatcher::Template TemplateMatcher::MakeTemplate(const GrayImage &image)
+{
+	Template tmpl;
+	tmpl.width = image.width;
+	tmpl.height = image.height;
+	if (image.data.empty()) {
+		return tmpl;
+	}
+
+	double sum = 0.;
+	for (auto v : image.data) {
+		sum += v;
+	}
+	tmpl.mean = sum / image.data.size();
+
+	double sqSum = 0.;
+	tmpl.data.resize(image.data.size());
+	for (size_t i = 0; i < image.data.size(); i++) {
+		float v = (float)(image.data[i] - tmpl.mean);
+		tmpl.data[i] = v;
+		sqSum += (double)v * v;
+	}
+	tmpl.norm = std::sqrt(sqSum);
+	return tmpl;
+}
+
+void TemplateMatcher::SetTemplate(const QImage &image)
+{
+	_full = {};
+	_coarse = {};
+	_scale = 1;
+	if (image.isNull()) {
+		return;
+	}
+
+	int size = std::min(image.width(), image.height());
+	_scale = std::max(1, size / coarse_template_size);
+	if (_scale == 1 && size >= 2 * min_coarse_template_size) {
+		_scale = 2;
+	}
+	_full = MakeTemplate(ToGrayImage(image, image.rect(), 1));
+	if (_scale == 1) {
+		return;
+	}
+	auto coarse = MakeTemplate(ToGrayImage(image, image.rect(), _scale));
+	_coarse.push_back(coarse);
+
+	// Coarse templates with few pixels only score high if the template
+	// happens to be aligned to the blocks of the downscaled frame, so add
+	// a template for each possible alignment starting at an offset
+	if (coarse.width * coarse.height >= small_coarse_template_pixels) {
+		return;
+	}
+	for (int dy = 0; dy < _scale; dy++) {
+		for (int dx = 0; dx < _scale; dx++) {
+			if (dx == 0 && dy == 0) {
+				continue;
+			}
+			QRect rect(dx, dy, image.width() - dx,
+				   image.height() - dy);
+			auto tmpl = MakeTemplate(
+				ToGrayImage(image, rect, _scale));
+			if (tmpl.data.empty()) {
+				continue;
+			}
+			tmpl.offsetX = dx;
+			tmpl.offsetY = dy;
+			_coarse.push_back(tmpl);
+		}
+	}
+}
+
+void TemplateMatcher::AddCandidate(std::vector<Candidate> &best,
+				   size_t maxCandidates, double score, int x,
+				   int y, int minDistance)
+{
+	if (best.size() == maxCandidates && score <= best.back().score) {
+		return;
+	}
+
+	// Neighbouring positions of a match usually score high as well, so
+	// only keep the best one of each cluster
+	for (auto &c : best) {
+		if (std::abs(c.x - x) < minDistance &&
+		    std::abs(c.y - y) < minDistance) {
+			if (score > c.score) {
+				c = {score, x, y};
+				std::sort(best.begin(), best.end(),
+					  [](const auto &a, const auto &b) {
+						  return a.score > b.score;
+					  });
+			}
+			return;
+		}
+	}
+
+	if (best.size() == maxCandidates) {
+		best.pop_back();
+	}
+	auto it = std::find_if(best.begin(), best.end(), [score](const auto &c) {
+		return c.score < score;
+	});
+	best.insert(it, {score, x, y});
+}
+
+TemplateMatcher::IntegralImage::IntegralImage(const GrayImage &image)
+	: stride(image.width + 1),
+	  sum((size_t)stride * (image.height + 1), 0),
+	  sqSum((size_t)stride * (image.height + 1), 0)
+{
+	for (int y = 0; y < image.height; y++) {
+		const uint8_t *line = image.Line(y);
+		uint64_t rowSum = 0;
+		uint64_t rowSqSum = 0;
+		for (int x = 0; x < image.width; x++) {
+			rowSum += line[x];
+			rowSqSum += (uint64_t)line[x] * line[x];
+			size_t idx = (size_t)(y + 1) * stride + x + 1;
+			sum[idx] = sum[idx - stride] + rowSum;
+			sqSum[idx] = sqSum[idx - stride] + rowSqSum;
+		}
+	}
+}
+
+void TemplateMatcher::Search(const GrayImage &image,
+			     const IntegralImage &integral,
+			     const Template &tmpl, int x0, int y0, int x1,
+			     int y1, std::vector<Candidate> &best,
+			     size_t maxCandidates)
+{
+	const int w = image.width;
+	const int h = image.height;
+	const int tw = tmpl.width;
+	const int th = tmpl.height;
+	if (tw > w || th > h || tmpl.data.empty()) {
+		return;
+	}
+	x1 = std::min(x1, w - tw);
+	y1 = std::min(y1, h - th);
+
+	const int iw = integral.stride;
+	const auto &sum = integral.sum;
+	const auto &sqSum = integral.sqSum;
+	const double n = (double)tw * th;
+	const bool flatTemplate = tmpl.norm < flat_epsilon;
+	const int minDistance = std::max(1, std::min(tw, th) / 2);
+
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			size_t a = (size_t)y * iw + x;
+			size_t b = a + tw;
+			size_t c = a + (size_t)th * iw;
+			size_t d = c + tw;
+			double s = (double)(sum[d] - sum[b] - sum[c] + sum[a]);
+			double ss = (double)(sqSum[d] - sqSum[b] - sqSum[c] +
+					     sqSum[a]);
+			double variance = ss - s * s / n;
+
+			double score = 0.;
+			if (variance < flat_epsilon || flatTemplate) {
+				// Correlation is undefined for flat areas so
+				// only compare brightness if both are flat
+				if (variance < flat_epsilon && flatTemplate) {
+					score = 1. - std::abs(s / n - tmpl.mean) /
+							     255.;
+				}
+			} else {
+				double cross = 0.;
+				const float *t = tmpl.data.data();
+				for (int ty = 0; ty < th; ty++) {
+					const uint8_t *line =
+						image.Line(y + ty) + x;
+					float rowCross = 0.f;
+					for (int tx = 0; tx < tw; tx++) {
+						rowCross += line[tx] * t[tx];
+					}
+					cross += rowCross;
+					t += tw;
+				}
+				score = cross / (std::sqrt(variance) * tmpl.norm);
+			}
+			AddCandidate(best, maxCandidates, score, x, y,
+				     minDistance);
+		}
+	}
+}
+
+double TemplateMatcher::Match(const QImage &frame, QRect region,
+			      QPoint *position) const
+{
+	if (!Valid() || frame.isNull()) {
+		return -1.;
+	}
+
+	if (region.isEmpty()) {
+		region = frame.rect();
+	}
+	region = region.intersected(frame.rect());
+	if (region.width() < _full.width || region.height() < _full.height) {
+		return -1.;
+	}
+
+	std::vector<Candidate> best;
+
+	if (_scale == 1 || _coarse.empty()) {
+		auto gray = ToGrayImage(frame, region, 1);
+		Search(gray, IntegralImage(gray), _full, 0, 0, gray.width,
+		       gray.height, best, 1);
+		if (best.empty()) {
+			return -1.;
+		}
+		if (position) {
+			*position = {region.x() + best[0].x,
+				     region.y() + best[0].y};
+		}
+		return best[0].score;
+	}
+
+	// Candidates found in the downscaled frame are converted to the
+	// estimated template position in full resolution pixels
+	std::vector<Candidate> candidates;
+	auto coarse = ToGrayImage(frame, region, _scale);
+	IntegralImage coarseIntegral(coarse);
+	for (const auto &tmpl : _coarse) {
+		size_t candidateCount =
+			tmpl.width * tmpl.height < small_coarse_template_pixels
+				? small_coarse_candidate_count
+				: coarse_candidate_count;
+		best.clear();
+		Search(coarse, coarseIntegral, tmpl, 0, 0, coarse.width,
+		       coarse.height, best, candidateCount);
+		for (const auto &c : best) {
+			candidates.push_back({c.score,
+					      c.x * _scale - tmpl.offsetX,
+					      c.y * _scale - tmpl.offsetY});
+		}
+	}
+
+	// Refine each candidate at full resolution within the area covered by
+	// its neighbouring coarse positions
+	double bestScore = -1.;
+	for (const auto &c : candidates) {
+		QRect area(region.x() + c.x - _scale, region.y() + c.y - _scale,
+			   _full.width + 2 * _scale, _full.height + 2 * _scale);
+		area = area.intersected(region);
+
+		best.clear();
+		auto gray = ToGrayImage(frame, area, 1);
+		Search(gray, IntegralImage(gray), _full, 0, 0, gray.width,
+		       gray.height, best, 1);
+		if (best.empty() || best[0].score <= bestScore) {
+			continue;
+		}
+		bestScore = best[0].score;
+		if (position) {
+			*position = {area.x() + best[0].x,
+				     area.y() + best[0].y};
+		}
+	}
+	return bestScore;
+}
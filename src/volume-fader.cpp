@@ -0,0 +1,144 @@
+#include "headers/volume-fader.hpp"
+
+#include <obs-module.h>
+#include <mutex>
+#include <map>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// Volume used instead of silence when interpolating in dB (-60dB)
+constexpr float min_fade_volume = 0.001f;
+
+struct VolumeFade {
+	OBSWeakSource source;
+	float from = 0.f;
+	float to = 0.f;
+	double duration = 0.;
+	double elapsed = 0.;
+	FadeCurve curve = FadeCurve::LINEAR;
+};
+
+static std::mutex fadeMtx;
+// Fades keyed by source with nullptr representing the master volume
+static std::map<obs_weak_source_t *, VolumeFade> fades;
+static bool tickActive = false;
+
+static float getVolume(obs_weak_source_t *source)
+{
+	if (!source) {
+		return obs_get_master_volume();
+	}
+	obs_source_t *s = obs_weak_source_get_source(source);
+	float volume = obs_source_get_volume(s);
+	obs_source_release(s);
+	return volume;
+}
+
+static void setVolume(obs_weak_source_t *source, float volume)
+{
+	if (!source) {
+		obs_set_master_volume(volume);
+		return;
+	}
+	obs_source_t *s = obs_weak_source_get_source(source);
+	obs_source_set_volume(s, volume);
+	obs_source_release(s);
+}
+
+static float interpolate(const VolumeFade &fade, double t)
+{
+	switch (fade.curve) {
+	case FadeCurve::LOGARITHMIC: {
+		float from = std::log10(std::max(fade.from, min_fade_volume));
+		float to = std::log10(std::max(fade.to, min_fade_volume));
+		return std::pow(10.f, from + (to - from) * (float)t);
+	}
+	case FadeCurve::S_CURVE:
+		t = t * t * (3. - 2. * t);
+		break;
+	default:
+		break;
+	}
+	return fade.from + (fade.to - fade.from) * (float)t;
+}
+
+static void fadeTick(void *, float seconds)
+{
+	std::vector<std::pair<OBSWeakSource, float>> volumes;
+	bool done = false;
+	{
+		std::lock_guard<std::mutex> lock(fadeMtx);
+		for (auto it = fades.begin(); it != fades.end();) {
+			auto &fade = it->second;
+			fade.elapsed += seconds;
+			if (fade.elapsed >= fade.duration) {
+				volumes.emplace_back(fade.source, fade.to);
+				it = fades.erase(it);
+				continue;
+			}
+			volumes.emplace_back(
+				fade.source,
+				interpolate(fade, fade.elapsed / fade.duration));
+			++it;
+		}
+		if (fades.empty()) {
+			tickActive = false;
+			done = true;
+		}
+	}
+
+	// The fades only hold weak references, so sources removed in the
+	// meantime are skipped by obs_weak_source_get_source()
+	for (const auto &v : volumes) {
+		setVolume(v.first, v.second);
+	}
+
+	if (done) {
+		obs_remove_tick_callback(fadeTick, nullptr);
+	}
+}
+
+void StartVolumeFade(obs_weak_source_t *source, float target, double seconds,
+		     FadeCurve curve)
+{
+	if (seconds <= 0.) {
+		StopVolumeFade(source);
+		setVolume(source, target);
+		return;
+	}
+
+	VolumeFade fade;
+	fade.source = source;
+	fade.from = getVolume(source);
+	fade.to = target;
+	fade.duration = seconds;
+	fade.curve = curve;
+
+	bool registerTick = false;
+	{
+		std::lock_guard<std::mutex> lock(fadeMtx);
+		fades[source] = fade;
+		registerTick = !tickActive;
+		tickActive = true;
+	}
+
+	// The tick callbacks are called while OBS holds its own lock, which
+	// is also required to add a callback, so never do so while holding
+	// fadeMtx
+	if (registerTick) {
+		obs_add_tick_callback(fadeTick, nullptr);
+	}
+}
+
+void StopVolumeFade(obs_weak_source_t *source)
+{
+	std::lock_guard<std::mutex> lock(fadeMtx);
+	fades.erase(source);
+}
+
+bool IsVolumeFading(obs_weak_source_t *source)
+{
+	std::lock_guard<std::mutex> lock(fadeMtx);
+	return fades.find(source) != fades.end();
+}
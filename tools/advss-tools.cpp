@@ -0,0 +1,202 @@
+#include "tools.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+#include "headers/utility.hpp"
+
+#include <QCoreApplication>
+#include <util/platform.h>
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+struct ToolCommand {
+	const char *name;
+	const char *usage;
+	int (*run)(const ToolArgs &);
+};
+
+static const ToolCommand commands[] = {
+	{"bench-template-match",
+	 "[--width 1920] [--height 1080] [--iterations 50]\n"
+	 "\tCPU time of the \"contains pattern\" video condition per check",
+	 benchTemplateMatch},
+	{"bench-audio-spectrum",
+	 "[--seconds 10]\n"
+	 "\tCPU time of the spectrum analysis per analyzed audio source",
+	 benchAudioSpectrum},
+	{"bench-startup",
+	 "[--macros 100,500,2000,5000] [--iterations 5]\n"
+	 "\tTime needed to load generated macro configurations",
+	 benchStartup},
+	{"loadtest-server",
+	 "[--clients 100] [--messages 200] [--stalled 0] [--burst 2000]\n"
+	 "\t[--port 55600]\n"
+	 "\tBroadcast latency of the network server to many local clients,\n"
+	 "\toptionally with clients which stop reading",
+	 loadtestServer},
+	{"test-clock-sync",
+	 "[--followers 3] [--switches 20] [--delay 200] [--tolerance-us 8333]\n"
+	 "\t[--port 55610] [--no-sync]\n"
+	 "\tStarts a server and several client instances on this machine and\n"
+	 "\tcompares the times at which each instance performs the switches",
+	 testClockSync},
+	{"test-multicast",
+	 "[--address 239.255.43.21] [--port 55620] [--messages 100]\n"
+	 "\tSends scene changes via multicast on this machine and checks\n"
+	 "\tdelivery, de-duplication and that received changes are not echoed\n"
+	 "\tby another instance",
+	 testMulticast},
+};
+
+ToolArgs::ToolArgs(int argc, char **argv)
+{
+	for (int i = 0; i < argc; i++) {
+		if (strncmp(argv[i], "--", 2) != 0) {
+			continue;
+		}
+		std::string name = argv[i] + 2;
+		if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+			_values[name] = argv[++i];
+		} else {
+			_values[name] = "1";
+		}
+	}
+}
+
+bool ToolArgs::Has(const std::string &name) const
+{
+	return _values.find(name) != _values.end();
+}
+
+std::string ToolArgs::Get(const std::string &name, const std::string &def) const
+{
+	auto it = _values.find(name);
+	return it == _values.end() ? def : it->second;
+}
+
+int ToolArgs::GetInt(const std::string &name, int def) const
+{
+	auto it = _values.find(name);
+	return it == _values.end() ? def : atoi(it->second.c_str());
+}
+
+HeadlessSwitcher::HeadlessSwitcher()
+{
+	_started = obs_startup("en-US", nullptr, nullptr);
+	if (_started) {
+		switcher = new SwitcherData;
+	}
+}
+
+HeadlessSwitcher::~HeadlessSwitcher()
+{
+	if (!_started) {
+		return;
+	}
+	delete switcher;
+	switcher = nullptr;
+	for (auto scene : _scenes) {
+		obs_scene_release(scene);
+	}
+	obs_shutdown();
+}
+
+OBSWeakSource HeadlessSwitcher::CreateScene(const std::string &name)
+{
+	_scenes.push_back(obs_scene_create(name.c_str()));
+	return GetWeakSourceByName(name.c_str());
+}
+
+void SwitchRecorder::Record(const SceneSwitchRequest &request)
+{
+	uint64_t now = os_gettime_ns();
+	std::lock_guard<std::mutex> lock(_mtx);
+	_switches.push_back({now, GetWeakSourceName(request.scene)});
+	_cv.notify_all();
+}
+
+bool SwitchRecorder::WaitFor(size_t count, std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+	return _cv.wait_for(lock, timeout,
+			    [&]() { return _switches.size() >= count; });
+}
+
+std::vector<SwitchRecorder::Switch> SwitchRecorder::Switches()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _switches;
+}
+
+bool TCPPortAvailable(uint16_t port)
+{
+	asio::io_context io;
+	asio::ip::tcp::acceptor acceptor(io);
+	asio::error_code ec;
+	acceptor.open(asio::ip::tcp::v4(), ec);
+	acceptor.bind({asio::ip::tcp::v4(), port}, ec);
+	return !ec;
+}
+
+static double percentile(const std::vector<double> &sorted, double p)
+{
+	size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+void PrintSummary(const std::string &label, std::vector<double> values,
+		  const char *unit)
+{
+	if (values.empty()) {
+		printf("%-40s no samples\n", label.c_str());
+		return;
+	}
+	std::sort(values.begin(), values.end());
+	double mean = std::accumulate(values.begin(), values.end(), 0.) /
+		      values.size();
+	printf("%-40s mean %8.3f  p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f %s\n",
+	       label.c_str(), mean, percentile(values, 0.5),
+	       percentile(values, 0.95), percentile(values, 0.99),
+	       values.back(), unit);
+	fflush(stdout);
+}
+
+static void printUsage()
+{
+	printf("usage: advss-tools <command> [options]\n\ncommands:\n");
+	for (const auto &c : commands) {
+		printf("  %s %s\n\n", c.name, c.usage);
+	}
+}
+
+// Keeps stdout free for the results, which some tests parse from the output
+// of other instances
+static void logHandler(int level, const char *format, va_list args, void *)
+{
+	if (level > LOG_WARNING) {
+		return;
+	}
+	vfprintf(stderr, format, args);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+	QCoreApplication app(argc, argv);
+	base_set_log_handler(logHandler, nullptr);
+
+	if (argc < 2) {
+		printUsage();
+		return 1;
+	}
+	for (const auto &c : commands) {
+		if (strcmp(argv[1], c.name) == 0) {
+			return c.run(ToolArgs(argc - 2, argv + 2));
+		}
+	}
+	fprintf(stderr, "unknown command '%s'\n\n", argv[1]);
+	printUsage();
+	return 1;
+}
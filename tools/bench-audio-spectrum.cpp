@@ -0,0 +1,93 @@
+#include "tools.hpp"
+#include "headers/audio-spectrum.hpp"
+
+#include <util/platform.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+
+constexpr double pi = 3.14159265358979323846;
+constexpr double sample_rate = 48000.;
+constexpr size_t channels = 2;
+// Frames per packet passed to the audio capture callbacks by libobs
+constexpr uint32_t packet_frames = AUDIO_OUTPUT_FRAMES;
+
+// A few harmonics of a voice like fundamental on top of some noise
+static std::vector<float> generateAudio(size_t frames)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+	std::vector<float> audio(frames);
+	for (size_t i = 0; i < frames; i++) {
+		double t = i / sample_rate;
+		double v = 0.;
+		for (int h = 1; h <= 8; h++) {
+			v += 0.3 / h * std::sin(2. * pi * 180. * h * t);
+		}
+		audio[i] = (float)v + noise(rng);
+	}
+	return audio;
+}
+
+static void benchmark(size_t sources, const std::vector<float> &audio)
+{
+	std::vector<std::unique_ptr<AudioSpectrumAnalyzer>> analyzers;
+	for (size_t i = 0; i < sources; i++) {
+		analyzers.emplace_back(std::make_unique<AudioSpectrumAnalyzer>(
+			channels, sample_rate));
+	}
+
+	std::vector<double> packetTimes;
+	uint64_t total = 0;
+	const size_t packets = audio.size() / packet_frames;
+	for (size_t p = 0; p < packets; p++) {
+		audio_data data = {};
+		const float *samples = audio.data() + p * packet_frames;
+		for (size_t c = 0; c < channels; c++) {
+			data.data[c] = (uint8_t *)samples;
+		}
+		data.frames = packet_frames;
+
+		// Each source receives its packets from the audio thread
+		// independently, so time them one by one
+		for (auto &analyzer : analyzers) {
+			uint64_t start = os_gettime_ns();
+			analyzer->Process(&data, 1.f);
+			uint64_t duration = os_gettime_ns() - start;
+			packetTimes.push_back(duration / 1000.);
+			total += duration;
+		}
+	}
+
+	// Readers query the results from the switcher thread
+	uint64_t start = os_gettime_ns();
+	float level = 0.f;
+	float voice = 0.f;
+	for (auto &analyzer : analyzers) {
+		level = analyzer->BandLevel(300., 3400.);
+		voice = analyzer->VoiceActivity();
+	}
+	double readTime = (os_gettime_ns() - start) / 1000. / sources;
+
+	double audioSeconds = packets * packet_frames / sample_rate;
+	double cpu = total / 1e9 / (audioSeconds * sources) * 100.;
+	printf("%zu sources: %.3f%% of one core per source, reading the "
+	       "results takes %.2f us per source (level %.1f dB, voice %.2f)\n",
+	       sources, cpu, readTime, level, voice);
+	PrintSummary("  time per packet and source", packetTimes, "us");
+}
+
+int benchAudioSpectrum(const ToolArgs &args)
+{
+	int seconds = std::max(args.GetInt("seconds", 10), 1);
+	auto audio = generateAudio((size_t)(seconds * sample_rate));
+
+	printf("%d s of %zu channel audio at %.0f Hz in packets of %u frames\n",
+	       seconds, channels, sample_rate, packet_frames);
+	for (size_t sources : {1, 8, 32}) {
+		benchmark(sources, audio);
+	}
+	return 0;
+}
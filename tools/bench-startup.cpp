@@ -0,0 +1,140 @@
+#include "tools.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+#include "headers/macro-condition-edit.hpp"
+#include "headers/macro-condition-macro.hpp"
+#include "headers/macro-condition-scene.hpp"
+#include "headers/macro-action-edit.hpp"
+#include "headers/macro-action-scene-switch.hpp"
+#include "headers/utility.hpp"
+
+#include <util/platform.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+constexpr int scene_count = 20;
+constexpr int group_count = 10;
+
+static std::string sceneName(int i)
+{
+	return "bench scene " + std::to_string(i % scene_count);
+}
+
+// Each macro checks a scene, depends on the result of up to two earlier
+// macros, switches to another scene and waits.
+// Every fourth macro is part of a group.
+static void generateMacros(int count)
+{
+	auto &macros = switcher->macros;
+	macros.clear();
+	switcher->macroGroups.clear();
+	macros.resize(count);
+	for (int i = 0; i < count; i++) {
+		auto &m = macros[i];
+		m.SetName("Macro " + std::to_string(i));
+		if (i % 4 == 0) {
+			std::string group =
+				"Group " + std::to_string(i % group_count);
+			m.SetGroup(group);
+			switcher->macroGroups[group];
+		}
+
+		auto scene = std::dynamic_pointer_cast<MacroConditionScene>(
+			MacroConditionFactory::Create("scene"));
+		scene->_scene = GetWeakSourceByName(sceneName(i).c_str());
+		m.Conditions().emplace_back(scene);
+
+		auto sw = std::dynamic_pointer_cast<MacroActionSwitchScene>(
+			MacroActionFactory::Create("scene_switch"));
+		sw->scene = GetWeakSourceByName(sceneName(i + 1).c_str());
+		m.Actions().emplace_back(sw);
+		m.Actions().emplace_back(MacroActionFactory::Create("wait"));
+	}
+
+	// References can only be resolved once all macros exist
+	switcher->updateMacroIndex();
+	for (int i = 0; i < count; i++) {
+		for (int ref : {i / 2, i - 1}) {
+			if (ref < 0 || ref >= i) {
+				continue;
+			}
+			auto c = std::dynamic_pointer_cast<MacroConditionMacro>(
+				MacroConditionFactory::Create("macro"));
+			c->SetLogicType(LogicType::AND);
+			c->_macro.UpdateRef("Macro " + std::to_string(ref));
+			macros[i].Conditions().emplace_back(c);
+		}
+	}
+}
+
+static double elapsedMs(uint64_t start)
+{
+	return (os_gettime_ns() - start) / 1000000.;
+}
+
+static bool benchmark(int count, int iterations)
+{
+	generateMacros(count);
+	obs_data_t *config = obs_data_create();
+	uint64_t start = os_gettime_ns();
+	switcher->saveMacros(config);
+	double saveTime = elapsedMs(start);
+	const char *json = obs_data_get_json(config);
+	size_t jsonSize = json ? strlen(json) : 0;
+
+	std::vector<double> loadTimes;
+	std::vector<double> orderTimes;
+	std::vector<double> clearTimes;
+	for (int i = 0; i < iterations; i++) {
+		start = os_gettime_ns();
+		switcher->macros.clear();
+		clearTimes.push_back(elapsedMs(start));
+
+		start = os_gettime_ns();
+		switcher->loadMacros(config);
+		loadTimes.push_back(elapsedMs(start));
+
+		// Done by the switcher thread before the first check
+		start = os_gettime_ns();
+		switcher->updateMacroCheckOrder();
+		orderTimes.push_back(elapsedMs(start));
+	}
+	obs_data_release(config);
+
+	printf("%d macros (%zu KiB of settings), saving took %.1f ms\n",
+	       count, jsonSize / 1024, saveTime);
+	PrintSummary("  load", loadTimes);
+	PrintSummary("  order by dependencies", orderTimes);
+	PrintSummary("  remove", clearTimes);
+
+	if (switcher->macros.size() != (size_t)count) {
+		printf("  ERROR: loaded %zu macros\n", switcher->macros.size());
+		return false;
+	}
+	return true;
+}
+
+int benchStartup(const ToolArgs &args)
+{
+	HeadlessSwitcher obs;
+	if (!obs.Valid()) {
+		fprintf(stderr, "failed to start libobs\n");
+		return 1;
+	}
+	for (int i = 0; i < scene_count; i++) {
+		obs.CreateScene(sceneName(i));
+	}
+
+	int iterations = std::max(args.GetInt("iterations", 5), 1);
+	std::stringstream sizes(args.Get("macros", "100,500,2000,5000"));
+	std::string size;
+	bool ok = true;
+	while (std::getline(sizes, size, ',')) {
+		ok = benchmark(std::max(atoi(size.c_str()), 1), iterations) &&
+		     ok;
+	}
+	switcher->macros.clear();
+	return ok ? 0 : 1;
+}
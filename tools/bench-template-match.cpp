@@ -0,0 +1,139 @@
+#include "tools.hpp"
+#include "headers/template-match.hpp"
+
+#include <util/platform.h>
+#include <QImage>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+// Background made of random blocks at several scales with some per pixel
+// noise, so neither the coarse nor the full resolution search can trivially
+// discard positions
+static QImage generateFrame(int width, int height, std::mt19937 &rng)
+{
+	std::uniform_int_distribution<int> value(-40, 40);
+	std::uniform_int_distribution<int> noise(-8, 8);
+
+	QImage frame(width, height, QImage::Format_RGBX8888);
+	for (int y = 0; y < height; y++) {
+		memset(frame.scanLine(y), 128, (size_t)width * 4);
+	}
+	for (int block : {64, 16, 4}) {
+		int blocksX = (width + block - 1) / block;
+		int blocksY = (height + block - 1) / block;
+		std::vector<int> blocks((size_t)blocksX * blocksY * 3);
+		for (auto &b : blocks) {
+			b = value(rng);
+		}
+		for (int y = 0; y < height; y++) {
+			uint8_t *line = frame.scanLine(y);
+			for (int x = 0; x < width; x++) {
+				const int *b = &blocks[((size_t)(y / block) *
+								blocksX +
+							x / block) *
+						       3];
+				for (int c = 0; c < 3; c++) {
+					line[x * 4 + c] = (uint8_t)qBound(
+						0, line[x * 4 + c] + b[c], 255);
+				}
+			}
+		}
+	}
+	for (int y = 0; y < height; y++) {
+		uint8_t *line = frame.scanLine(y);
+		for (int x = 0; x < width * 4; x++) {
+			line[x] = (uint8_t)qBound(0, line[x] + noise(rng), 255);
+		}
+	}
+	return frame;
+}
+
+// High contrast pattern standing in for a logo
+static QImage generateLogo(int size, std::mt19937 &rng)
+{
+	std::uniform_int_distribution<int> color(0, 3);
+	const int cells = 4;
+	QImage logo(size, size, QImage::Format_RGBX8888);
+	std::vector<int> pattern(cells * cells);
+	for (auto &p : pattern) {
+		p = color(rng) * 85;
+	}
+	for (int y = 0; y < size; y++) {
+		uint8_t *line = logo.scanLine(y);
+		for (int x = 0; x < size; x++) {
+			int v = pattern[(y * cells / size) * cells +
+					x * cells / size];
+			line[x * 4] = (uint8_t)v;
+			line[x * 4 + 1] = (uint8_t)(255 - v);
+			line[x * 4 + 2] = (uint8_t)v;
+			line[x * 4 + 3] = 255;
+		}
+	}
+	return logo;
+}
+
+static void paste(QImage &frame, const QImage &image, const QPoint &pos)
+{
+	for (int y = 0; y < image.height(); y++) {
+		memcpy(frame.scanLine(pos.y() + y) + pos.x() * 4,
+		       image.constScanLine(y), (size_t)image.width() * 4);
+	}
+}
+
+static void benchmark(const TemplateMatcher &matcher, const QImage &frame,
+		      const QRect &region, const QPoint &expected,
+		      int iterations, const std::string &label)
+{
+	std::vector<double> times;
+	times.reserve(iterations);
+	int found = 0;
+	for (int i = 0; i < iterations; i++) {
+		QPoint pos;
+		uint64_t start = os_gettime_ns();
+		double score = matcher.Match(frame, region, &pos);
+		times.push_back((os_gettime_ns() - start) / 1000000.);
+		if (score > 0.99 && pos == expected) {
+			found++;
+		}
+	}
+	PrintSummary(label, times);
+	printf("%-40s found at the expected position %d/%d times\n", "",
+	       found, iterations);
+}
+
+int benchTemplateMatch(const ToolArgs &args)
+{
+	int width = args.GetInt("width", 1920);
+	int height = args.GetInt("height", 1080);
+	int iterations = std::max(args.GetInt("iterations", 50), 1);
+	std::mt19937 rng(1234);
+	QImage background = generateFrame(width, height, rng);
+
+	printf("frame %dx%d, %d matches per case\n", width, height,
+	       iterations);
+	for (int size : {8, 16, 24, 32, 64, 128}) {
+		if (size > width / 4 || size > height / 4) {
+			continue;
+		}
+		// Place the template in the lower right quarter like a logo
+		QPoint pos(width * 3 / 4 + (width / 4 - size) / 2,
+			   height * 3 / 4 + (height / 4 - size) / 2);
+		QImage logo = generateLogo(size, rng);
+		QImage frame = background.copy();
+		paste(frame, logo, pos);
+		TemplateMatcher matcher;
+		matcher.SetTemplate(logo);
+
+		std::string name = "template " + std::to_string(size) + "x" +
+				   std::to_string(size);
+		benchmark(matcher, frame, {}, pos, iterations,
+			  name + " full frame");
+		QRect quarter(width * 3 / 4, height * 3 / 4, width / 4,
+			      height / 4);
+		benchmark(matcher, frame, quarter, pos, iterations,
+			  name + " quarter region");
+	}
+	return 0;
+}
@@ -0,0 +1,334 @@
+#include "tools.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+
+#include <util/platform.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using websocketpp::lib::placeholders::_2;
+using websocketpp::lib::bind;
+
+constexpr int scene_count = 10;
+constexpr int client_threads = 4;
+constexpr auto receive_timeout = std::chrono::seconds(10);
+
+static std::string sceneName(int i)
+{
+	return "load test scene " + std::to_string(i % scene_count);
+}
+
+// Many websocket clients sharing one endpoint, which is run by a few threads
+class LoadTestClients {
+public:
+	LoadTestClients(int count);
+	~LoadTestClients();
+	bool Connect(const std::string &uri);
+	void Close();
+
+	// Waits until each client received at least count messages
+	bool WaitForMessages(size_t count);
+	// Latencies of all received messages relative to the given send times
+	std::vector<double> Latencies(const std::vector<uint64_t> &sendTimes);
+	// Time until the last client received each message
+	std::vector<double>
+	CompletionTimes(const std::vector<uint64_t> &sendTimes);
+	bool ReceivedFinalState(const std::string &scene, size_t &minReceived,
+				size_t &maxReceived);
+
+private:
+	struct Connection {
+		connection_hdl hdl;
+		bool open = false;
+		std::vector<uint64_t> receiveTimes;
+		std::string lastPayload;
+	};
+
+	void onOpen(Connection *c);
+	void onMessage(Connection *c, client::message_ptr message);
+
+	client _client;
+	std::vector<std::unique_ptr<Connection>> _connections;
+	std::vector<std::thread> _threads;
+	std::mutex _mtx;
+	std::condition_variable _cv;
+};
+
+LoadTestClients::LoadTestClients(int count)
+{
+	_client.clear_access_channels(websocketpp::log::alevel::all);
+	_client.clear_error_channels(websocketpp::log::elevel::all);
+	_client.init_asio();
+	_client.start_perpetual();
+	for (int i = 0; i < count; i++) {
+		_connections.emplace_back(std::make_unique<Connection>());
+	}
+	for (int i = 0; i < client_threads; i++) {
+		_threads.emplace_back([this]() { _client.run(); });
+	}
+}
+
+LoadTestClients::~LoadTestClients()
+{
+	Close();
+	_client.stop_perpetual();
+	for (auto &t : _threads) {
+		t.join();
+	}
+}
+
+bool LoadTestClients::Connect(const std::string &uri)
+{
+	for (auto &c : _connections) {
+		websocketpp::lib::error_code ec;
+		auto con = _client.get_connection(uri, ec);
+		if (ec) {
+			fprintf(stderr, "connect failed: %s\n",
+				ec.message().c_str());
+			return false;
+		}
+		con->set_open_handler(
+			bind(&LoadTestClients::onOpen, this, c.get()));
+		con->set_message_handler(
+			bind(&LoadTestClients::onMessage, this, c.get(), ::_2));
+		c->hdl = con;
+		_client.connect(con);
+	}
+
+	std::unique_lock<std::mutex> lock(_mtx);
+	return _cv.wait_for(lock, receive_timeout, [this]() {
+		return std::all_of(_connections.begin(), _connections.end(),
+				   [](const auto &c) { return c->open; });
+	});
+}
+
+void LoadTestClients::Close()
+{
+	for (auto &c : _connections) {
+		websocketpp::lib::error_code ec;
+		_client.close(c->hdl, websocketpp::close::status::normal, "",
+			      ec);
+	}
+}
+
+void LoadTestClients::onOpen(Connection *c)
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	c->open = true;
+	_cv.notify_all();
+}
+
+void LoadTestClients::onMessage(Connection *c, client::message_ptr message)
+{
+	uint64_t now = os_gettime_ns();
+	std::lock_guard<std::mutex> lock(_mtx);
+	c->receiveTimes.push_back(now);
+	c->lastPayload = message->get_payload();
+	_cv.notify_all();
+}
+
+bool LoadTestClients::WaitForMessages(size_t count)
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+	return _cv.wait_for(lock, receive_timeout, [&]() {
+		return std::all_of(_connections.begin(), _connections.end(),
+				   [count](const auto &c) {
+					   return c->receiveTimes.size() >=
+						  count;
+				   });
+	});
+}
+
+std::vector<double>
+LoadTestClients::Latencies(const std::vector<uint64_t> &sendTimes)
+{
+	std::vector<double> latencies;
+	std::lock_guard<std::mutex> lock(_mtx);
+	for (const auto &c : _connections) {
+		size_t count =
+			std::min(c->receiveTimes.size(), sendTimes.size());
+		for (size_t i = 0; i < count; i++) {
+			latencies.push_back(
+				(c->receiveTimes[i] - sendTimes[i]) / 1000000.);
+		}
+	}
+	return latencies;
+}
+
+std::vector<double>
+LoadTestClients::CompletionTimes(const std::vector<uint64_t> &sendTimes)
+{
+	std::vector<double> times(sendTimes.size(), 0.);
+	std::lock_guard<std::mutex> lock(_mtx);
+	for (const auto &c : _connections) {
+		size_t count =
+			std::min(c->receiveTimes.size(), sendTimes.size());
+		for (size_t i = 0; i < count; i++) {
+			double time =
+				(c->receiveTimes[i] - sendTimes[i]) / 1000000.;
+			times[i] = std::max(times[i], time);
+		}
+	}
+	return times;
+}
+
+bool LoadTestClients::ReceivedFinalState(const std::string &scene,
+					 size_t &minReceived,
+					 size_t &maxReceived)
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+	const std::string expected = "\"" + scene + "\"";
+	bool received = _cv.wait_for(lock, receive_timeout, [&]() {
+		return std::all_of(_connections.begin(), _connections.end(),
+				   [&expected](const auto &c) {
+					   return c->lastPayload.find(
+							  expected) !=
+						  std::string::npos;
+				   });
+	});
+	minReceived = SIZE_MAX;
+	maxReceived = 0;
+	for (const auto &c : _connections) {
+		minReceived = std::min(minReceived, c->receiveTimes.size());
+		maxReceived = std::max(maxReceived, c->receiveTimes.size());
+	}
+	return received;
+}
+
+// Completes the websocket handshake but never reads any of the messages
+// sent by the server afterwards
+class StalledClient {
+public:
+	bool Connect(uint16_t port);
+
+private:
+	asio::io_context _io;
+	asio::ip::tcp::socket _socket{_io};
+};
+
+bool StalledClient::Connect(uint16_t port)
+{
+	asio::error_code ec;
+	_socket.open(asio::ip::tcp::v4(), ec);
+	// A small receive buffer makes the send buffer on the server side fill
+	// up quickly
+	_socket.set_option(asio::socket_base::receive_buffer_size(4096), ec);
+	_socket.connect({asio::ip::make_address("127.0.0.1"), port}, ec);
+	if (ec) {
+		return false;
+	}
+
+	std::string request = "GET / HTTP/1.1\r\n"
+			      "Host: 127.0.0.1:" +
+			      std::to_string(port) +
+			      "\r\n"
+			      "Upgrade: websocket\r\n"
+			      "Connection: Upgrade\r\n"
+			      "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+			      "Sec-WebSocket-Version: 13\r\n\r\n";
+	asio::write(_socket, asio::buffer(request), ec);
+	asio::streambuf response;
+	asio::read_until(_socket, response, "\r\n\r\n", ec);
+	return !ec;
+}
+
+int loadtestServer(const ToolArgs &args)
+{
+	int clientCount = std::max(args.GetInt("clients", 100), 1);
+	int messages = std::max(args.GetInt("messages", 200), 1);
+	int stalledCount = std::max(args.GetInt("stalled", 0), 0);
+	int burst = std::max(args.GetInt("burst", 2000), 1);
+	uint16_t port = (uint16_t)args.GetInt("port", 55600);
+
+	HeadlessSwitcher obs;
+	if (!obs.Valid()) {
+		fprintf(stderr, "failed to start libobs\n");
+		return 1;
+	}
+	std::vector<OBSWeakSource> scenes;
+	for (int i = 0; i < scene_count; i++) {
+		scenes.push_back(obs.CreateScene(sceneName(i)));
+	}
+
+	if (!TCPPortAvailable(port)) {
+		fprintf(stderr, "port %d is not available\n", port);
+		return 1;
+	}
+	switcher->server.start(port, true);
+
+	int ret = 0;
+	{
+		std::vector<std::unique_ptr<StalledClient>> stalled;
+		for (int i = 0; i < stalledCount; i++) {
+			stalled.emplace_back(std::make_unique<StalledClient>());
+			if (!stalled.back()->Connect(port)) {
+				fprintf(stderr, "stalled client failed to "
+						"connect\n");
+				return 1;
+			}
+		}
+
+		LoadTestClients clients(clientCount);
+		if (!clients.Connect("ws://127.0.0.1:" +
+				     std::to_string(port))) {
+			fprintf(stderr, "clients failed to connect\n");
+			return 1;
+		}
+		// Make sure the server registered all connections
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+		printf("%d clients, %d stalled clients, %d messages\n",
+		       clientCount, stalledCount, messages);
+
+		// Send one message at a time and wait until every client
+		// received it
+		std::vector<uint64_t> sendTimes;
+		for (int i = 0; i < messages; i++) {
+			sendTimes.push_back(os_gettime_ns());
+			switcher->server.sendMessage({scenes[i % scene_count]});
+			if (!clients.WaitForMessages(sendTimes.size())) {
+				printf("ERROR: not all clients received "
+				       "message %d\n",
+				       i);
+				ret = 1;
+				break;
+			}
+		}
+		PrintSummary("  latency per client and message",
+			     clients.Latencies(sendTimes));
+		PrintSummary("  until all clients received a message",
+			     clients.CompletionTimes(sendTimes));
+
+		// Send a burst of messages without waiting, so connections
+		// fall behind and only receive the most recent state
+		uint64_t start = os_gettime_ns();
+		for (int i = 0; i < burst; i++) {
+			switcher->server.sendMessage({scenes[i % scene_count]});
+		}
+		uint64_t sent = os_gettime_ns();
+		size_t minReceived = 0;
+		size_t maxReceived = 0;
+		bool received = clients.ReceivedFinalState(
+			sceneName(burst - 1), minReceived, maxReceived);
+		printf("  burst of %d messages: sent in %.1f ms, final state "
+		       "%s after %.1f ms, each client received %zu to %zu "
+		       "of %zu messages in total\n",
+		       burst, (sent - start) / 1000000.,
+		       received ? "received" : "NOT received",
+		       (os_gettime_ns() - start) / 1000000., minReceived,
+		       maxReceived, sendTimes.size() + burst);
+		if (!received) {
+			ret = 1;
+		}
+
+		clients.Close();
+	}
+
+	switcher->server.stop();
+	return ret;
+}
@@ -0,0 +1,248 @@
+#include "tools.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+
+#include <QCoreApplication>
+#include <QProcess>
+#include <QStringList>
+#include <util/platform.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+constexpr int scene_count = 4;
+constexpr int connect_timeout = 10000;
+
+static std::string sceneName(int i)
+{
+	return "sync test scene " + std::to_string(i % scene_count);
+}
+
+// Runs as a separate process started by the leader and reports each switch
+// on stdout.
+// All instances run on the same machine and thus share the monotonic clock
+// used by os_gettime_ns(), so the leader can directly compare the reported
+// times with its own.
+static int follow(const ToolArgs &args)
+{
+	std::string uri = args.Get("follow");
+	int switches = std::max(args.GetInt("switches", 20), 1);
+	int delay = std::max(args.GetInt("delay", 200), 0);
+
+	HeadlessSwitcher obs;
+	if (!obs.Valid()) {
+		fprintf(stderr, "failed to start libobs\n");
+		return 1;
+	}
+	for (int i = 0; i < scene_count; i++) {
+		obs.CreateScene(sceneName(i));
+	}
+
+	SwitchRecorder recorder;
+	switcher->switchQueue.SetPerformer(
+		[&recorder](const SceneSwitchRequest &request) {
+			recorder.Record(request);
+			auto s = recorder.Switches().back();
+			printf("switched %" PRIu64 " %s\n", s.time,
+			       s.scene.c_str());
+			fflush(stdout);
+		});
+
+	switcher->client.connect(uri);
+	uint64_t deadline = os_gettime_ns() + connect_timeout * 1000000ull;
+	while (switcher->clientStatus != ClientStatus::CONNECTED) {
+		if (os_gettime_ns() > deadline) {
+			fprintf(stderr, "failed to connect to %s\n",
+				uri.c_str());
+			return 1;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	printf("connected\n");
+	fflush(stdout);
+
+	auto timeout = std::chrono::milliseconds(connect_timeout +
+						 switches * (delay + 500));
+	return recorder.WaitFor(switches, timeout) ? 0 : 1;
+}
+
+static bool readLine(QProcess &process, std::string &line, int timeout)
+{
+	uint64_t deadline = os_gettime_ns() + timeout * 1000000ull;
+	while (!process.canReadLine()) {
+		int64_t remaining =
+			((int64_t)deadline - (int64_t)os_gettime_ns()) /
+			1000000;
+		if (remaining <= 0 || !process.waitForReadyRead(remaining)) {
+			return false;
+		}
+	}
+	line = process.readLine().trimmed().toStdString();
+	return true;
+}
+
+static bool parseSwitch(const std::string &line, SwitchRecorder::Switch &s)
+{
+	std::istringstream stream(line);
+	std::string prefix;
+	if (!(stream >> prefix >> s.time) || prefix != "switched") {
+		return false;
+	}
+	std::getline(stream >> std::ws, s.scene);
+	return true;
+}
+
+// Starts the server and several followers connecting to it, switches scenes
+// and compares the times at which each instance performed the switches
+int testClockSync(const ToolArgs &args)
+{
+	if (args.Has("follow")) {
+		return follow(args);
+	}
+
+	int followerCount = std::max(args.GetInt("followers", 3), 1);
+	int switches = std::max(args.GetInt("switches", 20), 1);
+	int delay = std::max(args.GetInt("delay", 200), 0);
+	// Half a frame at 60 FPS
+	double tolerance = args.GetInt("tolerance-us", 8333) / 1000.;
+	uint16_t port = (uint16_t)args.GetInt("port", 55610);
+	bool sync = !args.Has("no-sync");
+
+	HeadlessSwitcher obs;
+	if (!obs.Valid()) {
+		fprintf(stderr, "failed to start libobs\n");
+		return 1;
+	}
+	std::vector<OBSWeakSource> scenes;
+	for (int i = 0; i < scene_count; i++) {
+		scenes.push_back(obs.CreateScene(sceneName(i)));
+	}
+
+	// Without synchronization the switch is forwarded to the followers
+	// once it was performed, like performSceneSwitch() does
+	SwitchRecorder recorder;
+	switcher->switchQueue.SetPerformer(
+		[&recorder](const SceneSwitchRequest &request) {
+			recorder.Record(request);
+			if (request.forward) {
+				switcher->server.sendMessage(
+					{request.scene, request.transition,
+					 request.duration});
+			}
+		});
+
+	auto &config = switcher->networkConfig;
+	config.ServerEnabled = true;
+	config.SyncSwitch = sync;
+	config.SyncDelay = delay;
+	if (!TCPPortAvailable(port)) {
+		fprintf(stderr, "port %d is not available\n", port);
+		return 1;
+	}
+	switcher->server.start(port, true);
+
+	std::vector<std::unique_ptr<QProcess>> followers;
+	QStringList followerArgs = {
+		"test-clock-sync",
+		"--follow",
+		QString("ws://127.0.0.1:%1").arg(port),
+		"--switches",
+		QString::number(switches),
+		"--delay",
+		QString::number(delay),
+	};
+	for (int i = 0; i < followerCount; i++) {
+		auto process = std::make_unique<QProcess>();
+		process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+		process->start(QCoreApplication::applicationFilePath(),
+			       followerArgs);
+		followers.emplace_back(std::move(process));
+	}
+
+	int ret = 0;
+	for (auto &f : followers) {
+		std::string line;
+		if (!readLine(*f, line, connect_timeout) ||
+		    line != "connected") {
+			fprintf(stderr, "follower failed to connect\n");
+			ret = 1;
+		}
+	}
+
+	if (ret == 0) {
+		// Let the followers collect a few clock sync samples
+		std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+		printf("%d followers, %d switches, %s with %d ms delay\n",
+		       followerCount, switches,
+		       sync ? "synchronized" : "not synchronized", delay);
+
+		// Wait for each switch to be performed everywhere, as a new
+		// request would replace a pending one
+		for (int i = 0; i < switches; i++) {
+			switchScene({scenes[i % scene_count]});
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(delay + 100));
+		}
+	}
+
+	auto leaderSwitches = recorder.Switches();
+	std::vector<double> errors;
+	for (auto &f : followers) {
+		int received = 0;
+		std::string line;
+		while (ret == 0 && received < switches &&
+		       readLine(*f, line, connect_timeout)) {
+			SwitchRecorder::Switch s;
+			if (!parseSwitch(line, s)) {
+				continue;
+			}
+			if ((size_t)received >= leaderSwitches.size() ||
+			    s.scene != leaderSwitches[received].scene) {
+				fprintf(stderr,
+					"follower switched to unexpected "
+					"scene '%s'\n",
+					s.scene.c_str());
+				ret = 1;
+				break;
+			}
+			double diff = (double)s.time -
+				      (double)leaderSwitches[received].time;
+			errors.push_back(diff / 1000000.);
+			received++;
+		}
+		if (received < switches) {
+			fprintf(stderr, "follower only switched %d times\n",
+				received);
+			ret = 1;
+		}
+		if (ret != 0 || !f->waitForFinished(connect_timeout)) {
+			f->kill();
+			f->waitForFinished();
+		}
+	}
+
+	if (!errors.empty()) {
+		std::vector<double> absErrors;
+		for (double e : errors) {
+			absErrors.push_back(std::abs(e));
+		}
+		PrintSummary("  follower switch time - leader switch time",
+			     errors);
+		PrintSummary("  absolute difference", absErrors);
+		double max = *std::max_element(absErrors.begin(),
+					       absErrors.end());
+		if (sync && max > tolerance) {
+			printf("FAILED: difference of %.3f ms exceeds %.3f "
+			       "ms\n",
+			       max, tolerance);
+			ret = 1;
+		}
+	}
+
+	switcher->server.stop();
+	return ret;
+}
@@ -0,0 +1,226 @@
+#include "tools.hpp"
+#include "headers/advanced-scene-switcher.hpp"
+
+#include <QCoreApplication>
+#include <QProcess>
+#include <QStringList>
+#include <util/platform.h>
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+constexpr int scene_count = 4;
+constexpr int receive_timeout = 5000;
+constexpr auto receive_wait = std::chrono::milliseconds(receive_timeout);
+// Longer than the interval in which senders repeat their last packets
+constexpr auto repeat_wait = std::chrono::milliseconds(1500);
+
+static std::string sceneName(int i)
+{
+	return "multicast test scene " + std::to_string(i % scene_count);
+}
+
+static bool joinGroup(const std::string &address, uint16_t port)
+{
+	auto &config = switcher->networkConfig;
+	config.MulticastEnabled = true;
+	config.MulticastSend = true;
+	config.MulticastReceive = true;
+	config.MulticastAddress = address;
+	config.MulticastPort = port;
+	switcher->startMulticast();
+	return switcher->multicastSender.IsRunning() &&
+	       switcher->multicastReceiver.IsRunning();
+}
+
+static bool check(const char *description, bool ok)
+{
+	printf("  %-50s %s\n", description, ok ? "ok" : "FAILED");
+	fflush(stdout);
+	return ok;
+}
+
+// Another instance sending and receiving scene changes, which reports the
+// switches it performed on stdout.
+// Like the frontend it reports each switch as a scene change, which must not
+// be sent back to the group.
+static int peer(const ToolArgs &args)
+{
+	HeadlessSwitcher obs;
+	if (!obs.Valid()) {
+		fprintf(stderr, "failed to start libobs\n");
+		return 1;
+	}
+	for (int i = 0; i < scene_count; i++) {
+		obs.CreateScene(sceneName(i));
+	}
+
+	SwitchRecorder recorder;
+	switcher->switchQueue.SetPerformer(
+		[&recorder](const SceneSwitchRequest &request) {
+			recorder.Record(request);
+			forwardFrontendSceneChange(request.scene,
+						   request.preview);
+			printf("switched %s\n",
+			       GetWeakSourceName(request.scene).c_str());
+			fflush(stdout);
+		});
+
+	if (!joinGroup(args.Get("address"), (uint16_t)args.GetInt("port", 0))) {
+		fprintf(stderr, "failed to start multicast\n");
+		return 1;
+	}
+	printf("ready\n");
+	fflush(stdout);
+
+	bool switched = recorder.WaitFor(1, receive_wait);
+	// Give a possible echo time to reach the other instance
+	std::this_thread::sleep_for(repeat_wait);
+	return switched ? 0 : 1;
+}
+
+static bool readLine(QProcess &process, const std::string &expected)
+{
+	while (process.canReadLine() ||
+	       process.waitForReadyRead(receive_timeout)) {
+		while (process.canReadLine()) {
+			if (process.readLine().trimmed().toStdString() ==
+			    expected) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Sends scene changes over the loopback interface and checks delivery,
+// de-duplication and that no instance acts on packets it should ignore
+int testMulticast(const ToolArgs &args)
+{
+	if (args.Has("peer")) {
+		return peer(args);
+	}
+
+	std::string address = args.Get("address", "239.255.43.21");
+	uint16_t port = (uint16_t)args.GetInt("port", 55620);
+	int messages = std::max(args.GetInt("messages", 100), 1);
+
+	HeadlessSwitcher obs;
+	if (!obs.Valid()) {
+		fprintf(stderr, "failed to start libobs\n");
+		return 1;
+	}
+	std::vector<OBSWeakSource> scenes;
+	for (int i = 0; i < scene_count; i++) {
+		scenes.push_back(obs.CreateScene(sceneName(i)));
+	}
+
+	SwitchRecorder recorder;
+	switcher->switchQueue.SetPerformer(
+		[&recorder](const SceneSwitchRequest &request) {
+			recorder.Record(request);
+		});
+	if (!joinGroup(address, port)) {
+		fprintf(stderr, "failed to start multicast on %s:%d\n",
+			address.c_str(), port);
+		return 1;
+	}
+
+	MulticastSender other;
+	if (!other.Start(address, port)) {
+		fprintf(stderr, "failed to start second sender\n");
+		return 1;
+	}
+
+	printf("%d scene changes via %s:%d\n", messages, address.c_str(),
+	       port);
+
+	bool ok = true;
+	std::vector<uint64_t> sendTimes;
+	for (int i = 0; i < messages; i++) {
+		sendTimes.push_back(os_gettime_ns());
+		other.Send({scenes[i % scene_count]});
+		if (!recorder.WaitFor(sendTimes.size(), receive_wait)) {
+			printf("  ERROR: scene change %d was not received\n",
+			       i);
+			ok = false;
+			break;
+		}
+	}
+	auto switches = recorder.Switches();
+	std::vector<double> latencies;
+	bool inOrder = true;
+	for (size_t i = 0; i < switches.size() && i < sendTimes.size(); i++) {
+		latencies.push_back((switches[i].time - sendTimes[i]) /
+				    1000000.);
+		inOrder = inOrder && switches[i].scene == sceneName((int)i);
+	}
+	PrintSummary("  send until performed", latencies);
+	ok = check("received scene changes in order", inOrder) && ok;
+
+	// Every packet is sent twice and the last one is repeated
+	std::this_thread::sleep_for(repeat_wait);
+	size_t performed = recorder.Switches().size();
+	ok = check("duplicates and repeats ignored",
+		   performed == sendTimes.size()) &&
+	     ok;
+
+	switcher->multicastSender.Send({scenes[1]});
+	std::this_thread::sleep_for(repeat_wait);
+	ok = check("own packets ignored",
+		   recorder.Switches().size() == performed) &&
+	     ok;
+
+	// The receiver does not know the other sender after the restart and
+	// must not switch to the scene repeated by it
+	switcher->multicastReceiver.Stop();
+	switcher->multicastReceiver.Start(address, port);
+	std::this_thread::sleep_for(repeat_wait);
+	ok = check("repeats of unknown senders ignored",
+		   recorder.Switches().size() == performed) &&
+	     ok;
+
+	other.Send({scenes[2]});
+	ok = check("switches after synchronizing with a sender",
+		   recorder.WaitFor(performed + 1, receive_wait)) &&
+	     ok;
+	bool lost = switcher->multicastReceiver.GetLost() > 0;
+	ok = check("no lost packets", !lost) && ok;
+	other.Stop();
+	performed = recorder.Switches().size();
+
+	// A scene change of this instance is performed by the peer, which
+	// must not send it back
+	QProcess process;
+	process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	process.start(QCoreApplication::applicationFilePath(),
+		      {"test-multicast", "--peer", "--address",
+		       QString::fromStdString(address), "--port",
+		       QString::number(port)});
+	if (!readLine(process, "ready")) {
+		fprintf(stderr, "peer failed to start\n");
+		process.kill();
+		process.waitForFinished();
+		return 1;
+	}
+	forwardFrontendSceneChange(scenes[3], false);
+	ok = check("peer performed the scene change",
+		   readLine(process, "switched " + sceneName(3))) &&
+	     ok;
+	bool finished = process.waitForFinished(receive_timeout);
+	if (!finished) {
+		process.kill();
+		process.waitForFinished();
+	}
+	ok = check("scene change not echoed by the peer",
+		   recorder.Switches().size() == performed) &&
+	     ok;
+	ok = check("peer finished",
+		   finished && process.exitStatus() == QProcess::NormalExit &&
+			   process.exitCode() == 0) &&
+	     ok;
+
+	switcher->multicastSender.Stop();
+	switcher->multicastReceiver.Stop();
+	return ok ? 0 : 1;
+}
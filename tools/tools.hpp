@@ -0,0 +1,75 @@
+#pragma once
+#include <obs.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct SceneSwitchRequest;
+
+// Options passed as "--name value" or as "--name" for flags
+class ToolArgs {
+public:
+	ToolArgs(int argc, char **argv);
+	bool Has(const std::string &name) const;
+	std::string Get(const std::string &name,
+			const std::string &def = "") const;
+	int GetInt(const std::string &name, int def) const;
+
+private:
+	std::map<std::string, std::string> _values;
+};
+
+// Starts libobs without the frontend and creates the global switcher data
+// used by the plugin
+class HeadlessSwitcher {
+public:
+	HeadlessSwitcher();
+	~HeadlessSwitcher();
+	bool Valid() const { return _started; }
+	// The scene is kept alive until this object is destroyed
+	OBSWeakSource CreateScene(const std::string &name);
+
+private:
+	bool _started = false;
+	std::vector<obs_scene_t *> _scenes;
+};
+
+// Installed as the performer of the switch queue to record when and to which
+// scene it switched
+class SwitchRecorder {
+public:
+	struct Switch {
+		uint64_t time;
+		std::string scene;
+	};
+
+	void Record(const SceneSwitchRequest &request);
+	// Returns false if less than count switches were recorded in time
+	bool WaitFor(size_t count, std::chrono::milliseconds timeout);
+	std::vector<Switch> Switches();
+
+private:
+	std::mutex _mtx;
+	std::condition_variable _cv;
+	std::vector<Switch> _switches;
+};
+
+// WSServer::start() reports errors using a message box, so tools make sure the
+// port can be used beforehand
+bool TCPPortAvailable(uint16_t port);
+
+// Prints mean, percentiles and maximum of the given values
+void PrintSummary(const std::string &label, std::vector<double> values,
+		  const char *unit = "ms");
+
+// Commands
+int benchTemplateMatch(const ToolArgs &args);
+int benchAudioSpectrum(const ToolArgs &args);
+int benchStartup(const ToolArgs &args);
+int loadtestServer(const ToolArgs &args);
+int testClockSync(const ToolArgs &args);
+int testMulticast(const ToolArgs &args);